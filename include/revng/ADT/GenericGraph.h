@@ -4,11 +4,13 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <memory>
 #include <type_traits>
 
 #include "llvm/ADT/GraphTraits.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Allocator.h"
 
 #include "revng/ADT/STLExtras.h"
 #include "revng/Support/Debug.h"
@@ -48,6 +50,11 @@
 ///  On the side-note, we're providing a couple of helpful concepts to help
 ///  differenciate different node types. This is helpful in the projects that
 ///  use multiple different graph architectures side by side.
+///
+///  By default, each node (and each edge label of a MutableEdgeNode) is a
+///  separate heap allocation. Graphs that are built once and then mostly
+///  visited can be constructed with `GraphAllocation::Arena` instead, see
+///  GenericGraph.
 
 template<typename T>
 concept SpecializationOfForwardNode = requires { T::is_forward_node; };
@@ -74,6 +81,55 @@ struct Empty {
   bool operator==(const Empty &) const { return true; }
 };
 
+/// How a GenericGraph allocates its nodes and the edge labels of its
+/// MutableEdgeNodes
+enum class GraphAllocation {
+  /// Each node and label is a separate heap allocation
+  Heap,
+
+  /// Nodes and labels are allocated in an arena owned by the graph.
+  /// Removed nodes and labels are destroyed immediately, but their memory is
+  /// only reclaimed when the graph is cleared or destroyed.
+  Arena
+};
+
+namespace revng::detail {
+
+/// Deleter for objects that might live in an arena, in which case they are
+/// destroyed without releasing their memory
+template<typename T>
+struct MaybeInArenaDeleter {
+  bool InArena = false;
+
+  MaybeInArenaDeleter() = default;
+  explicit MaybeInArenaDeleter(bool InArena) : InArena(InArena) {}
+  MaybeInArenaDeleter(std::default_delete<T>) {}
+
+  void operator()(T *Pointer) const {
+    if (InArena)
+      Pointer->~T();
+    else
+      delete Pointer;
+  }
+};
+
+template<typename T>
+using MaybeInArenaPointer = std::unique_ptr<T, MaybeInArenaDeleter<T>>;
+
+/// Construct a T in \p Arena or, if it's null, on the heap
+template<typename T, typename... ArgTypes>
+MaybeInArenaPointer<T>
+makeMaybeInArena(llvm::BumpPtrAllocator *Arena, ArgTypes &&...Args) {
+  if (Arena == nullptr)
+    return MaybeInArenaPointer<T>(new T(std::forward<ArgTypes>(Args)...));
+
+  void *Memory = Arena->Allocate(sizeof(T), alignof(T));
+  T *Result = new (Memory) T(std::forward<ArgTypes>(Args)...);
+  return MaybeInArenaPointer<T>(Result, MaybeInArenaDeleter<T>(true));
+}
+
+} // namespace revng::detail
+
 template<typename Node, size_t SmallSize = 16, bool HasEntryNode = true>
 class GenericGraph;
 
@@ -476,7 +532,7 @@ struct MutableEdgeNodeBaseTCalc {
 template<typename NodeType, typename LabelType>
 struct OwningEdge {
   NodeType *Neighbor;
-  std::unique_ptr<LabelType> Label;
+  MaybeInArenaPointer<LabelType> Label;
 };
 
 template<typename NodeType, typename LabelType>
@@ -1146,10 +1202,20 @@ public:
     return *this;
   }
 
+public:
+  /// Allocate the labels of the edges this node owns (i.e., the successor
+  /// ones) in \p Arena, or on the heap if it's null.
+  ///
+  /// This is set by GenericGraph when the node is added to it.
+  void setLabelArena(llvm::BumpPtrAllocator *Arena) { LabelArena = Arena; }
+
 protected:
   std::tuple<OwningEdge, NonOwningEdge>
   constructEdge(DerivedType *From, DerivedType *To, EdgeLabel &&EL) {
-    OwningEdge O{ To, std::make_unique<EdgeLabel>(std::move(EL)) };
+    using revng::detail::makeMaybeInArena;
+    llvm::BumpPtrAllocator *Arena = static_cast<MutableEdgeNode *>(From)
+                                      ->LabelArena;
+    OwningEdge O{ To, makeMaybeInArena<EdgeLabel>(Arena, std::move(EL)) };
     NonOwningEdge V{ From, O.Label.get() };
     return { std::move(O), std::move(V) };
   }
@@ -1157,6 +1223,7 @@ protected:
 private:
   EdgeOwnerContainer Successors;
   EdgeViewContainer Predecessors;
+  llvm::BumpPtrAllocator *LabelArena = nullptr;
 };
 
 /// Simple data structure to hold the EntryNode of a GenericGraph
@@ -1174,13 +1241,18 @@ public:
 ///
 /// This graph owns its nodes (but not the edges).
 /// It can optionally have an elected entry point.
+///
+/// The nodes are allocated as specified by the GraphAllocation passed to the
+/// constructor, in both cases their address is stable. Nodes added through a
+/// `std::unique_ptr` are always on the heap.
 template<typename NodeT, size_t SmallSize, bool HasEntryNode>
 class GenericGraph
   : public std::conditional_t<HasEntryNode, EntryNode<NodeT>, Empty> {
 public:
   // NOLINTNEXTLINE
   static const bool is_generic_graph = true;
-  using NodesContainer = llvm::SmallVector<std::unique_ptr<NodeT>, SmallSize>;
+  using NodePointer = revng::detail::MaybeInArenaPointer<NodeT>;
+  using NodesContainer = llvm::SmallVector<NodePointer, SmallSize>;
   using Node = NodeT;
   static constexpr bool hasEntryNode = HasEntryNode;
 
@@ -1189,11 +1261,22 @@ private:
   using const_nodes_iterator_impl = typename NodesContainer::const_iterator;
 
 public:
-  static NodeT *getNode(std::unique_ptr<NodeT> &E) { return E.get(); }
-  static const NodeT *getConstNode(const std::unique_ptr<NodeT> &E) {
-    return E.get();
+  GenericGraph() = default;
+  explicit GenericGraph(GraphAllocation Allocation) {
+    if (Allocation == GraphAllocation::Arena)
+      Arena = std::make_unique<llvm::BumpPtrAllocator>();
   }
 
+  GenericGraph(GenericGraph &&) = default;
+  GenericGraph &operator=(GenericGraph &&) = default;
+
+  // The nodes have to be destroyed before the arena they might live in
+  ~GenericGraph() { Nodes.clear(); }
+
+public:
+  static NodeT *getNode(NodePointer &E) { return E.get(); }
+  static const NodeT *getConstNode(const NodePointer &E) { return E.get(); }
+
   // TODO: these iterators will not work with llvm::filter_iterator,
   //       since the mapped type is not a reference
   using nodes_iterator = llvm::mapped_iterator<nodes_iterator_impl,
@@ -1234,6 +1317,7 @@ public:
 public:
   NodeT *addNode(std::unique_ptr<NodeT> &&Ptr) {
     Nodes.emplace_back(std::move(Ptr));
+    adopt(Nodes.back().get());
     if constexpr (NodeT::HasParent)
       Nodes.back()->setParent(this);
     return Nodes.back().get();
@@ -1241,7 +1325,8 @@ public:
 
   template<class... ArgTypes>
   NodeT *addNode(ArgTypes &&...A) {
-    Nodes.push_back(std::make_unique<NodeT>(std::forward<ArgTypes>(A)...));
+    Nodes.push_back(makeNode(std::forward<ArgTypes>(A)...));
+    adopt(Nodes.back().get());
     if constexpr (NodeT::HasParent)
       Nodes.back()->setParent(this);
     return Nodes.back().get();
@@ -1261,22 +1346,45 @@ public:
 public:
   nodes_iterator
   insertNode(nodes_iterator Where, std::unique_ptr<NodeT> &&Ptr) {
+    adopt(Ptr.get());
     auto InternalIt = Nodes.insert(Where.getCurrent(), std::move(Ptr));
     return nodes_iterator(InternalIt, getNode);
   }
   template<class... ArgTypes>
   nodes_iterator insertNode(nodes_iterator Where, ArgTypes &&...A) {
-    auto Pointer = std::make_unique<NodeT>(std::forward<ArgTypes>(A)...);
+    auto Pointer = makeNode(std::forward<ArgTypes>(A)...);
+    adopt(Pointer.get());
     auto InternalIt = Nodes.insert(Where.getCurrent(), std::move(Pointer));
     return nodes_iterator(InternalIt, getNode);
   }
 
 public:
   void reserve(size_t Size) { Nodes.reserve(Size); }
-  void clear() { Nodes.clear(); }
+  void clear() {
+    Nodes.clear();
+    if (Arena)
+      Arena->Reset();
+  }
+
+private:
+  template<class... ArgTypes>
+  NodePointer makeNode(ArgTypes &&...A) {
+    using revng::detail::makeMaybeInArena;
+    return makeMaybeInArena<NodeT>(Arena.get(), std::forward<ArgTypes>(A)...);
+  }
+
+  /// Make the edge labels of \p Node live in the arena of the graph, if any
+  void adopt(NodeT *Node) {
+    if constexpr (StrictSpecializationOfMutableEdgeNode<NodeT>)
+      Node->setLabelArena(Arena.get());
+  }
 
 private:
   NodesContainer Nodes;
+
+  /// Null if the graph allocates on the heap. It's a pointer so that its
+  /// address, which the nodes refer to, survives moving the graph.
+  std::unique_ptr<llvm::BumpPtrAllocator> Arena;
 };
 
 //
@@ -4,10 +4,16 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <algorithm>
 #include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
 #include <optional>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "revng/Support/Assert.h"
 
@@ -16,6 +22,118 @@ struct RecursiveCoroutine;
 
 namespace revng::detail {
 
+/// Allocator for the frames of RecursiveCoroutines.
+///
+/// The frames of recursive calls are created and destroyed in a strictly
+/// nested fashion, so they are allocated on a stack, made of slabs that are
+/// never released until the thread terminates.
+/// Frames can still be destroyed out of order (e.g., when a coroutine is
+/// moved around): their memory is simply reclaimed when all the frames
+/// allocated after them have been destroyed too.
+///
+/// Each thread has its own arena, a frame must be destroyed on the same thread
+/// it has been created on.
+class CoroutineFrameArena {
+private:
+  static constexpr size_t Alignment = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+  static constexpr size_t DefaultSlabSize = 64 * 1024;
+
+  struct Slab {
+    std::unique_ptr<std::byte[]> Memory;
+    size_t Size = 0;
+    size_t Used = 0;
+  };
+
+  struct Frame {
+    uint32_t Slab = 0;
+    bool Destroyed = false;
+    size_t Offset = 0;
+  };
+
+  /// Placed right before each frame, it identifies the frame in `Frames`
+  struct alignas(Alignment) Header {
+    const CoroutineFrameArena *Owner;
+    size_t Index;
+  };
+
+private:
+  std::vector<Slab> Slabs;
+  uint32_t CurrentSlab = 0;
+
+  /// All the frames that have been allocated and whose memory has not been
+  /// reclaimed yet, in allocation order
+  std::vector<Frame> Frames;
+
+public:
+  static CoroutineFrameArena &get() {
+    static thread_local CoroutineFrameArena Arena;
+    return Arena;
+  }
+
+public:
+  void *allocate(size_t Size) noexcept {
+    size_t Needed = sizeof(Header) + alignTo(Size);
+
+    // Find a slab with enough room, starting from the current one
+    while (CurrentSlab < Slabs.size()
+           and Slabs[CurrentSlab].Used + Needed > Slabs[CurrentSlab].Size) {
+      if (Slabs[CurrentSlab].Used == 0) {
+        // An empty slab that is too small, replace it
+        Slabs[CurrentSlab] = makeSlab(Needed);
+        break;
+      }
+      ++CurrentSlab;
+    }
+
+    if (CurrentSlab == Slabs.size())
+      Slabs.push_back(makeSlab(Needed));
+
+    Slab &Target = Slabs[CurrentSlab];
+    if (Target.Memory == nullptr)
+      return nullptr;
+
+    auto *Result = new (Target.Memory.get() + Target.Used) Header;
+    Result->Owner = this;
+    Result->Index = Frames.size();
+    Frames.push_back({ CurrentSlab, false, Target.Used });
+    Target.Used += Needed;
+
+    return Result + 1;
+  }
+
+  static void deallocate(void *Pointer) noexcept {
+    auto *TheHeader = static_cast<Header *>(Pointer) - 1;
+    CoroutineFrameArena &Arena = get();
+    revng_assert(TheHeader->Owner == &Arena,
+                 "RecursiveCoroutine destroyed on a different thread");
+    Arena.release(TheHeader->Index);
+  }
+
+private:
+  static size_t alignTo(size_t Size) {
+    return (Size + Alignment - 1) / Alignment * Alignment;
+  }
+
+  static Slab makeSlab(size_t Needed) {
+    size_t Size = std::max(DefaultSlabSize, Needed);
+    auto *Memory = new (std::nothrow) std::byte[Size];
+    return Slab{ std::unique_ptr<std::byte[]>(Memory), Size, 0 };
+  }
+
+  void release(size_t Index) {
+    revng_assert(Index < Frames.size() and not Frames[Index].Destroyed);
+    Frames[Index].Destroyed = true;
+
+    // Reclaim the memory of the destroyed frames on top of the stack
+    while (not Frames.empty() and Frames.back().Destroyed) {
+      const Frame &Top = Frames.back();
+      Slabs[Top.Slab].Used = Top.Offset;
+      CurrentSlab = Top.Slab;
+      Frames.pop_back();
+    }
+  }
+};
+
 template<typename RetT>
 struct ReturnBase {
 
@@ -63,6 +181,16 @@ struct RecursivePromise : public ReturnBase<ReturnT> {
 
   [[noreturn]] void unhandled_exception() const { std::terminate(); }
 
+#ifndef DISABLE_RECURSIVE_COROUTINE_FRAME_ARENA
+  static void *operator new(size_t Size) noexcept {
+    return CoroutineFrameArena::get().allocate(Size);
+  }
+
+  static void operator delete(void *Pointer) noexcept {
+    CoroutineFrameArena::deallocate(Pointer);
+  }
+#endif
+
   auto initial_suspend() const { return std::suspend_always(); }
 
   auto final_suspend() noexcept {
@@ -4,6 +4,8 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <memory>
+
 #include "llvm/ADT/SmallVector.h"
 
 #include "revng/EarlyFunctionAnalysis/CallHandler.h"
@@ -24,6 +26,8 @@ class Function;
 
 namespace efa {
 
+class OptimizationPipeline;
+
 class CallSummarizer : public CallHandler {
 private:
   llvm::Module *M = nullptr;
@@ -89,11 +93,15 @@ private:
   std::unique_ptr<llvm::raw_ostream> OutputAAWriter;
   std::unique_ptr<llvm::raw_ostream> OutputIBI;
 
+  /// Built upon the first analysis, and reused for all the following ones
+  std::unique_ptr<OptimizationPipeline> Pipeline;
+
 public:
   CFGAnalyzer(llvm::Module &M,
               GeneratedCodeBasicInfo &GCBI,
               const TupleTree<model::Binary> &Binary,
               const FunctionSummaryOracle &Oracle);
+  ~CFGAnalyzer();
 
 public:
   llvm::Function *preCallHook() const { return PreCallHook.get(); }
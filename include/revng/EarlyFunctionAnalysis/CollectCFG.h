@@ -7,6 +7,7 @@
 #include "llvm/Pass.h"
 
 #include "revng/BasicAnalyses/GeneratedCodeBasicInfo.h"
+#include "revng/EarlyFunctionAnalysis/FunctionSummaryCache.h"
 
 namespace efa {
 
@@ -21,6 +22,7 @@ public:
     AU.setPreservesAll();
     AU.addRequired<GeneratedCodeBasicInfoWrapperPass>();
     AU.addRequired<LoadModelWrapperPass>();
+    AU.addRequired<FunctionSummaryCacheWrapperPass>();
   }
 
   bool runOnModule(llvm::Module &M) override;
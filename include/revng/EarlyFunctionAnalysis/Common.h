@@ -4,7 +4,10 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
-#include "llvm/ADT/SmallSet.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/Sequence.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/IR/GlobalVariable.h"
@@ -12,6 +15,7 @@
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/Value.h"
 #include "llvm/Support/Casting.h"
+#include "llvm/Support/MathExtras.h"
 
 #include "revng/BasicAnalyses/GeneratedCodeBasicInfo.h"
 #include "revng/MFP/MFP.h"
@@ -31,7 +35,8 @@ enum TransferKind {
 
 struct ABIAnalysis {
 private:
-  llvm::SmallSet<llvm::GlobalVariable *, 20> ABIRegisters;
+  /// Position of each ABI register in RegisterList
+  llvm::DenseMap<const llvm::GlobalVariable *, unsigned> RegisterIndices;
   llvm::SmallVector<llvm::GlobalVariable *, 20> RegisterList;
   const llvm::Instruction *CallSite;
 
@@ -44,16 +49,22 @@ public:
 
     for (auto *CSV : GCBI.abiRegisters()) {
       if (CSV) {
-        ABIRegisters.insert(CSV);
+        RegisterIndices[CSV] = RegisterList.size();
         RegisterList.emplace_back(CSV);
       }
     }
   };
 
-  const llvm::SmallVector<llvm::GlobalVariable *, 20> getRegisters() const {
+  llvm::ArrayRef<llvm::GlobalVariable *> getRegisters() const {
     return RegisterList;
   }
 
+  unsigned getRegisterIndex(const llvm::GlobalVariable *CSV) const {
+    auto It = RegisterIndices.find(CSV);
+    revng_assert(It != RegisterIndices.end());
+    return It->second;
+  }
+
   bool isABIRegister(const llvm::Value *) const;
 
   TransferKind classifyInstruction(const llvm::Instruction *) const;
@@ -67,7 +78,7 @@ public:
 
 inline bool ABIAnalysis::isABIRegister(const llvm::Value *V) const {
   if (auto *G = dyn_cast<llvm::GlobalVariable>(V)) {
-    return ABIRegisters.count(G) != 0;
+    return RegisterIndices.count(G) != 0;
   }
   return false;
 }
@@ -160,72 +171,101 @@ ABIAnalysis::getRegistersRead(const llvm::Instruction *I) const {
   return Result;
 }
 
+/// The lattice element of each ABI register, in the bit-sliced representation
+/// of CoreLattice: the state of the i-th register is in the i-th bit of the
+/// planes, which are grouped in words.
 template<typename CoreLattice>
-struct RegistersMap
-  : public llvm::DenseMap<const llvm::GlobalVariable *,
-                          typename CoreLattice::LatticeElement> {
+class RegistersPlanes {
 private:
   using InnerLatticeElement = typename CoreLattice::LatticeElement;
-  using Base = llvm::DenseMap<const llvm::GlobalVariable *,
-                              InnerLatticeElement>;
+  using TransferFunction = typename CoreLattice::TransferFunction;
+  using Word = typename CoreLattice::Word;
+  using Planes = typename CoreLattice::Planes;
+  static constexpr size_t WordBits = 8 * sizeof(Word);
 
 private:
-  InnerLatticeElement Default{};
+  llvm::ArrayRef<llvm::GlobalVariable *> Registers;
+  llvm::SmallVector<Planes, 2> Words;
 
 public:
-  RegistersMap() : Default{} {}
-  RegistersMap(InnerLatticeElement Default) : Default(Default) {}
+  RegistersPlanes() = default;
+
+  /// Sets all of \p Registers to \p Initial
+  RegistersPlanes(llvm::ArrayRef<llvm::GlobalVariable *> Registers,
+                  InnerLatticeElement Initial) :
+    Registers(Registers),
+    Words(llvm::divideCeil(Registers.size(), WordBits), Planes{}) {
+    for (size_t Index = 0; Index < Words.size(); ++Index)
+      Words[Index][Initial] = validBits(Index);
+  }
 
 public:
-  InnerLatticeElement getOrDefault(const llvm::GlobalVariable *GV) const {
-    auto It = Base::find(GV);
-    if (It == Base::end())
-      return Default;
-    else
-      return It->second;
+  InnerLatticeElement get(unsigned Register) const {
+    const Planes &Slice = Words[Register / WordBits];
+    Word Bit = bit(Register);
+    for (unsigned Element = 0; Element < CoreLattice::PlanesCount; ++Element)
+      if ((Slice[Element] & Bit) != 0)
+        return static_cast<InnerLatticeElement>(Element);
+    revng_abort("Register not found in any plane");
+  }
+
+  /// \return a range of (register, lattice element) pairs
+  auto elements() const {
+    return llvm::map_range(llvm::seq<unsigned>(0, Registers.size()),
+                           [this](unsigned Register) {
+                             return std::pair(Registers[Register],
+                                              get(Register));
+                           });
   }
 
 public:
-  RegistersMap combine(const RegistersMap &RHS) const {
-    RegistersMap New = *this;
-    for (const auto &[Reg, S] : RHS) {
-      auto LHSValue = New.getOrDefault(Reg);
-      auto RHSValue = RHS.getOrDefault(Reg);
-      New[Reg] = CoreLattice::combineValues(LHSValue, RHSValue);
-    }
+  /// Applies \p T to the register with index \p Register
+  void transfer(TransferFunction T, unsigned Register) {
+    Planes &Slice = Words[Register / WordBits];
+    Planes New = CoreLattice::transferPlanes(T, Slice);
+    Word Mask = bit(Register);
+    for (unsigned Element = 0; Element < CoreLattice::PlanesCount; ++Element)
+      Slice[Element] = (Slice[Element] & ~Mask) | (New[Element] & Mask);
+  }
 
-    New.Default = CoreLattice::combineValues(New.Default, RHS.Default);
+  /// Applies \p T to all the registers
+  void transfer(TransferFunction T) {
+    for (Planes &Slice : Words)
+      Slice = CoreLattice::transferPlanes(T, Slice);
+  }
 
+  RegistersPlanes combine(const RegistersPlanes &RHS) const {
+    revng_assert(Words.size() == RHS.Words.size());
+    RegistersPlanes New = *this;
+    for (size_t Index = 0; Index < Words.size(); ++Index)
+      New.Words[Index] = CoreLattice::combinePlanes(Words[Index],
+                                                    RHS.Words[Index]);
     return New;
   }
 
-  bool isLessOrEqual(const RegistersMap &RHS) const {
-    const RegistersMap &LHS = *this;
-
-    if (!CoreLattice::isLessOrEqual(LHS.Default, RHS.Default))
-      return false;
-
-    for (auto &[Reg, S] : LHS) {
-      auto LHSValue = LHS.getOrDefault(Reg);
-      auto RHSValue = RHS.getOrDefault(Reg);
-      if (!CoreLattice::isLessOrEqual(LHSValue, RHSValue)) {
-        return false;
-      }
-    }
-    for (auto &[Reg, S] : RHS) {
-      auto LHSValue = LHS.getOrDefault(Reg);
-      auto RHSValue = RHS.getOrDefault(Reg);
-      if (!CoreLattice::isLessOrEqual(LHSValue, RHSValue)) {
+  bool isLessOrEqual(const RegistersPlanes &RHS) const {
+    revng_assert(Words.size() == RHS.Words.size());
+    for (size_t Index = 0; Index < Words.size(); ++Index)
+      if (CoreLattice::notLessOrEqualPlanes(Words[Index], RHS.Words[Index]))
         return false;
-      }
-    }
     return true;
   }
+
+private:
+  static Word bit(unsigned Register) {
+    return Word(1) << (Register % WordBits);
+  }
+
+  /// \return the mask of the bits of the Index-th word representing a register
+  Word validBits(size_t Index) const {
+    size_t Remaining = Registers.size() - Index * WordBits;
+    return Remaining >= WordBits ? ~Word(0) : (Word(1) << Remaining) - 1;
+  }
 };
 
 template<bool IsForward, typename CoreLattice>
 struct MFIAnalysis : ABIAnalyses::ABIAnalysis {
-  using LatticeElement = RegistersMap<CoreLattice>;
+  using LatticeElement = RegistersPlanes<CoreLattice>;
   using Label = const llvm::BasicBlock *;
   using GraphType = std::conditional_t<IsForward,
                                        const llvm::BasicBlock *,
@@ -233,6 +273,14 @@ struct MFIAnalysis : ABIAnalyses::ABIAnalysis {
   using GT = llvm::GraphTraits<GraphType>;
   using LGT = GraphType;
 
+  LatticeElement initialValue() const {
+    return LatticeElement(getRegisters(), {});
+  }
+
+  LatticeElement extremalValue() const {
+    return LatticeElement(getRegisters(), CoreLattice::ExtremalLatticeElement);
+  }
+
   LatticeElement
   combineValues(const LatticeElement &LHS, const LatticeElement &RHS) const {
     return LHS.combine(RHS);
@@ -256,25 +304,17 @@ struct MFIAnalysis : ABIAnalyses::ABIAnalysis {
       auto I = InsList[IsForward ? Index : (InsList.size() - Index - 1)];
       TransferKind T = classifyInstruction(I);
       switch (T) {
-      case TheCall: {
-        for (auto &Reg : getRegisters()) {
-          auto RegState = New.getOrDefault(Reg);
-          New[Reg] = CoreLattice::transfer(TheCall, RegState);
-        }
+      case TheCall:
+        New.transfer(TheCall);
         break;
-      }
       case Read:
-        for (auto &Reg : getRegistersRead(I)) {
-          auto RegState = New.getOrDefault(Reg);
-          New[Reg] = CoreLattice::transfer(T, RegState);
-        }
+        for (auto &Reg : getRegistersRead(I))
+          New.transfer(T, getRegisterIndex(Reg));
         break;
       case WeakWrite:
       case Write:
-        for (auto &Reg : getRegistersWritten(I)) {
-          auto RegState = New.getOrDefault(Reg);
-          New[Reg] = CoreLattice::transfer(T, RegState);
-        }
+        for (auto &Reg : getRegistersWritten(I))
+          New.transfer(T, getRegisterIndex(Reg));
         break;
       default:
         break;
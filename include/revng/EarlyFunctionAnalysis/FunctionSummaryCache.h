@@ -0,0 +1,128 @@
+#pragma once
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <list>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "llvm/Pass.h"
+
+#include "revng/EarlyFunctionAnalysis/BasicBlock.h"
+#include "revng/EarlyFunctionAnalysis/FunctionSummaryOracle.h"
+#include "revng/Support/Assert.h"
+#include "revng/Support/MetaAddress.h"
+
+namespace llvm {
+class Module;
+}
+
+namespace model {
+class Binary;
+class Function;
+} // namespace model
+
+namespace efa {
+
+/// The result of the analysis of a function performed by DetectABI, along with
+/// what is needed to tell whether analyzing it again would yield the same
+/// result
+struct CachedFunctionSummary {
+  /// Fingerprint of the inputs of the analysis, see
+  /// FunctionSummaryCache::computeInputsHash
+  uint64_t InputsHash = 0;
+
+  /// The queries to the FunctionSummaryOracle the analysis depended upon
+  OracleQueries Queries;
+
+  SortedVector<efa::BasicBlock> CFG;
+  std::set<std::string> ClobberedRegisters;
+  std::optional<int64_t> ElectedFSO;
+};
+
+/// Function-keyed cache of the summaries computed by DetectABI, so that later
+/// passes (e.g., CollectCFG) do not need to analyze again the functions whose
+/// inputs did not change.
+///
+/// DetectABI runs as an analysis on a copy of the module, therefore its results
+/// cannot be stored in a pipeline container. Instead, they are kept in memory,
+/// up to a maximum number of functions, evicting the least recently used ones.
+class FunctionSummaryCache {
+private:
+  struct CacheEntry {
+    CachedFunctionSummary Summary;
+
+    /// Position of the entry in UseOrder
+    std::list<MetaAddress>::iterator Use;
+  };
+
+private:
+  std::map<MetaAddress, CacheEntry> Summaries;
+
+  /// Entry points of the cached functions, the most recently used last
+  mutable std::list<MetaAddress> UseOrder;
+
+  size_t Capacity = 0;
+
+public:
+  explicit FunctionSummaryCache(size_t Capacity) : Capacity(Capacity) {
+    revng_assert(Capacity > 0);
+  }
+
+public:
+  /// Compute the fingerprint of what the analysis of all the functions of \p M
+  /// depends upon, besides the model of the function itself: the architecture,
+  /// the segments and their contents, the extra code addresses and the helpers
+  /// declared in \p M.
+  ///
+  /// The code of the helpers is not considered, it does not change unless the
+  /// architecture does.
+  static uint64_t computeModuleHash(const llvm::Module &M,
+                                    const model::Binary &Binary);
+
+  /// Compute the fingerprint of the inputs of the analysis of \p Function,
+  /// excluding the information provided by the FunctionSummaryOracle
+  static uint64_t computeInputsHash(const model::Function &Function,
+                                    uint64_t ModuleHash);
+
+public:
+  void record(MetaAddress Entry, CachedFunctionSummary &&Summary);
+
+  /// \return the summary of the function at \p Entry if it has been computed
+  ///         on the same inputs, nullptr otherwise
+  const CachedFunctionSummary *get(MetaAddress Entry,
+                                   uint64_t InputsHash,
+                                   const FunctionSummaryOracle &Oracle) const;
+
+  size_t size() const { return Summaries.size(); }
+
+  void clear() {
+    Summaries.clear();
+    UseOrder.clear();
+  }
+};
+
+class FunctionSummaryCacheWrapperPass : public llvm::ImmutablePass {
+public:
+  static char ID;
+
+private:
+  FunctionSummaryCache &Cache;
+
+public:
+  /// Use the cache shared by all the pass managers of the process
+  FunctionSummaryCacheWrapperPass();
+
+  FunctionSummaryCacheWrapperPass(FunctionSummaryCache &Cache) :
+    llvm::ImmutablePass(ID), Cache(Cache) {}
+
+public:
+  FunctionSummaryCache &get() { return Cache; }
+};
+
+} // namespace efa
@@ -5,6 +5,10 @@
 //
 
 #include <set>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/SmallVector.h"
 
 #include "revng/ADT/MutableSet.h"
 #include "revng/EarlyFunctionAnalysis/ABIAnalysis.h"
@@ -106,6 +110,25 @@ public:
   }
 };
 
+/// A query performed on a FunctionSummaryOracle through getCallSite along with
+/// a digest of the answer it obtained
+struct CallSiteQuery {
+  MetaAddress Function;
+  BasicBlockID CallerBlockAddress;
+  MetaAddress CalledLocalFunction;
+  std::string CalledSymbol;
+  uint64_t AnswerDigest = 0;
+};
+
+/// The queries performed on a FunctionSummaryOracle, i.e., all the information
+/// about other functions an analysis depended upon
+struct OracleQueries {
+  std::vector<CallSiteQuery> CallSites;
+
+  /// Addresses checked through isLocalFunction, along with the answer
+  std::vector<std::pair<MetaAddress, bool>> LocalFunctions;
+};
+
 /// An oracle providing information about functions.
 ///
 /// This oracle can be populated with analysis results. But even if it has not
@@ -129,6 +152,9 @@ private:
   /// Default
   FunctionSummary Default;
 
+  /// All the queries answered are recorded in each of these
+  mutable llvm::SmallVector<OracleQueries *, 2> Recorders;
+
 public:
   const FunctionSummary &getDefault() const { return Default; }
 
@@ -148,6 +174,28 @@ public:
               MetaAddress CalledLocalFunction,
               llvm::StringRef CalledSymbol) const;
 
+  /// \return true if \p PC is the entry point of a local function
+  bool isLocalFunction(MetaAddress PC) const;
+
+  /// Start recording the queries performed through getCallSite and
+  /// isLocalFunction into \p Queries. Recordings can be nested.
+  void startRecording(OracleQueries &Queries) const {
+    Recorders.push_back(&Queries);
+  }
+
+  /// Stop recording into \p Queries, which must be the innermost recording
+  void stopRecording(OracleQueries &Queries) const {
+    revng_assert(not Recorders.empty() and Recorders.back() == &Queries);
+    Recorders.pop_back();
+  }
+
+  /// Record \p Queries as if they were performed again
+  void replay(const OracleQueries &Queries) const;
+
+  /// \return true if this oracle gives the same answers to \p Queries as the
+  ///         oracle that recorded them
+  bool answersLike(const OracleQueries &Queries) const;
+
 public:
   bool registerCallSite(MetaAddress Function,
                         BasicBlockID CallSite,
@@ -165,6 +213,13 @@ public:
   }
 
 private:
+  /// Same as getCallSite, but do not record the query
+  std::pair<const FunctionSummary *, bool>
+  lookupCallSite(MetaAddress Function,
+                 BasicBlockID CallerBlockAddress,
+                 MetaAddress CalledLocalFunction,
+                 llvm::StringRef CalledSymbol) const;
+
   std::pair<const FunctionSummary *, bool>
   getCallSiteImpl(MetaAddress Function, BasicBlockID CallSite) const {
     auto It = CallSites.find({ Function, CallSite });
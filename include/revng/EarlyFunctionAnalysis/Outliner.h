@@ -4,6 +4,8 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <map>
+
 #include "llvm/IR/Module.h"
 #include "llvm/Transforms/Utils/CodeExtractor.h"
 
@@ -73,6 +75,22 @@ public:
 
 /// This class, given an Oracle, can outline functions from root
 class Outliner {
+private:
+  /// The body of a function to inline, ready to be cloned in any caller
+  struct InlinableBody {
+    CallHandler *Handler = nullptr;
+
+    /// The queries to the Oracle the body depends upon
+    OracleQueries Queries;
+
+    /// The functions to inline called by the body
+    std::vector<MetaAddress> Callees;
+
+    /// The body, its calls to other functions to inline target the
+    /// corresponding declaration in Placeholders
+    UniqueValuePtr<llvm::Function> Body;
+  };
+
 private:
   llvm::Module &M;
   GeneratedCodeBasicInfo &GCBI;
@@ -85,6 +103,14 @@ private:
 
   llvm::CodeExtractorAnalysisCache CEAC;
 
+  // Note: InlinableBodies refer to Placeholders, it needs to be destroyed
+  //       first
+  std::map<MetaAddress, UniqueValuePtr<llvm::Function>> Placeholders;
+
+  /// Bodies of the functions to inline outlined so far, so that they are not
+  /// outlined again for each caller
+  std::map<MetaAddress, InlinableBody> InlinableBodies;
+
 public:
   Outliner(llvm::Module &M,
            GeneratedCodeBasicInfo &GCBI,
@@ -133,6 +159,13 @@ private:
                          llvm::BasicBlock *BB,
                          OutlinedFunctionsMap &FunctionsToInline);
 
+  llvm::Function *
+  outlineFunctionToInline(CallHandler *TheCallHandler,
+                          llvm::BasicBlock *BB,
+                          OutlinedFunctionsMap &FunctionsToInline);
+
+  llvm::Function *getPlaceholder(MetaAddress Entry);
+
   void createAnyPCHooks(CallHandler *TheCallHandler, OutlinedFunction *F);
 };
 
@@ -94,12 +94,16 @@ TUPLE-TREE-YAML */
 
 namespace model {
 using TypePath = TupleTreeReference<model::Type, model::Binary>;
-}
+class IncrementalVerifier;
+} // namespace model
 
 class model::Binary : public model::generated::Binary {
 public:
   using generated::Binary::Binary;
 
+  /// Used by pipeline::TupleTreeGlobal to verify the model after a diff
+  using IncrementalVerifier = model::IncrementalVerifier;
+
 public:
   model::TypePath getTypePath(const model::Type::Key &Key) {
     return TypePath::fromString(this, "/Types/" + getNameFromYAMLScalar(Key));
@@ -164,6 +168,11 @@ public:
   model::TypePath
   getPrimitiveType(PrimitiveTypeKind::Values V, uint8_t ByteSize) const;
 
+  /// \return the address ranges the lifter is allowed to translate code from:
+  ///         the sections containing code of executable segments or, if an
+  ///         executable segment has no sections, the whole segment.
+  std::vector<std::pair<MetaAddress, MetaAddress>> executableRanges() const;
+
   bool verifyTypes() const debug_function;
   bool verifyTypes(bool Assert) const debug_function;
   bool verifyTypes(VerifyHelper &VH) const;
@@ -187,3 +196,6 @@ getPrototype(const model::Binary &Binary,
 }
 
 #include "revng/Model/Generated/Late/Binary.h"
+
+// IncrementalVerifier requires a complete model::Binary
+#include "revng/Model/IncrementalVerifier.h"
@@ -20,6 +20,8 @@ struct ImporterOptions {
   const bool EnableRemoteDebugInfo;
 
   const llvm::ArrayRef<std::string> AdditionalDebugInfoPaths;
+
+  const unsigned DebugInfoThreads;
 };
 
 [[nodiscard]] const ImporterOptions importerOptions();
@@ -28,3 +30,4 @@ extern llvm::cl::opt<std::uint64_t> BaseAddress;
 extern llvm::cl::list<std::string> ImportDebugInfo;
 extern llvm::cl::opt<DebugInfoLevel> DebugInfo;
 extern llvm::cl::opt<bool> EnableRemoteDebugInfo;
+extern llvm::cl::opt<unsigned> DebugInfoThreads;
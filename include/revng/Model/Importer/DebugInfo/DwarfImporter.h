@@ -5,6 +5,7 @@
 //
 
 #include "llvm/Object/Binary.h"
+#include "llvm/Object/ObjectFile.h"
 
 #include "revng/Model/Binary.h"
 
@@ -32,13 +33,28 @@ public:
     return DwarfToModel.insert({ ID, QT }).first->second;
   }
 
+  /// Records all the types recorded by \p Other, whose model types must have
+  /// already been moved into our model
+  void importRecordedTypes(const DwarfImporter &Other) {
+    for (auto [ID, QT] : Other.DwarfToModel) {
+      QT.UnqualifiedType().setRoot(Model.get());
+      recordType(ID, QT);
+    }
+  }
+
   TupleTree<model::Binary> &getModel() { return Model; }
 
 public:
   void import(llvm::StringRef FileName, const ImporterOptions &Options);
 
+  /// Same as the overload taking a file name, but reuses \p TheBinary,
+  /// which has already been loaded
+  void import(const llvm::object::ObjectFile &TheBinary,
+              const ImporterOptions &Options);
+
 private:
   void import(const llvm::object::Binary &TheBinary,
               llvm::StringRef FileName,
-              std::uint64_t PreferredBaseAddress);
+              std::uint64_t PreferredBaseAddress,
+              unsigned Threads);
 };
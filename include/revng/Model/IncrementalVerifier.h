@@ -0,0 +1,118 @@
+#pragma once
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <map>
+#include <optional>
+#include <set>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+#include "revng/Model/Binary.h"
+#include "revng/Model/VerifyHelper.h"
+#include "revng/TupleTree/TupleTreeDiff.h"
+
+namespace model {
+
+/// Verifies a model::Binary keeping track of the information required to
+/// verify it again after it has been changed by a TupleTreeDiff.
+///
+/// The first verification is equivalent to Binary::verify. In addition, it
+/// records the names that have to be unique and which entities (functions,
+/// dynamic functions, segments and types) reference each type. After that,
+/// verifying a diff re-verifies only the entities it touched, plus the ones
+/// referencing a touched type, and checks the uniqueness of their names
+/// against the recorded ones.
+///
+/// Changes to global properties of the binary (e.g., the default prototype or
+/// the ABI) trigger a full verification.
+class IncrementalVerifier {
+private:
+  template<typename T>
+  using KeyOf = std::remove_const_t<typename T::key_type>;
+
+  using FunctionKey = KeyOf<model::Binary::FunctionsType>;
+  using DynamicFunctionKey = KeyOf<model::Binary::ImportedDynamicFunctionsType>;
+  using SegmentKey = KeyOf<model::Binary::SegmentsType>;
+  using TypeKey = KeyOf<model::Binary::TypesType>;
+  using Entity = std::variant<FunctionKey,
+                              DynamicFunctionKey,
+                              SegmentKey,
+                              TypeKey>;
+
+  struct EntityInfo {
+    /// Custom names introduced by this entity, they share the same namespace
+    std::vector<Identifier> CustomNames;
+
+    /// Name of the type, they must be unique among types
+    std::optional<Identifier> TypeName;
+
+    /// Types referenced by this entity
+    std::vector<TypeKey> Uses;
+  };
+
+private:
+  /// Whether the indexes below describe the last verified model, and such
+  /// model was valid
+  bool Valid = false;
+
+  std::map<Entity, EntityInfo> Entities;
+
+  /// How many entities use each custom name
+  std::map<Identifier, unsigned> CustomNames;
+
+  /// How many types have each name
+  std::map<Identifier, unsigned> TypeNames;
+
+  /// Entities referencing each type
+  std::map<TypeKey, std::set<Entity>> Users;
+
+public:
+  /// Verifies the whole model and records its indexes
+  bool verify(const model::Binary &Model, VerifyHelper &VH);
+
+  bool verify(const model::Binary &Model) {
+    VerifyHelper VH(false);
+    return verify(Model, VH);
+  }
+
+  /// Verifies \p Model, which is the last model verified by this object with
+  /// \p Diff applied
+  bool verify(const model::Binary &Model,
+              const TupleTreeDiff<model::Binary> &Diff,
+              VerifyHelper &VH);
+
+  bool verify(const model::Binary &Model,
+              const TupleTreeDiff<model::Binary> &Diff) {
+    VerifyHelper VH(false);
+    return verify(Model, Diff, VH);
+  }
+
+  /// Forget about the last verified model, the next verification will be a
+  /// full one
+  void reset();
+
+private:
+  bool collectTouched(const TupleTreeDiff<model::Binary> &Diff,
+                      std::set<Entity> &Touched) const;
+
+  void forget(const Entity &E);
+  bool record(const Entity &E, EntityInfo &&Info, VerifyHelper &VH);
+
+  /// Verifies \p E and collects its information. Returns std::nullopt if \p E
+  /// is no longer part of \p Model.
+  std::optional<bool> verifyEntity(const model::Binary &Model,
+                                   const Entity &E,
+                                   EntityInfo &Info,
+                                   VerifyHelper &VH) const;
+
+  size_t expectedEntities(const model::Binary &Model) const {
+    return Model.Functions().size() + Model.ImportedDynamicFunctions().size()
+           + Model.Segments().size() + Model.Types().size();
+  }
+};
+
+} // namespace model
@@ -109,6 +109,9 @@ using UpcastableType = UpcastablePointer<model::Type>;
 
 model::UpcastableType makeTypeWithID(model::TypeKind::Values Kind, uint64_t ID);
 
+/// \return the seed set through -model-type-id-seed, if any
+std::optional<uint64_t> getTypeIDSeed();
+
 using TypePath = TupleTreeReference<model::Type, model::Binary>;
 
 template<IsModelType T, typename... Args>
@@ -9,6 +9,7 @@
 
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringMap.h"
+#include "llvm/Support/raw_ostream.h"
 
 #include "revng/ADT/Concepts.h"
 #include "revng/PTML/Constants.h"
@@ -62,17 +63,38 @@ public:
   }
 
   std::string open() const {
-    llvm::SmallString<128> Out;
-    Out.append({ "<", TheTag });
-    for (auto &Pair : Attributes)
-      Out.append({ " ", Pair.first(), "=\"", Pair.second, "\"" });
-    Out.append({ '>' });
-    return Out.str().str();
+    std::string Out;
+    llvm::raw_string_ostream OS(Out);
+    open(OS);
+    return Out;
   }
 
   std::string close() const { return "</" + TheTag + ">"; }
 
-  std::string serialize() const { return open() + Content + close(); }
+  std::string serialize() const {
+    std::string Out;
+    llvm::raw_string_ostream OS(Out);
+    serialize(OS);
+    return Out;
+  }
+
+  /// Streaming versions of the methods above, they do not allocate
+  /// @{
+  void open(llvm::raw_ostream &OS) const {
+    OS << '<' << TheTag;
+    for (auto &Pair : Attributes)
+      OS << ' ' << Pair.first() << "=\"" << Pair.second << '"';
+    OS << '>';
+  }
+
+  void close(llvm::raw_ostream &OS) const { OS << "</" << TheTag << '>'; }
+
+  void serialize(llvm::raw_ostream &OS) const {
+    open(OS);
+    OS << Content;
+    close(OS);
+  }
+  /// @}
 
   void dump() const debug_function { dump(dbg); }
 
@@ -102,7 +124,7 @@ inline std::string operator+(const Tag &LHS, const Tag &RHS) {
 }
 
 inline llvm::raw_ostream &operator<<(llvm::raw_ostream &OS, const Tag &TheTag) {
-  OS << TheTag.serialize();
+  TheTag.serialize(OS);
   return OS;
 }
 
@@ -129,7 +151,7 @@ private:
 public:
   ScopeTag(llvm::raw_ostream &OS, const Tag &TheTag, bool Newline) :
     OS(OS), TagClose(TheTag.close()) {
-    OS << TheTag.open();
+    TheTag.open(OS);
     if (Newline)
       OS << "\n";
   }
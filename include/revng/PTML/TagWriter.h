@@ -0,0 +1,177 @@
+#pragma once
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <string>
+#include <utility>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/StringSaver.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "revng/ADT/Concepts.h"
+#include "revng/Support/Assert.h"
+
+namespace ptml {
+
+/// Emits PTML (or any other XML-like markup) directly into a stream, without
+/// building a string for each tag.
+///
+/// \code{.cpp}
+/// TagWriter Writer(OS);
+/// Writer.tag(tags::Span)
+///   .addAttribute(attributes::Token, tokens::Indentation)
+///   .emit("  ");
+/// {
+///   auto Scope = Writer.tag(tags::Div)
+///                  .addAttribute(attributes::Scope, "foo")
+///                  .scope();
+///   Writer.stream() << "Bar";
+/// } // Out of scope, </div> will be emitted
+/// \endcode
+///
+/// Attribute values are not copied into the tags: the ones that would not
+/// outlive the tag are moved into an arena owned by the writer, which is
+/// released all at once when the writer is destroyed.
+class TagWriter {
+public:
+  class Builder;
+  class Scope;
+
+private:
+  llvm::raw_ostream &OS;
+  llvm::BumpPtrAllocator Arena;
+  llvm::StringSaver Saver;
+
+public:
+  explicit TagWriter(llvm::raw_ostream &OS) : OS(OS), Saver(Arena) {}
+
+  TagWriter(const TagWriter &) = delete;
+  TagWriter(TagWriter &&) = delete;
+  TagWriter &operator=(const TagWriter &) = delete;
+  TagWriter &operator=(TagWriter &&) = delete;
+
+public:
+  llvm::raw_ostream &stream() { return OS; }
+
+  /// Copy \p Value into the arena, so that it lives as long as the writer
+  llvm::StringRef save(const llvm::Twine &Value) { return Saver.save(Value); }
+
+  Builder tag(llvm::StringRef Name);
+};
+
+/// A tag being described, nothing is emitted until either `emit` or `scope`
+/// are called
+class TagWriter::Builder {
+private:
+  TagWriter &Writer;
+  llvm::StringRef Name;
+  llvm::SmallVector<std::pair<llvm::StringRef, llvm::StringRef>, 4> Attributes;
+
+public:
+  Builder(TagWriter &Writer, llvm::StringRef Name) :
+    Writer(Writer), Name(Name) {
+    revng_assert(not Name.empty());
+  }
+
+public:
+  /// \note \p Value must outlive the builder
+  Builder &addAttribute(llvm::StringRef Name, llvm::StringRef Value) {
+    Attributes.emplace_back(Name, Value);
+    return *this;
+  }
+
+  Builder &addAttribute(llvm::StringRef Name, const char *Value) {
+    return addAttribute(Name, llvm::StringRef(Value));
+  }
+
+  Builder &addAttribute(llvm::StringRef Name, std::string &&Value) {
+    return addAttribute(Name, Writer.save(Value));
+  }
+
+  template<range_with_value_type<llvm::StringRef> T>
+  Builder &addListAttribute(llvm::StringRef Name, const T &Values) {
+    llvm::SmallString<128> Joined;
+    for (const auto &Value : Values) {
+      revng_check(not llvm::StringRef(Value).contains(","));
+      if (not Joined.empty())
+        Joined += ',';
+      Joined += llvm::StringRef(Value);
+    }
+    return addAttribute(Name, Writer.save(Joined));
+  }
+
+  // clang-format off
+  template<typename... T>
+    requires(std::is_convertible_v<T, llvm::StringRef> and ...)
+  Builder &addListAttribute(llvm::StringRef Name, const T &...Value) {
+    // clang-format on
+    std::initializer_list<llvm::StringRef> Values = { Value... };
+    return this->addListAttribute(Name, Values);
+  }
+
+public:
+  /// Emit the opening tag, \p Content and the closing tag
+  void emit(llvm::StringRef Content = "") {
+    open();
+    Writer.OS << Content;
+    close();
+  }
+
+  /// Emit the opening tag, the closing one is emitted when the returned object
+  /// goes out of scope
+  Scope scope(bool Newline = false);
+
+private:
+  void open() {
+    llvm::raw_ostream &OS = Writer.OS;
+    OS << '<' << Name;
+    for (const auto &[AttributeName, Value] : Attributes)
+      OS << ' ' << AttributeName << "=\"" << Value << '"';
+    OS << '>';
+  }
+
+  void close() { Writer.OS << "</" << Name << '>'; }
+};
+
+/// RAII handle of a tag opened by TagWriter::Builder::scope
+class TagWriter::Scope {
+private:
+  llvm::raw_ostream *OS;
+  llvm::StringRef Name;
+
+public:
+  Scope(llvm::raw_ostream &OS, llvm::StringRef Name) : OS(&OS), Name(Name) {}
+
+  Scope(const Scope &) = delete;
+  Scope &operator=(const Scope &) = delete;
+
+  Scope(Scope &&Other) : OS(Other.OS), Name(Other.Name) {
+    Other.OS = nullptr;
+  }
+  Scope &operator=(Scope &&) = delete;
+
+  ~Scope() {
+    if (OS != nullptr)
+      *OS << "</" << Name << '>';
+  }
+};
+
+inline TagWriter::Builder TagWriter::tag(llvm::StringRef Name) {
+  return Builder(*this, Name);
+}
+
+inline TagWriter::Scope TagWriter::Builder::scope(bool Newline) {
+  open();
+  if (Newline)
+    Writer.OS << "\n";
+  return Scope(Writer.OS, Name);
+}
+
+} // namespace ptml
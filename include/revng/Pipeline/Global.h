@@ -5,7 +5,9 @@
 
 #include <any>
 #include <memory>
+#include <optional>
 #include <type_traits>
+#include <variant>
 
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Error.h"
@@ -56,11 +58,48 @@ public:
   virtual llvm::Error loadFromDisk(llvm::StringRef Path);
 };
 
+// clang-format off
+/// A TupleTree root exposing a verifier that, after a full verification, is
+/// able to verify the tree again after a diff has been applied, without
+/// re-verifying the whole tree
+template<typename T>
+concept IncrementallyVerifiable = requires(typename T::IncrementalVerifier &V,
+                                           const T &Object,
+                                           const TupleTreeDiff<T> &Diff) {
+  { V.verify(Object) } -> std::same_as<bool>;
+  { V.verify(Object, Diff) } -> std::same_as<bool>;
+};
+// clang-format on
+
+namespace detail {
+
+template<typename T>
+struct IncrementalVerifierOf {
+  using type = std::monostate;
+};
+
+template<IncrementallyVerifiable T>
+struct IncrementalVerifierOf<T> {
+  using type = typename T::IncrementalVerifier;
+};
+
+} // namespace detail
+
 template<TupleTreeCompatibleAndVerifiable Object>
 class TupleTreeGlobal : public Global {
+private:
+  using Verifier = typename detail::IncrementalVerifierOf<Object>::type;
+
 private:
   TupleTree<Object> Value;
 
+  /// If Object is IncrementallyVerifiable, the state of the last verification.
+  /// It describes Value if VerifierIsUpToDate is true, except for the changes
+  /// in PendingDiff, if any.
+  mutable Verifier IncrementalVerifier;
+  mutable bool VerifierIsUpToDate = false;
+  mutable std::optional<TupleTreeDiff<Object>> PendingDiff;
+
   static const char &getID() {
     static char ID;
     return ID;
@@ -89,11 +128,15 @@ public:
   }
 
   std::unique_ptr<Global> clone() const override {
+    // The copy shares the cached hashes, so that diffing it against the
+    // original later on only visits what has changed in the meantime
+    Value.cacheHashes();
     auto Ptr = new TupleTreeGlobal(*this);
     return std::unique_ptr<Global>(Ptr);
   }
 
   void clear() override {
+    invalidateVerifier();
     Value.evictCachedReferences();
     *Value = Object();
   }
@@ -108,6 +151,7 @@ public:
     if (!MaybeDiff)
       return llvm::errorCodeToError(MaybeDiff.getError());
 
+    invalidateVerifier();
     Value = *MaybeDiff;
     return llvm::Error::success();
   }
@@ -117,7 +161,21 @@ public:
     return ::deserialize<TupleTreeDiff<Object>>(Buffer.getBuffer());
   }
 
-  bool verify() const override { return Value->verify(); }
+  bool verify() const override {
+    if constexpr (IncrementallyVerifiable<Object>) {
+      bool Result = false;
+      if (VerifierIsUpToDate and PendingDiff.has_value())
+        Result = IncrementalVerifier.verify(*Value, *PendingDiff);
+      else
+        Result = IncrementalVerifier.verify(*Value);
+
+      PendingDiff.reset();
+      VerifierIsUpToDate = Result;
+      return Result;
+    } else {
+      return Value->verify();
+    }
+  }
 
   GlobalTupleTreeDiff diff(const Global &Other) const override {
     const TupleTreeGlobal &Casted = llvm::cast<TupleTreeGlobal>(Other);
@@ -128,27 +186,61 @@ public:
   llvm::Error applyDiff(const llvm::MemoryBuffer &Diff) override {
     auto MaybeDiff = TupleTreeDiff<Object>::deserialize(Diff.getBuffer());
     if (not MaybeDiff) {
+      invalidateVerifier();
       return MaybeDiff.takeError();
     }
-    return MaybeDiff->apply(Value);
+    return applyDiff(*MaybeDiff);
   }
 
   llvm::Error applyDiff(const TupleTreeDiff<Object> &Diff) {
-    return Diff.apply(Value);
+    recordDiff(Diff);
+    llvm::Error Result = Diff.apply(Value);
+    if (Result)
+      invalidateVerifier();
+    return Result;
   }
 
   llvm::Error applyDiff(const GlobalTupleTreeDiff &Diff) override {
-    return Diff.getAs<Object>()->apply(Value);
+    return applyDiff(*Diff.getAs<Object>());
   }
 
   Global &operator=(const Global &Other) override {
     const TupleTreeGlobal &Casted = llvm::cast<TupleTreeGlobal>(Other);
     Value = Casted.Value;
+    IncrementalVerifier = Casted.IncrementalVerifier;
+    VerifierIsUpToDate = Casted.VerifierIsUpToDate;
+    PendingDiff = Casted.PendingDiff;
     return *this;
   }
 
   const TupleTree<Object> &get() const { return Value; }
-  TupleTree<Object> &get() { return Value; }
+
+  /// Caching references does not alter Value, hence, unlike the non-const
+  /// get, it preserves the verification state
+  void cacheReferences() { Value.cacheReferences(); }
+
+  /// \note the caller might change Value in arbitrary ways, the next
+  ///       verification will be a full one
+  TupleTree<Object> &get() {
+    invalidateVerifier();
+    return Value;
+  }
+
+private:
+  void invalidateVerifier() {
+    VerifierIsUpToDate = false;
+    PendingDiff.reset();
+  }
+
+  void recordDiff(const TupleTreeDiff<Object> &Diff) {
+    if constexpr (IncrementallyVerifiable<Object>) {
+      // Only a single diff since the last verification is tracked
+      if (PendingDiff.has_value())
+        invalidateVerifier();
+      else if (VerifierIsUpToDate)
+        PendingDiff = Diff;
+    }
+  }
 };
 
 } // namespace pipeline
@@ -7,6 +7,7 @@
 #include <memory>
 #include <set>
 #include <string>
+#include <tuple>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -35,9 +36,35 @@ concept HasContract = requires(T P) {
   { llvm::ArrayRef<ContractGroup>(P.getContract()) };
 };
 
+/// \return the number of options declared in the Options tuple of \p T
+template<typename T>
+constexpr size_t optionsCount() {
+  if constexpr (HasOptions<T>)
+    return std::tuple_size_v<std::decay_t<decltype(T::Options)>>;
+  else
+    return 0;
+}
+
+/// \return true if \p Args are containers, except for the last ones, one for
+///         each option declared by \p T, which are not
+template<typename T, typename... Args>
+constexpr bool areContainersFollowedByOptions() {
+  constexpr size_t Options = optionsCount<T>();
+  if constexpr (Options > sizeof...(Args)) {
+    return false;
+  } else {
+    constexpr size_t Containers = sizeof...(Args) - Options;
+    size_t Index = 0;
+    return ((IsContainer<Args> == (Index++ < Containers)) and ...);
+  }
+}
+
+/// Pipes take containers only, except for the options declared in their
+/// Options tuple, which follow the last container
 template<typename T, typename FirstRunArg, typename... Args>
 concept Pipe = Invokable<T, FirstRunArg, Args...>
-               and (IsContainer<Args> and ...) and HasContract<T>;
+               and areContainersFollowedByOptions<T, Args...>()
+               and HasContract<T>;
 
 template<typename T>
 concept HasPrecondition = requires(const T &P) {
@@ -19,16 +19,22 @@ class RegisterPipe : Registry {
 private:
   llvm::StringRef Name;
   PipeT Pipe;
+  std::vector<std::unique_ptr<CLOptionBase>> RegisteredOptions;
 
 public:
   template<typename... Args>
   RegisterPipe(llvm::StringRef Name, Args &&...Arguments) :
-    Name(Name), Pipe(std::forward<Args>(Arguments)...) {}
+    Name(Name),
+    Pipe(std::forward<Args>(Arguments)...),
+    RegisteredOptions(createOptions()) {}
 
   template<typename... Args>
   RegisterPipe(Args &&...Arguments)
     requires HasName<PipeT>
-    : Name(PipeT::Name), Pipe(std::forward<Args>(Arguments)...) {}
+    :
+    Name(PipeT::Name),
+    Pipe(std::forward<Args>(Arguments)...),
+    RegisteredOptions(createOptions()) {}
 
   ~RegisterPipe() override = default;
 
@@ -39,6 +45,14 @@ public:
 
   void registerKinds(KindsRegistry &KindDictionary) override {}
   void libraryInitialization() override {}
+
+private:
+  static std::vector<std::unique_ptr<CLOptionBase>> createOptions() {
+    if constexpr (HasOptions<PipeT>)
+      return createCLOptions<PipeT>(&MainCategory);
+    else
+      return {};
+  }
 };
 
 } // namespace pipeline
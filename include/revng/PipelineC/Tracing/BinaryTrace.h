@@ -0,0 +1,167 @@
+#pragma once
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/LEB128.h"
+
+#include "revng/Support/Assert.h"
+
+// Binary trace format
+// ===================
+//
+// A binary trace starts with the 8-byte `Magic` followed by the format version
+// (ULEB128) and then by a sequence of records. Each record is prefixed by its
+// payload size as a 32-bit little-endian integer, so that a reader can skip
+// records or detect a truncated trace. The first byte of the payload is the
+// `RecordKind`.
+//
+// Integers are encoded as ULEB128, strings are encoded as their size (ULEB128)
+// followed by their raw bytes. Buffers are stored raw, not base64-encoded.
+//
+// CommandStart: ID, StartTime, Name, argument count, then for each argument
+//               its `ArgumentKind` followed by:
+//               * Scalar, Buffer: a string
+//               * Sequence: element count followed by the elements (strings)
+// CommandEnd: ID, Result (string), EndTime
+namespace revng::tracing::binary {
+
+inline constexpr llvm::StringLiteral Magic = "RVNGTRCB";
+inline constexpr uint64_t Version = 1;
+
+enum class RecordKind : uint8_t {
+  CommandStart = 1,
+  CommandEnd = 2,
+};
+
+enum class ArgumentKind : uint8_t {
+  Scalar = 1,
+  Buffer = 2,
+  Sequence = 3,
+};
+
+inline bool isBinaryTrace(llvm::StringRef Data) {
+  return Data.startswith(Magic);
+}
+
+/// Appends records to a string buffer, the buffer can then be handed over to
+/// the output stream as-is
+class RecordEncoder {
+private:
+  std::string &Output;
+  std::optional<size_t> RecordStart;
+
+public:
+  RecordEncoder(std::string &Output) : Output(Output) {}
+
+public:
+  void writeHeader() {
+    Output.append(Magic.data(), Magic.size());
+    writeInteger(Version);
+  }
+
+  void beginRecord(RecordKind Kind) {
+    revng_assert(not RecordStart.has_value());
+    RecordStart = Output.size();
+    // Reserve room for the size, it will be patched in endRecord
+    Output.append(4, '\0');
+    Output.push_back(static_cast<char>(Kind));
+  }
+
+  void endRecord() {
+    revng_assert(RecordStart.has_value());
+    size_t Size = Output.size() - *RecordStart - 4;
+    revng_assert(Size <= UINT32_MAX);
+    for (unsigned I = 0; I < 4; ++I)
+      Output[*RecordStart + I] = static_cast<char>((Size >> (I * 8)) & 0xFF);
+    RecordStart.reset();
+  }
+
+  void writeArgumentKind(ArgumentKind Kind) {
+    Output.push_back(static_cast<char>(Kind));
+  }
+
+  void writeInteger(uint64_t Value) {
+    uint8_t Buffer[16];
+    unsigned Size = llvm::encodeULEB128(Value, Buffer);
+    Output.append(reinterpret_cast<const char *>(Buffer), Size);
+  }
+
+  void writeString(llvm::StringRef String) {
+    writeInteger(String.size());
+    Output.append(String.data(), String.size());
+  }
+};
+
+/// Decodes the fields of a single record (or of the header). All the read
+/// methods return std::nullopt if the data is malformed or truncated.
+class RecordDecoder {
+private:
+  const uint8_t *Cursor;
+  const uint8_t *End;
+
+public:
+  RecordDecoder(llvm::StringRef Data) :
+    Cursor(reinterpret_cast<const uint8_t *>(Data.begin())),
+    End(reinterpret_cast<const uint8_t *>(Data.end())) {}
+
+public:
+  bool atEnd() const { return Cursor == End; }
+
+  size_t consumed(llvm::StringRef Data) const {
+    return Cursor - reinterpret_cast<const uint8_t *>(Data.begin());
+  }
+
+  std::optional<uint8_t> readByte() {
+    if (Cursor == End)
+      return std::nullopt;
+    return *Cursor++;
+  }
+
+  std::optional<uint32_t> readRecordSize() {
+    if (End - Cursor < 4)
+      return std::nullopt;
+
+    uint32_t Result = 0;
+    for (unsigned I = 0; I < 4; ++I)
+      Result |= static_cast<uint32_t>(Cursor[I]) << (I * 8);
+    Cursor += 4;
+    return Result;
+  }
+
+  std::optional<uint64_t> readInteger() {
+    unsigned Size = 0;
+    const char *Error = nullptr;
+    uint64_t Result = llvm::decodeULEB128(Cursor, &Size, End, &Error);
+    if (Error != nullptr)
+      return std::nullopt;
+    Cursor += Size;
+    return Result;
+  }
+
+  std::optional<llvm::StringRef> readString() {
+    std::optional<uint64_t> Size = readInteger();
+    if (not Size.has_value() or *Size > static_cast<uint64_t>(End - Cursor))
+      return std::nullopt;
+
+    llvm::StringRef Result(reinterpret_cast<const char *>(Cursor), *Size);
+    Cursor += *Size;
+    return Result;
+  }
+
+  std::optional<llvm::StringRef> readBytes(size_t Size) {
+    if (Size > static_cast<size_t>(End - Cursor))
+      return std::nullopt;
+
+    llvm::StringRef Result(reinterpret_cast<const char *>(Cursor), Size);
+    Cursor += Size;
+    return Result;
+  }
+};
+
+} // namespace revng::tracing::binary
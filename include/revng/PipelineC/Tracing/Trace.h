@@ -8,8 +8,10 @@
 #include <vector>
 
 #include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/YAMLTraits.h"
 
+#include "revng/PipelineC/Tracing/BinaryTrace.h"
 #include "revng/Support/Assert.h"
 #include "revng/Support/Debug.h"
 
@@ -122,6 +124,50 @@ public:
   std::string TemporaryRoot;
 };
 
+/// Sequential source of commands, used to replay or convert a trace without
+/// necessarily having all of its commands in memory
+class CommandStream {
+public:
+  virtual ~CommandStream() = default;
+
+public:
+  /// Returns the next command or nullptr at the end of the trace. The returned
+  /// pointer is valid until the next invocation.
+  virtual llvm::Expected<const Command *> next() = 0;
+};
+
+/// Reads a binary trace (see BinaryTrace.h) one command at a time
+class BinaryTraceReader : public CommandStream {
+private:
+  std::unique_ptr<llvm::MemoryBuffer> Owned;
+  llvm::StringRef Data;
+  size_t Offset = 0;
+  Command Current;
+
+private:
+  BinaryTraceReader(llvm::StringRef Data,
+                    std::unique_ptr<llvm::MemoryBuffer> Owned = nullptr) :
+    Owned(std::move(Owned)), Data(Data) {}
+
+public:
+  /// Memory-maps \p Path, the file is never loaded in its entirety
+  static llvm::Expected<std::unique_ptr<BinaryTraceReader>>
+  fromFile(const llvm::StringRef Path);
+
+  /// \note \p Buffer needs to outlive the returned reader
+  static llvm::Expected<std::unique_ptr<BinaryTraceReader>>
+  fromBuffer(const llvm::MemoryBuffer &Buffer);
+
+public:
+  llvm::Expected<const Command *> next() override;
+
+private:
+  static llvm::Expected<std::unique_ptr<BinaryTraceReader>>
+  create(llvm::StringRef Data, std::unique_ptr<llvm::MemoryBuffer> Owned);
+
+  llvm::Expected<std::optional<llvm::StringRef>> nextRecord(bool Consume);
+};
+
 struct Trace {
 public:
   uint64_t Version;
@@ -136,10 +182,23 @@ public:
   llvm::Error run(const RunTraceOptions Options = {}) const;
 
 public:
+  /// Loads a trace, either in YAML or in binary form
   static llvm::Expected<Trace> fromFile(const llvm::StringRef Path);
   static llvm::Expected<Trace> fromBuffer(const llvm::MemoryBuffer &Buffer);
+  static llvm::Expected<Trace> fromStream(CommandStream &Stream);
 };
 
+/// Executes all the commands provided by \p Stream
+llvm::Error run(CommandStream &Stream, const RunTraceOptions Options = {});
+
+/// Executes the trace at \p Path. Binary traces are replayed as they are read,
+/// YAML traces are parsed beforehand.
+llvm::Error runFile(const llvm::StringRef Path,
+                    const RunTraceOptions Options = {});
+
+/// Prints the commands provided by \p Stream using the YAML trace format
+llvm::Error writeYAML(CommandStream &Stream, llvm::raw_ostream &OS);
+
 } // namespace revng::tracing
 
 template<>
@@ -203,6 +262,13 @@ inline llvm::Expected<Trace> Trace::fromFile(const llvm::StringRef Path) {
 
 inline llvm::Expected<Trace>
 Trace::fromBuffer(const llvm::MemoryBuffer &Buffer) {
+  if (binary::isBinaryTrace(Buffer.getBuffer())) {
+    auto MaybeReader = BinaryTraceReader::fromBuffer(Buffer);
+    if (not MaybeReader)
+      return MaybeReader.takeError();
+    return Trace::fromStream(**MaybeReader);
+  }
+
   llvm::yaml::Input YAMLReader(Buffer);
   Trace Trace;
   YAMLReader >> Trace;
@@ -230,6 +296,23 @@ Trace::fromBuffer(const llvm::MemoryBuffer &Buffer) {
   return Trace;
 }
 
+inline llvm::Expected<Trace> Trace::fromStream(CommandStream &Stream) {
+  Trace Trace;
+  Trace.Version = 1;
+  while (true) {
+    auto MaybeCommand = Stream.next();
+    if (not MaybeCommand)
+      return MaybeCommand.takeError();
+
+    if (*MaybeCommand == nullptr)
+      break;
+
+    Trace.Commands.push_back(**MaybeCommand);
+  }
+
+  return Trace;
+}
+
 inline void Command::dump(llvm::raw_ostream &Stream) const {
   Stream << "\n";
   llvm::yaml::Output YAMLOutput(Stream);
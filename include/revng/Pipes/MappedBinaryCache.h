@@ -0,0 +1,67 @@
+#pragma once
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <memory>
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Chrono.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem/UniqueID.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+#include "revng/Pipeline/Context.h"
+
+namespace revng::pipes {
+
+inline constexpr const char *MappedBinaryCacheName = "MappedBinaryCache";
+
+/// Keeps a read-only, memory-mapped view of each input binary, so that all the
+/// pipes reading the same file share the page cache instead of copying it on
+/// the heap.
+///
+/// Entries are keyed by path and are mapped again only if the file on disk has
+/// been replaced or modified since the last request. The standard input (`-`)
+/// and the files which are not regular files, such as pipes, are read every
+/// time they are requested and are never cached.
+///
+/// \warning A mapped file must be replaced, not changed in place: the buffers
+///          handed out before see the changes and, if the file is truncated,
+///          reading the pages past its new end raises SIGBUS. Replacing the
+///          file, e.g., by writing a new one and renaming it over the original
+///          one, is safe.
+class MappedBinaryCache {
+public:
+  using Buffer = std::shared_ptr<const llvm::MemoryBuffer>;
+
+private:
+  struct Entry {
+    llvm::sys::fs::UniqueID ID;
+    uint64_t Size = 0;
+    llvm::sys::TimePoint<> LastModification;
+    Buffer Data;
+  };
+
+private:
+  llvm::StringMap<Entry> Entries;
+
+public:
+  /// \return the contents of the file at \p Path. The result remains valid
+  ///         even if the entry is later invalidated.
+  llvm::Expected<Buffer> get(llvm::StringRef Path);
+
+  void clear() { Entries.clear(); }
+
+  /// Map \p Path without going through a cache. `-` is the standard input.
+  static llvm::Expected<Buffer> map(llvm::StringRef Path);
+};
+
+/// \return the contents of the binary at \p Path, using the cache registered
+///         in \p Ctx, if any.
+llvm::Expected<MappedBinaryCache::Buffer>
+getBinaryFromContext(const pipeline::Context &Ctx, llvm::StringRef Path);
+
+} // namespace revng::pipes
@@ -4,6 +4,8 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <utility>
+
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 
@@ -26,8 +28,8 @@ inline const TupleTree<model::Binary> &
 getModelFromContext(const pipeline::Context &Ctx) {
   using Wrapper = ModelGlobal;
   const auto &Model = llvm::cantFail(Ctx.getGlobal<Wrapper>(ModelGlobalName));
-  Model->get().cacheReferences();
-  return Model->get();
+  Model->cacheReferences();
+  return std::as_const(*Model).get();
 }
 
 inline TupleTree<model::Binary> &
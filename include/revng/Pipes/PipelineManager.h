@@ -13,6 +13,7 @@
 
 #include "revng/Pipeline/Context.h"
 #include "revng/Pipeline/Runner.h"
+#include "revng/Pipes/MappedBinaryCache.h"
 #include "revng/Pipes/ModelGlobal.h"
 
 namespace revng::pipes {
@@ -33,6 +34,7 @@ private:
   /// method that returns a expected<PipelineManager>, this is the only way to
   /// ensure this is correct.
   std::unique_ptr<llvm::LLVMContext> Context;
+  std::unique_ptr<MappedBinaryCache> Binaries;
   std::unique_ptr<pipeline::Context> PipelineContext;
   std::unique_ptr<pipeline::Loader> Loader;
   std::unique_ptr<pipeline::Runner> Runner;
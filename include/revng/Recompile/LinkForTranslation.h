@@ -4,6 +4,8 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include "llvm/Support/MemoryBuffer.h"
+
 #include "revng/Model/Binary.h"
 
 void linkForTranslation(const model::Binary &Model,
@@ -11,6 +13,14 @@ void linkForTranslation(const model::Binary &Model,
                         llvm::StringRef ObjectFilePath,
                         llvm::StringRef OutputBinaryPath);
 
+/// Same as the previous overload, but the contents of the input binary have
+/// already been loaded in \p InputBinary
+void linkForTranslation(const model::Binary &Model,
+                        llvm::StringRef InputBinaryPath,
+                        const llvm::MemoryBuffer &InputBinary,
+                        llvm::StringRef ObjectFilePath,
+                        llvm::StringRef OutputBinaryPath);
+
 void printLinkForTranslationCommands(llvm::raw_ostream &OS,
                                      const model::Binary &Model,
                                      llvm::StringRef InputBinary,
@@ -73,6 +73,7 @@ inline void eraseFromParent(llvm::Value *V) {
 constexpr const char *FunctionEntryMDNName = "revng.function.entry";
 constexpr const char *JTReasonMDName = "revng.jt.reasons";
 constexpr const char *FunctionMetadataMDName = "revng.function.metadata";
+constexpr const char *SegmentsHashName = "revng.segments.hash";
 
 template<typename T>
 inline bool contains(T Range, typename T::value_type V) {
@@ -9,11 +9,23 @@
 #include <vector>
 
 #include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Error.h"
 #include "llvm/Support/Path.h"
 
 std::string getCurrentExecutableFullPath();
 std::string getCurrentRoot();
 
+/// \return the path of \p FileName in the \p Directory subdirectory of the
+///         revng directory in the user cache directory, if there's one
+std::optional<std::string> getCachePath(llvm::StringRef Directory,
+                                        llvm::StringRef FileName);
+
+/// Write \p Data to \p Path, creating its parent directories if necessary
+///
+/// The data is written to a temporary file which is then renamed, so that
+/// concurrent readers never observe a partially written file.
+llvm::Error writeFileAtomically(llvm::StringRef Path, llvm::StringRef Data);
+
 template<typename... T>
   requires(std::is_convertible_v<T, llvm::StringRef> && ...)
 std::string joinPath(const llvm::StringRef First, const T... Parts) {
@@ -4,6 +4,7 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <chrono>
 #include <csignal>
 #include <cstdlib>
 #include <map>
@@ -175,6 +176,26 @@ private:
   double Sum;
 };
 
+/// Records into a RunningStatistics the milliseconds elapsed between its
+/// construction and its destruction
+class ScopedRunningStatisticsTimer {
+private:
+  using Clock = std::chrono::steady_clock;
+
+private:
+  RunningStatistics &Statistics;
+  Clock::time_point Start;
+
+public:
+  ScopedRunningStatisticsTimer(RunningStatistics &Statistics) :
+    Statistics(Statistics), Start(Clock::now()) {}
+
+  ~ScopedRunningStatisticsTimer() {
+    std::chrono::duration<double, std::milli> Elapsed = Clock::now() - Start;
+    Statistics.push(Elapsed.count());
+  }
+};
+
 // TODO: this is duplicated
 template<typename T, typename... ArgTypes>
 inline std::array<T, sizeof...(ArgTypes)> make_array(ArgTypes &&...Args) {
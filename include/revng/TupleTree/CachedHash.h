@@ -0,0 +1,48 @@
+#pragma once
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <cstdint>
+
+#include "revng/Support/Assert.h"
+
+/// Cache of the structural hash of a field of a TupleTree node (see
+/// hashTupleTree).
+///
+/// The node resets it every time the field is accessed through a non-const
+/// accessor, since the caller might change it. However, a reference obtained
+/// through a non-const accessor can still be used to change the field after
+/// the hash has been computed, leaving the cache stale. Therefore, diff checks
+/// the caches before trusting them (see isCachedFieldHashStale).
+///
+/// It does not take part in comparisons.
+class CachedHash {
+private:
+  mutable uint64_t Value = 0;
+
+public:
+  bool operator==(const CachedHash &) const { return true; }
+
+public:
+  bool empty() const { return Value == 0; }
+
+  uint64_t get() const {
+    revng_assert(not empty());
+    return Value;
+  }
+
+  /// \note 0 is reserved for the empty cache
+  void set(uint64_t NewValue) const { Value = normalize(NewValue); }
+
+  /// \return true if the cache holds \p Hash
+  bool matches(uint64_t Hash) const {
+    return not empty() and Value == normalize(Hash);
+  }
+
+  void reset() { Value = 0; }
+
+private:
+  static uint64_t normalize(uint64_t Hash) { return Hash == 0 ? 1 : Hash; }
+};
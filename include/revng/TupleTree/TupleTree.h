@@ -9,6 +9,7 @@
 #include <optional>
 #include <set>
 #include <type_traits>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -26,6 +27,7 @@
 #include "revng/Support/Debug.h"
 #include "revng/Support/YAMLTraits.h"
 #include "revng/TupleTree/TupleTreeCompatible.h"
+#include "revng/TupleTree/TupleTreeHash.h"
 #include "revng/TupleTree/TupleTreePath.h"
 #include "revng/TupleTree/TupleTreeReference.h"
 #include "revng/TupleTree/Visits.h"
@@ -166,9 +168,19 @@ public:
 public:
   bool verify() const debug_function { return verifyReferences(); }
 
+  /// Computes the hashes of all the fields of the tree that can cache them and
+  /// are not cached yet (see hashTupleTree).
+  ///
+  /// TupleTreeDiff skips the fields whose cached hashes match and are still
+  /// correct. Since copying the tree copies the cached hashes too, diffing a
+  /// tree against a copy of itself taken after this call will only compare
+  /// element by element the subtrees that have changed in the meantime.
+  void cacheHashes() const { hashTupleTree(*Root); }
+
 private:
   void initializeUncachedReferences() {
-    visitReferences([this](auto &Element) {
+    revng_assert(not AllReferencesAreCached);
+    visitReferencesInternal([this](auto &Element) {
       Element.Root = Root.get();
       Element.evictCachedTarget();
     });
@@ -178,7 +190,9 @@ private:
 public:
   void initializeReferences() {
     revng_assert(not AllReferencesAreCached);
-    visitReferences([this](auto &Element) { Element.Root = Root.get(); });
+    visitReferencesInternal([this](auto &Element) {
+      Element.Root = Root.get();
+    });
   }
 
   void cacheReferences() {
@@ -187,6 +201,8 @@ public:
     AllReferencesAreCached = true;
   }
 
+  bool referencesAreCached() const { return AllReferencesAreCached; }
+
   void evictCachedReferences() {
     if (AllReferencesAreCached)
       visitReferencesInternal([](auto &E) { E.evictCachedTarget(); });
@@ -219,22 +235,33 @@ private:
   void visitImpl(typename TupleTreeVisitor<T>::VisitorBase &Pre,
                  typename TupleTreeVisitor<T>::VisitorBase &Post);
 
+  /// Visits the references for bookkeeping purposes, i.e., to change their
+  /// root or their cached target, which do not affect their value.
+  ///
+  /// The tree is visited through the const accessors, so that the cached hashes
+  /// of the fields (see cacheHashes) are preserved.
   template<typename L>
   void visitReferencesInternal(L &&InnerVisitor) {
-    auto Visitor = [&InnerVisitor](auto &Element) {
+    auto Visitor = [&InnerVisitor](const auto &Element) {
       using type = std::remove_cvref_t<decltype(Element)>;
       if constexpr (StrictSpecializationOf<type, TupleTreeReference>)
-        std::invoke(std::forward<L>(InnerVisitor), Element);
+        std::invoke(std::forward<L>(InnerVisitor), const_cast<type &>(Element));
     };
 
-    visit(Visitor, [](auto &) {});
+    std::as_const(*this).visit(Visitor, [](const auto &) {});
   }
 
 public:
   template<typename L>
   void visitReferences(L &&InnerVisitor) {
     revng_assert(not AllReferencesAreCached);
-    visitReferencesInternal(std::forward<L>(InnerVisitor));
+    auto Visitor = [&InnerVisitor](auto &Element) {
+      using type = std::remove_cvref_t<decltype(Element)>;
+      if constexpr (StrictSpecializationOf<type, TupleTreeReference>)
+        std::invoke(std::forward<L>(InnerVisitor), Element);
+    };
+
+    visit(Visitor, [](auto &) {});
   }
 
   template<typename L>
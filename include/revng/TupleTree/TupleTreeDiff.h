@@ -4,13 +4,16 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <algorithm>
 #include <any>
+#include <iterator>
 #include <optional>
 #include <set>
 #include <utility>
 #include <variant>
 #include <vector>
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/WithColor.h"
 #include "llvm/Support/raw_os_ostream.h"
@@ -20,9 +23,11 @@
 #include "revng/ADT/STLExtras.h"
 #include "revng/ADT/ZipMapIterator.h"
 #include "revng/Support/Assert.h"
+#include "revng/Support/Debug.h"
 #include "revng/TupleTree/DiffError.h"
 #include "revng/TupleTree/TupleLikeTraits.h"
 #include "revng/TupleTree/TupleTree.h"
+#include "revng/TupleTree/TupleTreeHash.h"
 #include "revng/TupleTree/TupleTreePath.h"
 
 template<typename T>
@@ -334,15 +339,37 @@ private:
   void diffTuple(const T &LHS, const T &RHS) {
     if constexpr (I < std::tuple_size_v<T>) {
 
-      Stack.push_back(size_t(I));
-      diffImpl(get<I>(LHS), get<I>(RHS));
-      Stack.pop_back();
+      // Skip the fields whose cached hashes (see TupleTree::cacheHashes) tell
+      // us they are identical, once we checked that they are still correct.
+      // In particular, diffing a tree against a copy of itself only hashes the
+      // unchanged subtrees instead of comparing them element by element.
+      if (not haveSameCachedFieldHash<I>(LHS, RHS)
+          or not areCachedFieldHashesTrusted<I>(LHS, RHS)) {
+        Stack.push_back(size_t(I));
+        diffImpl(get<I>(LHS), get<I>(RHS));
+        Stack.pop_back();
+      }
 
       // Recur
       diffTuple<I + 1>(LHS, RHS);
     }
   }
 
+  /// Caches are reset only by non-const accessors, a reference obtained before
+  /// computing the hashes and used to change the tree afterwards leaves a stale
+  /// hash behind. Therefore, check them by hashing again the whole field.
+  template<size_t I, typename T>
+  static bool areCachedFieldHashesTrusted(const T &LHS, const T &RHS) {
+    bool Stale = isCachedFieldHashStale<I>(LHS)
+                 or isCachedFieldHashStale<I>(RHS);
+    if (Stale) {
+      llvm::StringRef Name = TupleLikeTraits<T>::Name;
+      revng_log(VerifyLog, "Ignoring a stale cached hash in " << Name);
+    }
+
+    return not Stale;
+  }
+
   template<StrictSpecializationOf<UpcastablePointer> T>
   void diffImpl(const T &LHS, const T &RHS) {
     LHS.upcast([&](auto &LHSUpcasted) {
@@ -415,11 +442,31 @@ template<TupleTreeRootLike T>
 struct ApplyDiffVisitor {
 public:
   using Change = typename TupleTreeDiff<T>::Change;
-  const Change *C;
-  size_t ChangeIndex;
+
+private:
+  /// Consecutive changes targeting the same path, applied together
+  llvm::ArrayRef<Change> Batch;
+  size_t FirstIndex;
+  T *Root;
   revng::DiffError *EL;
 
+  /// The change of the batch currently being applied
+  const Change *C = nullptr;
+  size_t ChangeIndex = 0;
+
+public:
+  ApplyDiffVisitor(llvm::ArrayRef<Change> Batch,
+                   size_t FirstIndex,
+                   T *Root,
+                   revng::DiffError *EL) :
+    Batch(Batch), FirstIndex(FirstIndex), Root(Root), EL(EL) {}
+
 private:
+  void select(size_t Index) {
+    C = &Batch[Index];
+    ChangeIndex = FirstIndex + Index;
+  }
+
   void generateError() { generateError(""); }
 
   void generateError(const llvm::StringRef Reason,
@@ -434,6 +481,24 @@ private:
                   revng::DiffLocation(ChangeIndex, Kind));
   }
 
+  /// Make the references in \p Subtree, which has just been copied from the
+  /// diff, point to the tree the diff is being applied to. The references in
+  /// the rest of the tree are left untouched.
+  template<typename S>
+  void initializeReferences(const S &Subtree) {
+    auto Visitor = [this](const auto &Element) {
+      using type = std::remove_cvref_t<decltype(Element)>;
+      if constexpr (StrictSpecializationOf<type, TupleTreeReference>) {
+        // Changing the root does not affect the value of the reference, go
+        // through const accessors so that the cached hashes are preserved.
+        // The new reference has no cached target, too.
+        auto &Reference = const_cast<type &>(Element);
+        Reference = type(Root, Reference.path());
+      }
+    };
+    visitTupleTree(Subtree, Visitor, [](const auto &) {});
+  }
+
 public:
   template<typename TupleT, size_t I, typename K>
   void visitTupleElement(K &Element) {
@@ -447,42 +512,83 @@ public:
 
   template<revng::detail::SetOrKOC S>
   void visit(S &M) {
-    // This visitor handles subtree additions/deletions. Here we either have a
-    // New or Old key to add/remove.
-    if (C->Old == std::nullopt && C->New == std::nullopt) {
-      generateError("Both 'Remove' and 'Add' are not present",
-                    revng::DiffLocation::KindType::All);
-      return;
+    // This visitor handles subtree additions/deletions. Here, each change of
+    // the batch has either a New or an Old key to add/remove.
+    using value_type = typename S::value_type;
+    using KOT = KeyedObjectTraits<value_type>;
+    using key_type = std::remove_cvref_t<decltype(KOT::key(
+      std::declval<value_type>()))>;
+
+    std::set<key_type> ToRemove;
+    std::set<key_type> ToAdd;
+    std::vector<const value_type *> Additions;
+    for (size_t I = 0; I < Batch.size(); ++I) {
+      select(I);
+
+      if (C->Old == std::nullopt && C->New == std::nullopt) {
+        generateError("Both 'Remove' and 'Add' are not present",
+                      revng::DiffLocation::KindType::All);
+        continue;
+      }
+      if (C->Old != std::nullopt && C->New != std::nullopt) {
+        generateError("Both 'Remove' and 'Add' are not present",
+                      revng::DiffLocation::KindType::All);
+        continue;
+      }
+
+      if (C->Old != std::nullopt) {
+        key_type Key = KOT::key(std::get<value_type>(*C->Old));
+        if (M.find(Key) == M.end() or not ToRemove.insert(Key).second)
+          generateError("Subtree removal failed",
+                        revng::DiffLocation::KindType::Old);
+      } else {
+        // Adding an element which is already there, or adding it twice, is an
+        // error: the element is not added (again)
+        const value_type &New = std::get<value_type>(*C->New);
+        key_type Key = KOT::key(New);
+        if (M.find(Key) != M.end() or not ToAdd.insert(Key).second)
+          generateError("Subtree addition failed",
+                        revng::DiffLocation::KindType::New);
+        else
+          Additions.push_back(&New);
+      }
     }
-    if (C->Old != std::nullopt && C->New != std::nullopt) {
-      generateError("Both 'Remove' and 'Add' are not present",
-                    revng::DiffLocation::KindType::All);
-      return;
+
+    // Batches contain either additions or removals, removing all the elements
+    // in a single pass keeps removing many elements from a vector linear
+    if (not ToRemove.empty()) {
+      if constexpr (std::random_access_iterator<typename S::iterator>) {
+        auto ShouldRemove = [&ToRemove](const value_type &V) {
+          return ToRemove.contains(KOT::key(V));
+        };
+        M.erase(std::remove_if(M.begin(), M.end(), ShouldRemove), M.end());
+      } else {
+        for (const key_type &Key : ToRemove)
+          M.erase(Key);
+      }
     }
 
-    using value_type = typename S::value_type;
-    using KOT = KeyedObjectTraits<value_type>;
-    using key_type = decltype(KOT::key(std::declval<value_type>()));
-
-    size_t OldSize = M.size();
-    if (C->Old != std::nullopt) {
-      key_type Key = KOT::key(std::get<value_type>(*C->Old));
-      auto End = M.end();
-      auto CompareKeys = [Key](value_type &V) { return KOT::key(V) == Key; };
-      auto FirstToDelete = std::remove_if(M.begin(), End, CompareKeys);
-      M.erase(FirstToDelete, End);
-      if (OldSize - 1 != M.size())
-        generateError("Subtree removal failed",
-                      revng::DiffLocation::KindType::Old);
-    } else if (C->New != std::nullopt) {
-      // TODO: assert not there already
-      addToContainer(M, std::get<value_type>(*C->New));
-      if (OldSize + 1 != M.size())
+    if (not Additions.empty()) {
+      // The keys of Additions are all new and distinct, so the batch inserter
+      // never has to assign an existing element
+      size_t OldSize = M.size();
+      if constexpr (requires { M.batch_insert_or_assign(); }) {
+        auto Inserter = M.batch_insert_or_assign();
+        for (const value_type *Addition : Additions)
+          Inserter.insert_or_assign(*Addition);
+      } else {
+        for (const value_type *Addition : Additions)
+          addToContainer(M, *Addition);
+      }
+
+      if (M.size() != OldSize + Additions.size()) {
+        select(Batch.size() - 1);
         generateError("Subtree addition failed",
                       revng::DiffLocation::KindType::New);
-    } else {
-      generateError("Arrived at an impossible branch",
-                    revng::DiffLocation::KindType::Path);
+      }
+
+      for (const key_type &Key : ToAdd)
+        initializeReferences(*M.find(Key));
     }
   }
 
@@ -491,54 +597,100 @@ public:
     // This visitor handles key changes, so both Old and New are present. This
     // will check that the tree contains Old and then replace its contents with
     // New
-    if (C->Old == std::nullopt || C->New == std::nullopt) {
-      if (C->Old == std::nullopt)
-        generateError("Missing 'Remove' key",
-                      revng::DiffLocation::KindType::Old);
-      if (C->New == std::nullopt)
-        generateError("Missing 'Add' key", revng::DiffLocation::KindType::New);
-      return;
-    }
+    for (size_t I = 0; I < Batch.size(); ++I) {
+      select(I);
+
+      if (C->Old == std::nullopt || C->New == std::nullopt) {
+        if (C->Old == std::nullopt)
+          generateError("Missing 'Remove' key",
+                        revng::DiffLocation::KindType::Old);
+        if (C->New == std::nullopt)
+          generateError("Missing 'Add' key",
+                        revng::DiffLocation::KindType::New);
+        continue;
+      }
 
-    auto &Old = std::get<S>(*C->Old);
-    auto &New = std::get<S>(*C->New);
+      auto &Old = std::get<S>(*C->Old);
+      auto &New = std::get<S>(*C->New);
 
-    if (Old != M) {
-      generateError("'Remove' does not match the contents of the Tuple Tree",
-                    revng::DiffLocation::KindType::Old);
-      return;
-    }
+      if (Old != M) {
+        generateError("'Remove' does not match the contents of the Tuple "
+                      "Tree",
+                      revng::DiffLocation::KindType::Old);
+        continue;
+      }
 
-    M = New;
+      M = New;
+      initializeReferences(M);
+    }
   }
 };
 
+/// \return true if \p Next can be applied along with \p First, i.e., they
+///         both add or both remove an element of the same container
+template<typename ChangeT>
+bool isSameBatch(const ChangeT &First, const ChangeT &Next) {
+  bool FirstIsAddition = First.Old == std::nullopt and First.New.has_value();
+  bool FirstIsRemoval = First.New == std::nullopt and First.Old.has_value();
+  bool NextIsAddition = Next.Old == std::nullopt and Next.New.has_value();
+  bool NextIsRemoval = Next.New == std::nullopt and Next.Old.has_value();
+  return First.Path == Next.Path
+         and ((FirstIsAddition and NextIsAddition)
+              or (FirstIsRemoval and NextIsRemoval));
+}
+
 } // namespace tupletreediff::detail
 
+/// Changes are applied in order, consecutive additions (or removals) of
+/// elements to the same container are applied together.
+///
+/// Only the references introduced by the diff are initialized, the other ones
+/// are expected to already point to \p M. If the references of \p M are
+/// cached, they are evicted and all of them are initialized again.
 template<TupleTreeRootLike T>
 inline llvm::Error TupleTreeDiff<T>::apply(TupleTree<T> &M) const {
+  using namespace tupletreediff::detail;
+
+  // Cached targets might point to elements the diff removes
+  bool ReferencesWereCached = M.referencesAreCached();
+  M.evictCachedReferences();
+
   auto Error = std::make_unique<revng::DiffError>();
+  llvm::ArrayRef<Change> AllChanges = Changes;
   size_t Index = 0;
-  for (const Change &C : Changes) {
+  while (Index < AllChanges.size()) {
+    const Change &C = AllChanges[Index];
 
     if (C.Path.size() == 0) {
       Error
         ->addReason("Could not deserialize path",
                     revng::DiffLocation(Index,
                                         revng::DiffLocation::KindType::Path));
+      ++Index;
       continue;
     }
-    tupletreediff::detail::ApplyDiffVisitor<T> ADV{ &C, Index, Error.get() };
 
-    if (not callByPath(ADV, C.Path, *M, *pathAsString<T>(C.Path)))
-      Error
-        ->addReason("Path not present",
-                    revng::DiffLocation(Index,
-                                        revng::DiffLocation::KindType::Path));
-    Index++;
+    size_t BatchSize = 1;
+    while (Index + BatchSize < AllChanges.size()
+           and isSameBatch(C, AllChanges[Index + BatchSize]))
+      ++BatchSize;
+
+    llvm::ArrayRef<Change> Batch = AllChanges.slice(Index, BatchSize);
+    ApplyDiffVisitor<T> ADV(Batch, Index, M.get(), Error.get());
+
+    if (not callByPath(ADV, C.Path, *M)) {
+      for (size_t I = Index; I < Index + BatchSize; ++I) {
+        using KindType = revng::DiffLocation::KindType;
+        Error->addReason("Path not present",
+                         revng::DiffLocation(I, KindType::Path));
+      }
+    }
+
+    Index += BatchSize;
   }
 
-  M.evictCachedReferences();
-  M.initializeReferences();
+  if (ReferencesWereCached)
+    M.initializeReferences();
+
   return revng::DiffError::makeError(std::move(Error));
 }
@@ -0,0 +1,150 @@
+#pragma once
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <type_traits>
+
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/StringRef.h"
+
+#include "revng/ADT/Concepts.h"
+#include "revng/ADT/KeyedObjectContainer.h"
+#include "revng/ADT/UpcastablePointer.h"
+#include "revng/Support/YAMLTraits.h"
+#include "revng/TupleTree/CachedHash.h"
+#include "revng/TupleTree/TupleLikeTraits.h"
+
+/// \return the cache of the structural hash of the I-th field of \p Value, or
+///         nullptr if such field does not have one
+template<size_t I, TupleLike T>
+const CachedHash *getCachedFieldHash(const T &Value) {
+  if constexpr (requires { cachedHash<I>(Value); })
+    return cachedHash<I>(Value);
+  else
+    return nullptr;
+}
+
+/// \return true if the I-th field of \p LHS and \p RHS have been hashed and
+///         their hashes match, i.e., they can be considered identical
+template<size_t I, TupleLike T>
+bool haveSameCachedFieldHash(const T &LHS, const T &RHS) {
+  const CachedHash *LHSHash = getCachedFieldHash<I>(LHS);
+  const CachedHash *RHSHash = getCachedFieldHash<I>(RHS);
+  return LHSHash != nullptr and RHSHash != nullptr and not LHSHash->empty()
+         and not RHSHash->empty() and LHSHash->get() == RHSHash->get();
+}
+
+template<typename T>
+uint64_t hashTupleTree(const T &Value);
+
+template<typename T>
+uint64_t hashTupleTreeUncached(const T &Value);
+
+namespace tupletreehash::detail {
+
+inline uint64_t toUInt64(llvm::hash_code Hash) {
+  return static_cast<size_t>(Hash);
+}
+
+template<typename T>
+uint64_t hashLeaf(const T &Value) {
+  if constexpr (std::is_enum_v<T>) {
+    using Underlying = std::underlying_type_t<T>;
+    return toUInt64(llvm::hash_value(static_cast<Underlying>(Value)));
+  } else if constexpr (std::is_integral_v<T>) {
+    return toUInt64(llvm::hash_value(Value));
+  } else if constexpr (std::is_convertible_v<const T &, llvm::StringRef>) {
+    return toUInt64(llvm::hash_value(llvm::StringRef(Value)));
+  } else if constexpr (requires { std::string(Value.toString()); }) {
+    return toUInt64(llvm::hash_value(Value.toString()));
+  } else {
+    return toUInt64(llvm::hash_value(serializeToString(Value)));
+  }
+}
+
+template<bool UseCaches, size_t I = 0, TupleLike T>
+llvm::hash_code hashFields(const T &Value, llvm::hash_code Result);
+
+template<bool UseCaches, typename T>
+uint64_t hashImpl(const T &Value) {
+  if constexpr (UpcastablePointerLike<T>) {
+    if (Value.get() == nullptr)
+      return 0;
+
+    uint64_t Result = 0;
+    Value.upcast([&Result](const auto &Upcasted) {
+      Result = hashImpl<UseCaches>(Upcasted);
+    });
+    return Result;
+  } else if constexpr (KeyedObjectContainer<T>
+                       or StrictSpecializationOf<T, std::set>) {
+    llvm::hash_code Result = llvm::hash_value(Value.size());
+    for (const auto &Element : Value)
+      Result = llvm::hash_combine(Result, hashImpl<UseCaches>(Element));
+    return toUInt64(Result);
+  } else if constexpr (TupleLike<T>) {
+    llvm::hash_code Seed = llvm::hash_value(TupleLikeTraits<T>::Name);
+    return toUInt64(hashFields<UseCaches>(Value, Seed));
+  } else {
+    return hashLeaf(Value);
+  }
+}
+
+template<bool UseCaches, size_t I, TupleLike T>
+llvm::hash_code hashFields(const T &Value, llvm::hash_code Result) {
+  if constexpr (I < std::tuple_size_v<T>) {
+    uint64_t FieldHash = 0;
+    const CachedHash *Cache = getCachedFieldHash<I>(Value);
+    if (UseCaches and Cache != nullptr) {
+      if (Cache->empty())
+        Cache->set(hashImpl<UseCaches>(get<I>(Value)));
+      FieldHash = Cache->get();
+    } else {
+      FieldHash = hashImpl<UseCaches>(get<I>(Value));
+    }
+
+    return hashFields<UseCaches, I + 1>(Value,
+                                        llvm::hash_combine(Result, FieldHash));
+  } else {
+    return Result;
+  }
+}
+
+} // namespace tupletreehash::detail
+
+/// Computes a structural hash of \p Value, i.e., a hash depending on the value
+/// of all of its leaves.
+///
+/// The hashes of the fields having a CachedHash are computed only if their
+/// cache is empty, and are then recorded there. Hashes are computed with
+/// llvm::hash_code, they are meant to be compared only within a process.
+template<typename T>
+uint64_t hashTupleTree(const T &Value) {
+  return tupletreehash::detail::hashImpl<true>(Value);
+}
+
+/// Same as hashTupleTree, but the hashes are all computed from scratch, and
+/// the caches are neither read nor written
+template<typename T>
+uint64_t hashTupleTreeUncached(const T &Value) {
+  return tupletreehash::detail::hashImpl<false>(Value);
+}
+
+/// \return true if the I-th field of \p Value has a cached hash which does not
+///         match its current value.
+///
+/// This happens if the field has been changed, through a reference obtained
+/// from a non-const accessor, after its hash has been cached.
+template<size_t I, TupleLike T>
+bool isCachedFieldHashStale(const T &Value) {
+  const CachedHash *Cache = getCachedFieldHash<I>(Value);
+  if (Cache == nullptr or Cache->empty())
+    return false;
+
+  return not Cache->matches(hashTupleTreeUncached(get<I>(Value)));
+}
@@ -4,6 +4,8 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <utility>
+
 #include "revng/TupleTree/TupleTree.h"
 
 // Note: the purpose of this file is to make sure we opt-in using
@@ -17,7 +19,8 @@ using ConstVisitor = typename TupleTreeVisitor<T>::ConstVisitorBase;
 template<TupleTreeCompatible T>
 void TupleTree<T>::visitImpl(detail::ConstVisitor<T> &Pre,
                              detail::ConstVisitor<T> &Post) const {
-  visitTupleTree(*Root, Pre, Post);
+  // Go through the const accessors, non-const ones reset the cached hashes
+  visitTupleTree(std::as_const(*Root), Pre, Post);
 }
 
 template<TupleTreeCompatible T>
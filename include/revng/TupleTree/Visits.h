@@ -54,8 +54,7 @@ void visitTupleTree(Visitor &V, T &Obj) {
 template<typename Visitor, KeyedObjectContainer T>
 void visitTupleTree(Visitor &V, T &Obj) {
   V.PreVisit(Obj);
-  using value_type = typename T::value_type;
-  for (value_type &Element : Obj) {
+  for (auto &Element : Obj) {
     visitTupleTree(V, Element);
   }
   V.PostVisit(Obj);
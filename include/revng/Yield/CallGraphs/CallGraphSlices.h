@@ -4,12 +4,69 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/ArrayRef.h"
+
 #include "revng/Yield/Graph.h"
 
 class MetaAddress;
 
 namespace yield::calls {
 
+/// Indices over a call graph that allow extracting many slices of it without
+/// looking at the parts of the graph that do not belong to them.
+///
+/// Nodes are given a dense ID and edges are stored in both directions in CSR
+/// layout.
+///
+/// \note the index refers to the nodes of `Input`, which must outlive it.
+class SliceIndex {
+public:
+  using NodeID = uint32_t;
+  using NodeView = const Graph::Node *;
+
+  enum class Direction { Callees, Callers };
+
+private:
+  std::vector<NodeView> Nodes;
+
+  /// Sorted by address, used to find the slice points
+  std::vector<std::pair<BasicBlockID, NodeID>> Lookup;
+
+  std::vector<uint32_t> SuccessorOffsets;
+  std::vector<NodeID> Successors;
+  std::vector<uint32_t> PredecessorOffsets;
+  std::vector<NodeID> Predecessors;
+
+public:
+  explicit SliceIndex(const Graph &Input);
+
+public:
+  size_t size() const { return Nodes.size(); }
+  NodeView node(NodeID ID) const { return Nodes[ID]; }
+  std::optional<NodeID> find(const BasicBlockID &Address) const;
+
+  /// \return the nodes following \p ID when moving in direction \p D
+  llvm::ArrayRef<NodeID> children(NodeID ID, Direction D) const {
+    if (D == Direction::Callees)
+      return slice(SuccessorOffsets, Successors, ID);
+    else
+      return slice(PredecessorOffsets, Predecessors, ID);
+  }
+
+private:
+  static llvm::ArrayRef<NodeID> slice(const std::vector<uint32_t> &Offsets,
+                                      const std::vector<NodeID> &Edges,
+                                      NodeID ID) {
+    return llvm::ArrayRef(Edges).slice(Offsets[ID],
+                                       Offsets[ID + 1] - Offsets[ID]);
+  }
+};
+
 /// Produces a forwards facing slice of the graph starting from a single node.
 ///
 /// Such a slice guarantees that:
@@ -35,15 +92,23 @@ namespace yield::calls {
 /// - There are no backwards facing edges (the targets of those are also
 ///   replaced by fake "reference" nodes).
 ///
-/// \note: this makes a copy of the graph, as such `Input` is not affected.
-Graph makeCalleeTree(const Graph &Input,
-                     const BasicBlockID &SlicePoint = BasicBlockID());
+/// If \p MaxDepth is set, nodes farther than \p MaxDepth calls from
+/// `SlicePoint` are omitted.
+///
+/// Thanks to the precomputed \p Index, the cost is proportional to the size
+/// of the slice rather than to the size of the graph.
+///
+/// \note: this makes a copy of the graph, as such the input is not affected.
+Graph makeCalleeTree(const SliceIndex &Index,
+                     const BasicBlockID &SlicePoint,
+                     std::optional<unsigned> MaxDepth = std::nullopt);
 
 /// Produces a backwards facing slice of the graph starting from a single node.
 ///
 /// It is exactly the same as \see makeCalleeTree except it works in
 /// the opposite direction (it makes sure all the predecessors are preserved).
-Graph makeCallerTree(const Graph &Input,
-                     const BasicBlockID &SlicePoint = BasicBlockID());
+Graph makeCallerTree(const SliceIndex &Index,
+                     const BasicBlockID &SlicePoint,
+                     std::optional<unsigned> MaxDepth = std::nullopt);
 
 } // namespace yield::calls
@@ -0,0 +1,127 @@
+#pragma once
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+
+#include "revng/EarlyFunctionAnalysis/FunctionMetadata.h"
+#include "revng/Model/Binary.h"
+#include "revng/Support/BasicBlockID.h"
+#include "revng/Support/MetaAddress.h"
+
+namespace yield::crossrelations {
+
+class CrossRelations;
+
+/// Compact representation of the call graph of a binary, from which
+/// CrossRelations can be produced.
+///
+/// Nodes are identified by an integer ID: first come the functions of the
+/// model, sorted by entry address, then the dynamic functions, sorted by name.
+/// The call sites of each function are stored in a single vector, sorted by
+/// caller (CSR layout). When some functions are produced again, only their
+/// call sites are collected again, the ones of the other functions are kept.
+///
+/// Locations are never stored as strings, they are only produced by
+/// toCrossRelations.
+class CallGraphIndex {
+public:
+  using NodeID = uint32_t;
+
+  struct CallSite {
+    /// The basic block of the caller performing the call
+    BasicBlockID Block;
+    NodeID Callee;
+  };
+
+private:
+  std::vector<MetaAddress> Functions;
+  std::vector<std::string> DynamicFunctions;
+
+  /// The call sites of the I-th function are in [Offsets[I], Offsets[I + 1])
+  std::vector<uint32_t> Offsets;
+  std::vector<CallSite> CallSites;
+
+  /// Whether the call sites of each function have been collected
+  std::vector<bool> Known;
+  size_t MissingFunctions = 0;
+
+  /// Fingerprint of the metadata the call sites of each function have been
+  /// collected from, 0 if unknown
+  std::vector<uint64_t> Fingerprints;
+
+public:
+  CallGraphIndex() : Offsets(1, 0) {}
+  explicit CallGraphIndex(const model::Binary &Binary);
+
+public:
+  /// \return true if the nodes of this graph are the functions and dynamic
+  ///         functions of \p Binary
+  bool hasSameNodes(const model::Binary &Binary) const;
+
+  size_t functionsCount() const { return Functions.size(); }
+  size_t size() const { return Functions.size() + DynamicFunctions.size(); }
+
+  bool isFunction(NodeID ID) const { return ID < Functions.size(); }
+
+  std::optional<NodeID> functionID(const MetaAddress &Entry) const;
+  std::optional<NodeID> dynamicFunctionID(llvm::StringRef Name) const;
+
+  const MetaAddress &function(NodeID ID) const {
+    revng_assert(isFunction(ID));
+    return Functions[ID];
+  }
+
+  llvm::StringRef dynamicFunction(NodeID ID) const {
+    revng_assert(not isFunction(ID) and ID < size());
+    return DynamicFunctions[ID - Functions.size()];
+  }
+
+public:
+  /// \return true if the call sites of all the functions are known
+  bool isComplete() const { return MissingFunctions == 0; }
+
+  /// \return true if the call sites of \p Function have been collected from
+  ///         metadata with fingerprint \p Fingerprint
+  bool isUpToDate(NodeID Function, uint64_t Fingerprint) const {
+    revng_assert(isFunction(Function));
+    return Known[Function] and Fingerprint != 0
+           and Fingerprints[Function] == Fingerprint;
+  }
+
+  llvm::ArrayRef<CallSite> callSites(NodeID Function) const {
+    revng_assert(isFunction(Function));
+    return llvm::ArrayRef(CallSites)
+      .slice(Offsets[Function], Offsets[Function + 1] - Offsets[Function]);
+  }
+
+  /// Replace the call sites of the functions described by \p Metadata with
+  /// the ones they contain, leaving the other functions untouched.
+  ///
+  /// The call sites vector is rebuilt in a single pass, hence the cost is
+  /// linear in the size of the graph, no matter how many functions are
+  /// replaced: prefer updating all the functions at once over updating them
+  /// one by one.
+  ///
+  /// \p Fingerprints is either empty or has the fingerprint of each element
+  /// of \p Metadata, see isUpToDate.
+  void update(llvm::ArrayRef<const efa::FunctionMetadata *> Metadata,
+              llvm::ArrayRef<uint64_t> Fingerprints = {});
+
+  void update(const efa::FunctionMetadata &Metadata, uint64_t Fingerprint = 0) {
+    const efa::FunctionMetadata *Pointer = &Metadata;
+    update(llvm::ArrayRef(Pointer), llvm::ArrayRef(Fingerprint));
+  }
+
+  CrossRelations toCrossRelations() const;
+};
+
+} // namespace yield::crossrelations
@@ -57,9 +57,12 @@ struct Edge {
 
 using Node = MutableEdgeNode<detail::Node, detail::Edge, false>;
 
+/// \note the graphs are built once and then visited by the layout passes, as
+///       such, by default, their nodes and edge labels live in an arena.
 class Graph : public GenericGraph<Node, 16, true> {
 public:
   using GenericGraph<Node, 16, true>::GenericGraph;
+  Graph() : GenericGraph<Node, 16, true>(GraphAllocation::Arena) {}
 
 public:
   using Coordinate = detail::Coordinate;
@@ -12,6 +12,9 @@ class MetaAddress;
 namespace model {
 class Binary;
 }
+namespace ptml {
+class TagWriter;
+}
 namespace yield {
 class Function;
 }
@@ -66,4 +69,22 @@ std::string functionLink(const MetaAddress &FunctionEntryPoint,
 std::string shallowFunctionLink(const MetaAddress &FunctionEntryPoint,
                                 const model::Binary &Binary);
 
+/// Streaming versions of the functions above, they emit the same PTML
+/// into \p Writer instead of returning it
+/// @{
+void controlFlowNode(::ptml::TagWriter &Writer,
+                     const BasicBlockID &BasicBlockAddress,
+                     const yield::Function &Function,
+                     const model::Binary &Binary);
+void functionNameDefinition(::ptml::TagWriter &Writer,
+                            const MetaAddress &FunctionEntryPoint,
+                            const model::Binary &Binary);
+void functionLink(::ptml::TagWriter &Writer,
+                  const MetaAddress &FunctionEntryPoint,
+                  const model::Binary &Binary);
+void shallowFunctionLink(::ptml::TagWriter &Writer,
+                         const MetaAddress &FunctionEntryPoint,
+                         const model::Binary &Binary);
+/// @}
+
 } // namespace yield::ptml
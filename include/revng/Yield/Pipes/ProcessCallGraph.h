@@ -17,6 +17,7 @@
 #include "revng/Pipes/Kinds.h"
 #include "revng/Pipes/StringBufferContainer.h"
 #include "revng/Pipes/TupleTreeContainer.h"
+#include "revng/Yield/CrossRelations/CallGraphIndex.h"
 #include "revng/Yield/CrossRelations/CrossRelations.h"
 #include "revng/Yield/Generated/ForwardDecls.h"
 
@@ -53,6 +54,11 @@ class ProcessCallGraph {
 public:
   static constexpr const auto Name = "ProcessCallGraph";
 
+private:
+  /// The call graph collected so far, kept across runs so that only the
+  /// functions whose metadata changed have to be parsed and replaced
+  yield::crossrelations::CallGraphIndex Index;
+
 public:
   inline std::array<pipeline::ContractGroup, 1> getContract() const {
     return { pipeline::ContractGroup(kinds::Isolated,
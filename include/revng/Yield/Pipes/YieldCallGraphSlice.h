@@ -6,11 +6,13 @@
 
 #include <array>
 #include <string>
+#include <tuple>
 
 #include "llvm/ADT/ArrayRef.h"
 #include "llvm/Support/raw_ostream.h"
 
 #include "revng/Pipeline/Contract.h"
+#include "revng/Pipeline/Option.h"
 #include "revng/Pipes/FunctionStringMap.h"
 #include "revng/Yield/Pipes/ProcessCallGraph.h"
 
@@ -20,6 +22,10 @@ class YieldCallGraphSlice {
 public:
   static constexpr const auto Name = "YieldCallGraphSlice";
 
+  /// The slices show at most the functions `slice-depth` calls away from the
+  /// one they are about, zero or less means no limit
+  static constexpr std::tuple Options = { pipeline::Option("slice-depth", 0) };
+
 public:
   inline std::array<pipeline::ContractGroup, 1> getContract() const {
     pipeline::Contract BinaryContract(kinds::BinaryCrossRelations,
@@ -42,7 +48,8 @@ public:
   void run(pipeline::Context &Context,
            const pipeline::LLVMContainer &TargetList,
            const CrossRelationsFileContainer &InputFile,
-           CallGraphSliceSVGStringMap &Output);
+           CallGraphSliceSVGStringMap &Output,
+           int SliceDepth);
 
   void print(const pipeline::Context &Ctx,
              llvm::raw_ostream &OS,
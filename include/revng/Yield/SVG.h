@@ -4,6 +4,7 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <optional>
 #include <string>
 
 class BasicBlockID;
@@ -15,6 +16,12 @@ namespace yield {
 
 class Function;
 
+namespace calls {
+
+class SliceIndex;
+
+} // namespace calls
+
 namespace crossrelations {
 
 class CrossRelations;
@@ -37,6 +44,14 @@ std::string callGraphSlice(const BasicBlockID &SlicePoint,
                            const detail::CrossRelations &CrossRelationTree,
                            const model::Binary &Binary);
 
+/// Same as the overload taking the cross relations, but reuses the indices
+/// built on them, omitting the functions farther than \p MaxDepth calls from
+/// \p SlicePoint.
+std::string callGraphSlice(const BasicBlockID &SlicePoint,
+                           const calls::SliceIndex &Index,
+                           const model::Binary &Binary,
+                           std::optional<unsigned> MaxDepth = std::nullopt);
+
 } // namespace svg
 
 } // namespace yield
@@ -25,8 +25,8 @@ analyze(const BasicBlock *FunctionEntry, const GeneratedCodeBasicInfo &GCBI) {
   using MFI = MFIAnalysis<true, CoreLattice>;
 
   MFI Instance{ { GCBI } };
-  MFI::LatticeElement InitialValue;
-  MFI::LatticeElement ExtremalValue(CoreLattice::ExtremalLatticeElement);
+  MFI::LatticeElement InitialValue = Instance.initialValue();
+  MFI::LatticeElement ExtremalValue = Instance.extremalValue();
 
   auto
     Res = MFP::getMaximalFixedPoint<MFI, MFI::GT, MFI::LGT>(Instance,
@@ -40,7 +40,7 @@ analyze(const BasicBlock *FunctionEntry, const GeneratedCodeBasicInfo &GCBI) {
   std::map<const GlobalVariable *, State> RegNoOrDead{};
 
   for (auto &[BB, Result] : Res) {
-    for (auto &[GV, RegState] : Result.OutValue) {
+    for (auto [GV, RegState] : Result.OutValue.elements()) {
       if (RegState == CoreLattice::Unknown) {
         RegUnknown.insert(GV);
       }
@@ -48,7 +48,7 @@ analyze(const BasicBlock *FunctionEntry, const GeneratedCodeBasicInfo &GCBI) {
   }
 
   for (auto &[BB, Result] : Res) {
-    for (auto &[GV, RegState] : Result.OutValue) {
+    for (auto [GV, RegState] : Result.OutValue.elements()) {
       if (RegState == CoreLattice::NoOrDead && RegUnknown.count(GV) == 0) {
         RegNoOrDead[GV] = State::NoOrDead;
       }
@@ -28,8 +28,8 @@ analyze(const BasicBlock *CallSiteBlock, const GeneratedCodeBasicInfo &GCBI) {
 
   std::map<const GlobalVariable *, State> RegNoOrDead{};
   MFI Instance{ { getPreCallHook(CallSiteBlock), GCBI } };
-  MFI::LatticeElement InitialValue;
-  MFI::LatticeElement ExtremalValue(CoreLattice::ExtremalLatticeElement);
+  MFI::LatticeElement InitialValue = Instance.initialValue();
+  MFI::LatticeElement ExtremalValue = Instance.extremalValue();
   auto *Start = CallSiteBlock->getUniqueSuccessor();
 
   if (!Start)
@@ -44,7 +44,7 @@ analyze(const BasicBlock *CallSiteBlock, const GeneratedCodeBasicInfo &GCBI) {
                                                                 { Start });
 
   for (auto &[BB, Result] : Results) {
-    for (auto &[GV, RegState] : Result.OutValue) {
+    for (auto [GV, RegState] : Result.OutValue.elements()) {
       if (RegState == CoreLattice::NoOrDead) {
         RegNoOrDead[GV] = State::NoOrDead;
       }
@@ -27,8 +27,8 @@ analyze(const BasicBlock *CallSiteBlock, const GeneratedCodeBasicInfo &GCBI) {
   using MFI = MFIAnalysis<false, CoreLattice>;
 
   MFI Instance{ { getPostCallHook(CallSiteBlock), GCBI } };
-  MFI::LatticeElement InitialValue;
-  MFI::LatticeElement ExtremalValue(CoreLattice::ExtremalLatticeElement);
+  MFI::LatticeElement InitialValue = Instance.initialValue();
+  MFI::LatticeElement ExtremalValue = Instance.extremalValue();
 
   auto *Start = CallSiteBlock->getUniquePredecessor();
   revng_assert(Start != nullptr, "Call site has multiple predecessors");
@@ -44,7 +44,7 @@ analyze(const BasicBlock *CallSiteBlock, const GeneratedCodeBasicInfo &GCBI) {
   std::map<const GlobalVariable *, State> RegYes{};
 
   for (auto &[BB, Result] : Results) {
-    for (auto &[GV, RegState] : Result.OutValue) {
+    for (auto [GV, RegState] : Result.OutValue.elements()) {
       if (RegState == CoreLattice::Unknown) {
         RegUnknown.insert(GV);
       }
@@ -52,7 +52,7 @@ analyze(const BasicBlock *CallSiteBlock, const GeneratedCodeBasicInfo &GCBI) {
   }
 
   for (auto &[BB, Result] : Results) {
-    for (auto &[GV, RegState] : Result.OutValue) {
+    for (auto [GV, RegState] : Result.OutValue.elements()) {
       if (RegState == CoreLattice::Yes && RegUnknown.count(GV) == 0) {
         RegYes[GV] = State::Yes;
       }
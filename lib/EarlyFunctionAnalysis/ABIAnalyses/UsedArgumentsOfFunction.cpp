@@ -25,8 +25,8 @@ std::map<const GlobalVariable *, State>
 analyze(const BasicBlock *FunctionEntry, const GeneratedCodeBasicInfo &GCBI) {
   using MFI = MFIAnalysis<true, CoreLattice>;
   MFI Instance{ { GCBI } };
-  MFI::LatticeElement InitialValue;
-  MFI::LatticeElement ExtremalValue(CoreLattice::ExtremalLatticeElement);
+  MFI::LatticeElement InitialValue = Instance.initialValue();
+  MFI::LatticeElement ExtremalValue = Instance.extremalValue();
 
   auto
     Res = MFP::getMaximalFixedPoint<MFI, MFI::GT, MFI::LGT>(Instance,
@@ -39,7 +39,7 @@ analyze(const BasicBlock *FunctionEntry, const GeneratedCodeBasicInfo &GCBI) {
   std::map<const GlobalVariable *, State> RegYes{};
 
   for (auto &[BB, Result] : Res) {
-    for (auto &[GV, RegState] : Result.OutValue) {
+    for (auto [GV, RegState] : Result.OutValue.elements()) {
       if (RegState == CoreLattice::Yes) {
         RegYes[GV] = State::Yes;
       }
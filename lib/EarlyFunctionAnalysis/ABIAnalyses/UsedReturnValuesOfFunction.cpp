@@ -26,8 +26,8 @@ analyze(const BasicBlock *ReturnBlock, const GeneratedCodeBasicInfo &GCBI) {
   using MFI = MFIAnalysis<false, CoreLattice>;
 
   MFI Instance{ { GCBI } };
-  MFI::LatticeElement InitialValue;
-  MFI::LatticeElement ExtremalValue(CoreLattice::ExtremalLatticeElement);
+  MFI::LatticeElement InitialValue = Instance.initialValue();
+  MFI::LatticeElement ExtremalValue = Instance.extremalValue();
 
   auto Res = MFP::getMaximalFixedPoint<MFI, MFI::GT, MFI::LGT>(Instance,
                                                                ReturnBlock,
@@ -40,7 +40,7 @@ analyze(const BasicBlock *ReturnBlock, const GeneratedCodeBasicInfo &GCBI) {
   std::map<const GlobalVariable *, State> RegYesOrDead{};
 
   for (auto &[BB, Result] : Res) {
-    for (auto &[GV, RegState] : Result.OutValue) {
+    for (auto [GV, RegState] : Result.OutValue.elements()) {
       if (RegState == CoreLattice::Unknown) {
         RegUnknown.insert(GV);
       }
@@ -48,7 +48,7 @@ analyze(const BasicBlock *ReturnBlock, const GeneratedCodeBasicInfo &GCBI) {
   }
 
   for (auto &[BB, Result] : Res) {
-    for (auto &[GV, RegState] : Result.OutValue) {
+    for (auto [GV, RegState] : Result.OutValue.elements()) {
       if (RegState == CoreLattice::YesOrDead && RegUnknown.count(GV) == 0) {
         RegYesOrDead[GV] = State::YesOrDead;
       }
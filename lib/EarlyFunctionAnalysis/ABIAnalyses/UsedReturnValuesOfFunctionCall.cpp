@@ -27,8 +27,8 @@ analyze(const BasicBlock *CallSiteBlock, const GeneratedCodeBasicInfo &GCBI) {
 
   std::map<const GlobalVariable *, State> RegYes{};
   MFI Instance{ { getPreCallHook(CallSiteBlock), GCBI } };
-  MFI::LatticeElement InitialValue;
-  MFI::LatticeElement ExtremalValue(CoreLattice::ExtremalLatticeElement);
+  MFI::LatticeElement InitialValue = Instance.initialValue();
+  MFI::LatticeElement ExtremalValue = Instance.extremalValue();
   auto *Start = CallSiteBlock->getUniqueSuccessor();
 
   if (!Start)
@@ -43,7 +43,7 @@ analyze(const BasicBlock *CallSiteBlock, const GeneratedCodeBasicInfo &GCBI) {
                                                                 { Start });
 
   for (auto &[BB, Result] : Results) {
-    for (auto &[GV, RegState] : Result.OutValue) {
+    for (auto [GV, RegState] : Result.OutValue.elements()) {
       if (RegState == CoreLattice::Yes) {
         RegYes[GV] = State::Yes;
       }
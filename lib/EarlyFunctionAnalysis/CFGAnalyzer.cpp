@@ -5,6 +5,7 @@
 //
 
 #include <fstream>
+#include <optional>
 
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Analysis/BasicAliasAnalysis.h"
@@ -28,6 +29,7 @@
 #include "revng/EarlyFunctionAnalysis/IndirectBranchInfoPrinterPass.h"
 #include "revng/EarlyFunctionAnalysis/PromoteGlobalToLocalVars.h"
 #include "revng/EarlyFunctionAnalysis/SegregateDirectStackAccesses.h"
+#include "revng/Support/Statistics.h"
 #include "revng/Support/TemporaryLLVMOption.h"
 
 using namespace llvm;
@@ -109,6 +111,12 @@ streamFromOption(const opt<std::string> &Option) {
   }
 }
 
+/// Time spent, in milliseconds, in each stage of CFGAnalyzer::analyze
+static RunningStatistics OutlineTime("cfg-analyzer-outline-ms");
+static RunningStatistics PrepareTime("cfg-analyzer-prepare-ms");
+static RunningStatistics OptimizationTime("cfg-analyzer-optimization-ms");
+static RunningStatistics MilkInfoTime("cfg-analyzer-milk-info-ms");
+
 CFGAnalyzer::CFGAnalyzer(llvm::Module &M,
                          GeneratedCodeBasicInfo &GCBI,
                          const TupleTree<model::Binary> &Binary,
@@ -197,7 +205,7 @@ CFGAnalyzer::handleCall(llvm::CallInst *PreCallHookCall) {
   bool IsDirectCall = false;
   auto Address = BasicBlockID::fromValue(CalleePC).notInlinedAddress();
   if (Address.isValid()) {
-    IsDirectCall = Binary->Functions().count(Address) != 0;
+    IsDirectCall = Oracle.isLocalFunction(Address);
     if (IsDirectCall)
       CalleeAddress = Address;
   }
@@ -556,81 +564,114 @@ void CFGAnalyzer::materializePCValues(llvm::Function *F,
   }
 }
 
-void CFGAnalyzer::runOptimizationPipeline(llvm::Function *F) {
-  using namespace llvm;
+/// The optimization pipeline run over the outlined functions, along with its
+/// analysis managers. It's built once and then reused for all the functions
+/// analyzed by a CFGAnalyzer.
+class OptimizationPipeline {
+private:
+  using TemporaryUOption = TemporaryLLVMOption<unsigned>;
+  using BinaryTree = TupleTree<model::Binary>;
 
+private:
   // Some LLVM passes used later in the pipeline scan for cut-offs, meaning that
   // further computation may not be done when they are reached; making some
   // optimizations opportunities missed. Hence, we set the involved thresholds
   // (e.g., the maximum value that MemorySSA uses to take into account
   // stores/phis) to have initial unbounded value.
-  static constexpr const char *MemSSALimit = "memssa-check-limit";
-  static constexpr const char *MemDepBlockLimit = "memdep-block-scan-limit";
+  TemporaryUOption MemSSALimitOption;
+  TemporaryUOption MemDepBlockLimitOption;
 
-  using TemporaryUOption = TemporaryLLVMOption<unsigned>;
-  TemporaryUOption MemSSALimitOption(MemSSALimit, UINT_MAX);
-  TemporaryUOption MemDepBlockLimitOption(MemDepBlockLimit, UINT_MAX);
+  FunctionPassManager FPM;
 
-  // TODO: break it down in the future, and check if some passes can be dropped
-  {
-    FunctionPassManager FPM;
-
-    // First stage: simplify the IR, promote the CSVs to local variables,
-    // compute subexpressions elimination and resolve redundant expressions in
-    // order to compute the stack height.
-    FPM.addPass(RemoveNewPCCallsPass());
-    FPM.addPass(RemoveHelperCallsPass());
-    FPM.addPass(PromoteGlobalToLocalPass());
-    FPM.addPass(SimplifyCFGPass());
-    FPM.addPass(SROAPass(SROAOptions::ModifyCFG));
-    FPM.addPass(EarlyCSEPass(true));
-    FPM.addPass(JumpThreadingPass());
-    FPM.addPass(UnreachableBlockElimPass());
-    FPM.addPass(InstCombinePass());
-    FPM.addPass(EarlyCSEPass(true));
-    FPM.addPass(SimplifyCFGPass());
-    FPM.addPass(MergedLoadStoreMotionPass());
-    FPM.addPass(GVNPass());
-
-    // Second stage: add alias analysis info and canonicalize `i2p` + `add` into
-    // `getelementptr` instructions. Since the IR may change remarkably, another
-    // round of passes is necessary to take more optimization opportunities.
-    FPM.addPass(SegregateDirectStackAccessesPass());
-    FPM.addPass(EarlyCSEPass(true));
-    FPM.addPass(InstCombinePass());
-    FPM.addPass(GVNPass());
-
-    // Third stage: if enabled, serialize the results and dump the functions on
-    // disk with the alias information included as comments.
-    if (IndirectBranchInfoSummaryPath.getNumOccurrences() == 1)
-      FPM.addPass(IndirectBranchInfoPrinterPass(*OutputIBI));
-
-    if (AAWriterPath.getNumOccurrences() == 1)
-      FPM.addPass(AAWriterPass(*OutputAAWriter));
-
-    ModuleAnalysisManager MAM;
-
-    FunctionAnalysisManager FAM;
-    FAM.registerPass([] {
-      AAManager AA;
-      AA.registerFunctionAnalysis<BasicAA>();
-      AA.registerFunctionAnalysis<ScopedNoAliasAA>();
-
-      return AA;
-    });
-    FAM.registerPass([this] {
-      using LMA = LoadModelAnalysis;
-      return LMA::fromModelWrapper(Binary);
-    });
-    FAM.registerPass([&] { return GeneratedCodeBasicInfoAnalysis(); });
-    FAM.registerPass([&] { return ModuleAnalysisManagerFunctionProxy(MAM); });
-
-    PassBuilder PB;
-    PB.registerFunctionAnalyses(FAM);
-    PB.registerModuleAnalyses(MAM);
-
-    FPM.run(*F, FAM);
+  // Note: the analyses registered by the PassBuilder refer to it, keep it
+  //       alive as long as the analysis managers
+  PassBuilder PB;
+  ModuleAnalysisManager MAM;
+  FunctionAnalysisManager FAM;
+
+public:
+  OptimizationPipeline(const BinaryTree &Binary,
+                       llvm::raw_ostream &OutputIBI,
+                       llvm::raw_ostream &OutputAAWriter);
+
+public:
+  void run(llvm::Function &F) {
+    FPM.run(F, FAM);
+
+    // F is going to be erased, drop all the analysis results about it, so that
+    // they are not mistaken for the ones of the next function
+    FAM.clear(F, F.getName());
   }
+};
+
+OptimizationPipeline::OptimizationPipeline(const BinaryTree &Binary,
+                                           raw_ostream &OutputIBI,
+                                           raw_ostream &OutputAAWriter) :
+  MemSSALimitOption("memssa-check-limit", UINT_MAX),
+  MemDepBlockLimitOption("memdep-block-scan-limit", UINT_MAX) {
+
+  // TODO: break it down in the future, and check if some passes can be dropped
+
+  // First stage: simplify the IR, promote the CSVs to local variables,
+  // compute subexpressions elimination and resolve redundant expressions in
+  // order to compute the stack height.
+  FPM.addPass(RemoveNewPCCallsPass());
+  FPM.addPass(RemoveHelperCallsPass());
+  FPM.addPass(PromoteGlobalToLocalPass());
+  FPM.addPass(SimplifyCFGPass());
+  FPM.addPass(SROAPass(SROAOptions::ModifyCFG));
+  FPM.addPass(EarlyCSEPass(true));
+  FPM.addPass(JumpThreadingPass());
+  FPM.addPass(UnreachableBlockElimPass());
+  FPM.addPass(InstCombinePass());
+  FPM.addPass(EarlyCSEPass(true));
+  FPM.addPass(SimplifyCFGPass());
+  FPM.addPass(MergedLoadStoreMotionPass());
+  FPM.addPass(GVNPass());
+
+  // Second stage: add alias analysis info and canonicalize `i2p` + `add` into
+  // `getelementptr` instructions. Since the IR may change remarkably, another
+  // round of passes is necessary to take more optimization opportunities.
+  FPM.addPass(SegregateDirectStackAccessesPass());
+  FPM.addPass(EarlyCSEPass(true));
+  FPM.addPass(InstCombinePass());
+  FPM.addPass(GVNPass());
+
+  // Third stage: if enabled, serialize the results and dump the functions on
+  // disk with the alias information included as comments.
+  if (IndirectBranchInfoSummaryPath.getNumOccurrences() == 1)
+    FPM.addPass(IndirectBranchInfoPrinterPass(OutputIBI));
+
+  if (AAWriterPath.getNumOccurrences() == 1)
+    FPM.addPass(AAWriterPass(OutputAAWriter));
+
+  FAM.registerPass([] {
+    AAManager AA;
+    AA.registerFunctionAnalysis<BasicAA>();
+    AA.registerFunctionAnalysis<ScopedNoAliasAA>();
+
+    return AA;
+  });
+  FAM.registerPass([&Binary] {
+    using LMA = LoadModelAnalysis;
+    return LMA::fromModelWrapper(Binary);
+  });
+  FAM.registerPass([] { return GeneratedCodeBasicInfoAnalysis(); });
+  FAM.registerPass([this] { return ModuleAnalysisManagerFunctionProxy(MAM); });
+
+  PB.registerFunctionAnalyses(FAM);
+  PB.registerModuleAnalyses(MAM);
+}
+
+CFGAnalyzer::~CFGAnalyzer() = default;
+
+void CFGAnalyzer::runOptimizationPipeline(llvm::Function *F) {
+  if (not Pipeline)
+    Pipeline = std::make_unique<OptimizationPipeline>(Binary,
+                                                      *OutputIBI,
+                                                      *OutputAAWriter);
+
+  Pipeline->run(*F);
 }
 
 class ClobberedRegistersRegistry {
@@ -917,12 +958,16 @@ FunctionSummary CFGAnalyzer::analyze(llvm::BasicBlock *Entry) {
   ABIAnalysesResults ABIResults;
 
   // Detect function boundaries
+  std::optional<ScopedRunningStatisticsTimer> Timer;
+  Timer.emplace(OutlineTime);
   OutlinedFunction OutlinedFunction = outline(Entry);
 
   // Recover the control-flow graph of the function
   SortedVector<efa::BasicBlock> CFG = collectDirectCFG(&OutlinedFunction);
   revng_assert(CFG.size() > 0);
 
+  Timer.emplace(PrepareTime);
+
   // The analysis aims at identifying the callee-saved registers of a
   // function and establishing if a function returns properly, i.e., it
   // jumps to the return address (regular function). In order to achieve
@@ -953,10 +998,13 @@ FunctionSummary CFGAnalyzer::analyze(llvm::BasicBlock *Entry) {
   materializePCValues(F, Builder);
 
   // Execute the optimization pipeline over the outlined function
+  Timer.emplace(OptimizationTime);
   runOptimizationPipeline(F);
 
   // Squeeze out the results obtained from the optimization passes
+  Timer.emplace(MilkInfoTime);
   auto FunctionInfo = milkInfo(&OutlinedFunction, std::move(CFG));
+  Timer.reset();
 
   return FunctionInfo;
 }
@@ -8,24 +8,39 @@
 #include "revng/EarlyFunctionAnalysis/CFGAnalyzer.h"
 #include "revng/EarlyFunctionAnalysis/CollectCFG.h"
 #include "revng/EarlyFunctionAnalysis/FunctionMetadata.h"
+#include "revng/EarlyFunctionAnalysis/FunctionSummaryCache.h"
 #include "revng/Model/Binary.h"
 
 using namespace llvm;
 
+static Logger<> Log("collect-cfg");
+
 namespace efa {
 class CollectCFG {
 private:
   llvm::Module &M;
   GeneratedCodeBasicInfo &GCBI;
   const TupleTree<model::Binary> &Binary;
+  const FunctionSummaryOracle &Oracle;
   CFGAnalyzer &Analyzer;
+  const FunctionSummaryCache &Cache;
+  uint64_t ModuleHash;
 
 public:
   CollectCFG(llvm::Module &M,
              GeneratedCodeBasicInfo &GCBI,
              const TupleTree<model::Binary> &Binary,
-             CFGAnalyzer &Analyzer) :
-    M(M), GCBI(GCBI), Binary(Binary), Analyzer(Analyzer) {}
+             const FunctionSummaryOracle &Oracle,
+             CFGAnalyzer &Analyzer,
+             const FunctionSummaryCache &Cache,
+             uint64_t ModuleHash) :
+    M(M),
+    GCBI(GCBI),
+    Binary(Binary),
+    Oracle(Oracle),
+    Analyzer(Analyzer),
+    Cache(Cache),
+    ModuleHash(ModuleHash) {}
 
 public:
   void run() {
@@ -69,10 +84,18 @@ std::vector<efa::FunctionMetadata> CollectCFG::recoverCFGs() {
     auto *Entry = GCBI.getBlockAt(Function.Entry());
     revng_assert(Entry != nullptr);
 
-    // Recover the control-flow graph of the function
+    // Recover the control-flow graph of the function, reusing the one
+    // computed by DetectABI, unless its inputs changed in the meantime
     efa::FunctionMetadata New;
     New.Entry() = Function.Entry();
-    New.ControlFlowGraph() = std::move(Analyzer.analyze(Entry).CFG);
+    uint64_t InputsHash = FunctionSummaryCache::computeInputsHash(Function,
+                                                                  ModuleHash);
+    if (auto *Cached = Cache.get(Function.Entry(), InputsHash, Oracle)) {
+      revng_log(Log, "Reusing the CFG of " << Function.Entry().toString());
+      New.ControlFlowGraph() = Cached->CFG;
+    } else {
+      New.ControlFlowGraph() = std::move(Analyzer.analyze(Entry).CFG);
+    }
 
     revng_assert(New.ControlFlowGraph().count(BasicBlockID(New.Entry())) != 0);
 
@@ -97,12 +120,21 @@ bool CollectCFGPass::runOnModule(Module &M) {
 
   const TupleTree<model::Binary> &Binary = LMP.getReadOnlyModel();
 
+  auto &Cache = getAnalysis<FunctionSummaryCacheWrapperPass>().get();
+  uint64_t ModuleHash = FunctionSummaryCache::computeModuleHash(M, *Binary);
+
   FunctionSummaryOracle Oracle;
   importModel(M, GCBI, *Binary, Oracle);
 
   CFGAnalyzer Analyzer(M, GCBI, Binary, Oracle);
 
-  CollectCFG CFGCollector(M, GCBI, Binary, Analyzer);
+  CollectCFG CFGCollector(M,
+                          GCBI,
+                          Binary,
+                          Oracle,
+                          Analyzer,
+                          Cache,
+                          ModuleHash);
 
   CFGCollector.run();
 
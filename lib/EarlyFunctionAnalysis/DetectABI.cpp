@@ -20,6 +20,7 @@
 #include "revng/EarlyFunctionAnalysis/CollectFunctionsFromUnusedAddressesPass.h"
 #include "revng/EarlyFunctionAnalysis/DetectABI.h"
 #include "revng/EarlyFunctionAnalysis/FunctionMetadata.h"
+#include "revng/EarlyFunctionAnalysis/FunctionSummaryCache.h"
 #include "revng/EarlyFunctionAnalysis/FunctionSummaryOracle.h"
 #include "revng/Model/Binary.h"
 #include "revng/Pipeline/Pipe.h"
@@ -112,23 +113,32 @@ private:
   TupleTree<model::Binary> &Binary;
   FunctionSummaryOracle &Oracle;
   CFGAnalyzer &Analyzer;
+  FunctionSummaryCache &Cache;
+  uint64_t ModuleHash;
+
+  /// Summaries to record in Cache once the model has been finalized
+  std::map<MetaAddress, CachedFunctionSummary> NewSummaries;
 
   BasicBlockQueue EntrypointsQueue;
 
-  CallGraph ApproximateCallGraph;
+  CallGraph ApproximateCallGraph{ GraphAllocation::Arena };
 
 public:
   DetectABI(llvm::Module &M,
             GeneratedCodeBasicInfo &GCBI,
             TupleTree<model::Binary> &Binary,
             FunctionSummaryOracle &Oracle,
-            CFGAnalyzer &Analyzer) :
+            CFGAnalyzer &Analyzer,
+            FunctionSummaryCache &Cache,
+            uint64_t ModuleHash) :
     M(M),
     Context(M.getContext()),
     GCBI(GCBI),
     Binary(Binary),
     Oracle(Oracle),
-    Analyzer(Analyzer) {}
+    Analyzer(Analyzer),
+    Cache(Cache),
+    ModuleHash(ModuleHash) {}
 
 public:
   void run() {
@@ -152,6 +162,11 @@ public:
     // Commit the results onto the model. A non-const model is taken as
     // argument to be written.
     finalizeModel();
+
+    // Make the results available to later passes. The model of the functions
+    // is part of their inputs, therefore this has to happen after it has
+    // been finalized.
+    recordSummaries();
   }
 
 private:
@@ -161,6 +176,7 @@ private:
   void interproceduralPropagation();
   void finalizeModel();
   void applyABIDeductions();
+  void recordSummaries();
 
 private:
   CSVSet computePreservedCSVs(const CSVSet &ClobberedRegisters) const;
@@ -180,6 +196,10 @@ private:
                       const ABIAnalyses::RegisterStateMap &);
 
   void initializeMapForDeductions(FunctionSummary &, abi::RegisterState::Map &);
+
+  void cacheSummary(MetaAddress Entry,
+                    OracleQueries &&Queries,
+                    const FunctionSummary &Summary);
 };
 
 void DetectABI::initializeInterproceduralQueue() {
@@ -714,6 +734,32 @@ void DetectABI::analyzeABI(llvm::BasicBlock *Entry) {
   Oracle.getLocalFunction(EntryAddress).ABIResults = ABIResults;
 }
 
+void DetectABI::cacheSummary(MetaAddress Entry,
+                             OracleQueries &&Queries,
+                             const FunctionSummary &Summary) {
+  CachedFunctionSummary Cached;
+  Cached.Queries = std::move(Queries);
+  Cached.CFG = Summary.CFG;
+  for (llvm::GlobalVariable *CSV : Summary.ClobberedRegisters)
+    Cached.ClobberedRegisters.insert(CSV->getName().str());
+  Cached.ElectedFSO = Summary.ElectedFSO;
+  NewSummaries[Entry] = std::move(Cached);
+}
+
+void DetectABI::recordSummaries() {
+  for (auto &[Entry, Summary] : NewSummaries) {
+    auto It = Binary->Functions().find(Entry);
+    if (It == Binary->Functions().end())
+      continue;
+
+    Summary.InputsHash = FunctionSummaryCache::computeInputsHash(*It,
+                                                                 ModuleHash);
+    Cache.record(Entry, std::move(Summary));
+  }
+
+  NewSummaries.clear();
+}
+
 void DetectABI::runInterproceduralAnalysis() {
   std::set<MetaAddress> Set;
 
@@ -730,7 +776,14 @@ void DetectABI::runInterproceduralAnalysis() {
     //       However, `analyze` also computes the CFG. There's a refactoring
     //       opportunity.
     llvm::BasicBlock *BB = GCBI.getBlockAt(EntryNode->Address);
+    OracleQueries Queries;
+    Oracle.startRecording(Queries);
     FunctionSummary AnalysisResult = Analyzer.analyze(BB);
+    Oracle.stopRecording(Queries);
+
+    // Keep the result, along with the information about the callees it depends
+    // upon. The last analysis of a function wins.
+    cacheSummary(EntryPointAddress, std::move(Queries), AnalysisResult);
 
     if (Log.isEnabled()) {
       AnalysisResult.dump(Log);
@@ -797,12 +850,21 @@ bool DetectABIPass::runOnModule(Module &M) {
 
   TupleTree<model::Binary> &Binary = LMP.getWriteableModel();
 
+  auto &Cache = getAnalysis<FunctionSummaryCacheWrapperPass>().get();
+  uint64_t ModuleHash = FunctionSummaryCache::computeModuleHash(M, *Binary);
+
   FunctionSummaryOracle Oracle;
   importModel(M, GCBI, *Binary, Oracle);
 
   CFGAnalyzer Analyzer(M, GCBI, Binary, Oracle);
 
-  DetectABI ABIDetector(M, GCBI, Binary, Oracle, Analyzer);
+  DetectABI ABIDetector(M,
+                        GCBI,
+                        Binary,
+                        Oracle,
+                        Analyzer,
+                        Cache,
+                        ModuleHash);
 
   ABIDetector.run();
 
@@ -0,0 +1,113 @@
+/// \file FunctionSummaryCache.cpp
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+
+#include "revng/EarlyFunctionAnalysis/FunctionSummaryCache.h"
+#include "revng/Model/Binary.h"
+#include "revng/Support/IRHelpers.h"
+#include "revng/TupleTree/TupleTreeHash.h"
+
+using namespace llvm;
+
+static cl::opt<unsigned> CacheSize("function-summary-cache-size",
+                                   cl::desc("Maximum number of functions whose "
+                                            "summary computed by DetectABI is "
+                                            "kept in memory"),
+                                   cl::init(1 << 16));
+
+namespace efa {
+
+uint64_t FunctionSummaryCache::computeModuleHash(const Module &M,
+                                                 const model::Binary &Binary) {
+  // Consider only the helpers, since analyses might leave behind other
+  // declarations. Sort them, so that the order in which they have been created
+  // does not matter.
+  std::vector<StringRef> Helpers;
+  for (const Function &F : M.functions())
+    if (F.isDeclaration() and isHelper(&F))
+      Helpers.push_back(F.getName());
+  llvm::sort(Helpers);
+
+  hash_code Result = hash_combine_range(Helpers.begin(), Helpers.end());
+
+  // The contents of the segments, as recorded by the CodeGenerator
+  if (const NamedMDNode *MD = M.getNamedMetadata(SegmentsHashName)) {
+    QuickMetadata QMD(M.getContext());
+    auto *Tuple = cast<MDTuple>(MD->getOperand(0));
+    Result = hash_combine(Result, QMD.extract<uint64_t>(Tuple, 0));
+  }
+
+  return hash_combine(Result,
+                      static_cast<unsigned>(Binary.Architecture()),
+                      hashTupleTree(Binary.Segments()),
+                      hashTupleTree(Binary.ExtraCodeAddresses()));
+}
+
+uint64_t
+FunctionSummaryCache::computeInputsHash(const model::Function &Function,
+                                        uint64_t ModuleHash) {
+  // Do not trust the cached hashes: the model might have been changed through
+  // references obtained before they have been computed
+  return hash_combine(ModuleHash, hashTupleTreeUncached(Function));
+}
+
+void FunctionSummaryCache::record(MetaAddress Entry,
+                                  CachedFunctionSummary &&Summary) {
+  auto It = Summaries.find(Entry);
+  if (It != Summaries.end()) {
+    UseOrder.erase(It->second.Use);
+    Summaries.erase(It);
+  } else if (Summaries.size() == Capacity) {
+    // Evict the least recently used function
+    Summaries.erase(UseOrder.front());
+    UseOrder.pop_front();
+  }
+
+  auto Use = UseOrder.insert(UseOrder.end(), Entry);
+  Summaries.emplace(Entry, CacheEntry{ std::move(Summary), Use });
+}
+
+const CachedFunctionSummary *
+FunctionSummaryCache::get(MetaAddress Entry,
+                          uint64_t InputsHash,
+                          const FunctionSummaryOracle &Oracle) const {
+  auto It = Summaries.find(Entry);
+  if (It == Summaries.end())
+    return nullptr;
+
+  const CachedFunctionSummary &Summary = It->second.Summary;
+  if (Summary.InputsHash != InputsHash)
+    return nullptr;
+
+  // Information about the callees might have been changed since
+  if (not Oracle.answersLike(Summary.Queries))
+    return nullptr;
+
+  UseOrder.splice(UseOrder.end(), UseOrder, It->second.Use);
+  return &Summary;
+}
+
+static FunctionSummaryCache &processCache() {
+  static FunctionSummaryCache Cache(CacheSize);
+  return Cache;
+}
+
+FunctionSummaryCacheWrapperPass::FunctionSummaryCacheWrapperPass() :
+  llvm::ImmutablePass(ID), Cache(processCache()) {}
+
+char FunctionSummaryCacheWrapperPass::ID = 0;
+
+using CachePass = RegisterPass<FunctionSummaryCacheWrapperPass>;
+static CachePass X("function-summary-cache",
+                   "Cache of the function summaries computed by DetectABI",
+                   true,
+                   true);
+
+} // namespace efa
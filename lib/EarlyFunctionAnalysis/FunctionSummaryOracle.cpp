@@ -4,6 +4,9 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include "llvm/ADT/Hashing.h"
+#include "llvm/ADT/STLExtras.h"
+
 #include "revng/ABI/FunctionType/Layout.h"
 #include "revng/EarlyFunctionAnalysis/FunctionSummaryOracle.h"
 
@@ -63,16 +66,42 @@ importPrototype(Module &M,
   return Summary;
 }
 
+/// Digest of the information about a call site the CFGAnalyzer depends upon
+static uint64_t digest(const FunctionSummary &Summary, bool IsTailCall) {
+  hash_code Result = hash_value(IsTailCall);
+
+  for (model::FunctionAttribute::Values Attribute : Summary.Attributes)
+    Result = hash_combine(Result, Attribute);
+
+  // Sort by name, pointers are not stable across modules
+  SmallVector<StringRef, 16> Clobbered;
+  for (GlobalVariable *CSV : Summary.ClobberedRegisters)
+    Clobbered.push_back(CSV->getName());
+  llvm::sort(Clobbered);
+  for (StringRef Name : Clobbered)
+    Result = hash_combine(Result, Name);
+
+  Result = hash_combine(Result, Summary.ElectedFSO.has_value());
+  if (Summary.ElectedFSO.has_value())
+    Result = hash_combine(Result, *Summary.ElectedFSO);
+
+  return Result;
+}
+
 std::pair<const FunctionSummary *, bool>
-FunctionSummaryOracle::getCallSite(MetaAddress Function,
-                                   BasicBlockID CallerBlockAddress,
-                                   MetaAddress CalledLocalFunction,
-                                   llvm::StringRef CalledSymbol) const {
+FunctionSummaryOracle::lookupCallSite(MetaAddress Function,
+                                      BasicBlockID CallerBlockAddress,
+                                      MetaAddress CalledLocalFunction,
+                                      llvm::StringRef CalledSymbol) const {
   auto [Summary, IsTailCall] = getCallSiteImpl(Function, CallerBlockAddress);
   if (Summary != nullptr) {
     return { Summary, IsTailCall };
   } else if (not CalledSymbol.empty()) {
-    return { &getDynamicFunction(CalledSymbol), false };
+    // Calls to dynamic functions we know nothing about behave as the default
+    auto It = DynamicFunctions.find(CalledSymbol.str());
+    if (It == DynamicFunctions.end())
+      return { &getDefault(), false };
+    return { &It->second, false };
   } else if (CalledLocalFunction.isValid()
              and LocalFunctions.count(CalledLocalFunction) != 0) {
     return { &getLocalFunction(CalledLocalFunction), false };
@@ -81,6 +110,62 @@ FunctionSummaryOracle::getCallSite(MetaAddress Function,
   }
 }
 
+std::pair<const FunctionSummary *, bool>
+FunctionSummaryOracle::getCallSite(MetaAddress Function,
+                                   BasicBlockID CallerBlockAddress,
+                                   MetaAddress CalledLocalFunction,
+                                   llvm::StringRef CalledSymbol) const {
+  auto Result = lookupCallSite(Function,
+                               CallerBlockAddress,
+                               CalledLocalFunction,
+                               CalledSymbol);
+
+  if (not Recorders.empty()) {
+    CallSiteQuery Query = { Function,
+                            CallerBlockAddress,
+                            CalledLocalFunction,
+                            CalledSymbol.str(),
+                            digest(*Result.first, Result.second) };
+    for (OracleQueries *Recorder : Recorders)
+      Recorder->CallSites.push_back(Query);
+  }
+
+  return Result;
+}
+
+bool FunctionSummaryOracle::isLocalFunction(MetaAddress PC) const {
+  bool Result = LocalFunctions.count(PC) != 0;
+
+  for (OracleQueries *Recorder : Recorders)
+    Recorder->LocalFunctions.emplace_back(PC, Result);
+
+  return Result;
+}
+
+void FunctionSummaryOracle::replay(const OracleQueries &Queries) const {
+  for (OracleQueries *Recorder : Recorders) {
+    llvm::append_range(Recorder->CallSites, Queries.CallSites);
+    llvm::append_range(Recorder->LocalFunctions, Queries.LocalFunctions);
+  }
+}
+
+bool FunctionSummaryOracle::answersLike(const OracleQueries &Queries) const {
+  for (const auto &[PC, IsLocal] : Queries.LocalFunctions)
+    if ((LocalFunctions.count(PC) != 0) != IsLocal)
+      return false;
+
+  for (const CallSiteQuery &Query : Queries.CallSites) {
+    auto [Summary, IsTailCall] = lookupCallSite(Query.Function,
+                                                Query.CallerBlockAddress,
+                                                Query.CalledLocalFunction,
+                                                Query.CalledSymbol);
+    if (digest(*Summary, IsTailCall) != Query.AnswerDigest)
+      return false;
+  }
+
+  return true;
+}
+
 bool FunctionSummaryOracle::registerCallSite(MetaAddress Function,
                                              BasicBlockID CallSite,
                                              FunctionSummary &&New,
@@ -20,6 +20,12 @@ using namespace llvm;
 
 namespace efa {
 
+static Function *createPlaceholder(Module &M) {
+  LLVMContext &Context = M.getContext();
+  auto *FT = FunctionType::get(Type::getVoidTy(Context), {}, false);
+  return Function::Create(FT, llvm::GlobalObject::ExternalLinkage, 0, {}, &M);
+}
+
 class OutlinedFunctionsMap {
 private:
   Module *M = nullptr;
@@ -43,13 +49,7 @@ public:
 
     auto It = Map.find(Entry);
     if (It == Map.end()) {
-      LLVMContext &Context = M->getContext();
-      auto *FT = FunctionType::get(Type::getVoidTy(Context), {}, false);
-      Function *New = Function::Create(FT,
-                                       llvm::GlobalObject::ExternalLinkage,
-                                       0,
-                                       {},
-                                       M);
+      Function *New = createPlaceholder(*M);
       Map.insert(It, { Entry, UniqueValuePtr<Function>(New) });
       return New;
     } else {
@@ -61,6 +61,7 @@ public:
 
 public:
   bool isBanned(MetaAddress BB) const { return Banned.contains(BB); }
+  bool hasBannedFunctions() const { return not Banned.empty(); }
 
   bool banRecursiveFunctions();
 };
@@ -69,7 +70,7 @@ bool OutlinedFunctionsMap::banRecursiveFunctions() {
   using namespace llvm;
   bool Result = false;
 
-  CallGraph CallGraph;
+  CallGraph CallGraph(GraphAllocation::Arena);
   std::map<Function *, BasicBlockNode *> ReverseMap;
 
   BasicBlockNode EntryNode(MetaAddress::invalid());
@@ -554,10 +555,81 @@ Outliner::outline(llvm::BasicBlock *Entry, CallHandler *Handler) {
   return Result;
 }
 
+Function *Outliner::getPlaceholder(MetaAddress Entry) {
+  auto It = Placeholders.find(Entry);
+  if (It == Placeholders.end()) {
+    UniqueValuePtr<Function> New(createPlaceholder(M));
+    It = Placeholders.emplace(Entry, std::move(New)).first;
+  }
+
+  return It->second.get();
+}
+
 llvm::Function *
 Outliner::createFunctionToInline(CallHandler *TheCallHandler,
                                  llvm::BasicBlock *Entry,
                                  OutlinedFunctionsMap &FunctionsToInline) {
+  // Cached bodies assume no function is banned from inlining
+  if (FunctionsToInline.hasBannedFunctions())
+    return outlineFunctionToInline(TheCallHandler, Entry, FunctionsToInline);
+
+  MetaAddress Address = getBasicBlockAddress(Entry);
+  auto It = InlinableBodies.find(Address);
+  if (It != InlinableBodies.end()) {
+    const InlinableBody &Cached = It->second;
+    if (Cached.Handler == TheCallHandler
+        and Oracle.answersLike(Cached.Queries)) {
+      // The body depends on the same information as if it was outlined again
+      Oracle.replay(Cached.Queries);
+
+      ValueToValueMapTy VMap;
+      for (MetaAddress Callee : Cached.Callees)
+        VMap[getPlaceholder(Callee)] = FunctionsToInline.get(Callee);
+
+      return CloneFunction(Cached.Body.get(), VMap);
+    }
+  }
+
+  OracleQueries Queries;
+  Oracle.startRecording(Queries);
+  Function *Result = outlineFunctionToInline(TheCallHandler,
+                                             Entry,
+                                             FunctionsToInline);
+  Oracle.stopRecording(Queries);
+
+  // Cache a copy of the body, making it independent from FunctionsToInline
+  InlinableBody New;
+  New.Handler = TheCallHandler;
+  New.Queries = std::move(Queries);
+
+  std::map<Function *, MetaAddress> AddressOf;
+  for (auto &[CalleeAddress, F] : FunctionsToInline)
+    AddressOf[F.get()] = CalleeAddress;
+
+  ValueToValueMapTy VMap;
+  for (Instruction &I : instructions(Result)) {
+    auto *Call = dyn_cast<CallInst>(&I);
+    if (Call == nullptr)
+      continue;
+
+    auto CalleeIt = AddressOf.find(Call->getCalledFunction());
+    if (CalleeIt == AddressOf.end() or VMap.count(CalleeIt->first) != 0)
+      continue;
+
+    VMap[CalleeIt->first] = getPlaceholder(CalleeIt->second);
+    New.Callees.push_back(CalleeIt->second);
+  }
+
+  New.Body = UniqueValuePtr<Function>(CloneFunction(Result, VMap));
+  InlinableBodies[Address] = std::move(New);
+
+  return Result;
+}
+
+llvm::Function *
+Outliner::outlineFunctionToInline(CallHandler *TheCallHandler,
+                                  llvm::BasicBlock *Entry,
+                                  OutlinedFunctionsMap &FunctionsToInline) {
   using namespace llvm;
   LLVMContext &Context = M.getContext();
 
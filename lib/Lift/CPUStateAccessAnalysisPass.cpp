@@ -6,6 +6,9 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <map>
+#include <optional>
+#include <set>
 #include <sstream>
 #include <stack>
 #include <string>
@@ -25,6 +28,7 @@
 #include "revng/Support/IRHelpers.h"
 
 #include "CPUStateAccessAnalysisPass.h"
+#include "HelperCallsCache.h"
 #include "VariableManager.h"
 
 namespace llvm {
@@ -937,7 +941,7 @@ template<class T>
 class CRTPOffsetFolder {
 
 protected:
-  using offset_iterator = std::set<int64_t>::const_iterator;
+  using offset_iterator = CSVOffsets::const_iterator;
   using offset_iterator_range = llvm::iterator_range<offset_iterator>;
   using OffsetPair = std::pair<const CSVOffsets *, const CSVOffsets *>;
 
@@ -1127,9 +1131,16 @@ public:
           CartesianSize *= OffsetSize;
         }
 
+        // Accumulate the results and record them only at the end: the offsets
+        // are stored in vectors and OffsetsIt might point into the offsets of
+        // V itself
+        OptCSVOffsets Folded;
         do {
           CSVOffsets ResOffset = foldOffsets(ResKind, NumSrcs, I, OffsetsIt);
-          insertOrCombine(V, C, std::move(ResOffset), OffsetMap);
+          if (Folded.has_value())
+            Folded->combine(ResOffset);
+          else
+            Folded = std::move(ResOffset);
           // Advance the iterators
           {
             WorkItem::size_type SI = 0;
@@ -1149,6 +1160,8 @@ public:
             revng_log(CSVAccessLog, "incremented");
           }
         } while (--CartesianSize);
+
+        insertOrCombine(V, C, std::move(*Folded), OffsetMap);
       }
     }
   }
@@ -1275,7 +1288,7 @@ private:
           auto IdxIt = GEP->idx_begin();
           auto IdxEnd = GEP->idx_end();
           int IdxOpNum = 1;
-          std::set<int64_t> LastTypeOffsets = { 0 };
+          CSVOffsets::OffsetSet LastTypeOffsets = { 0 };
 
           for (; IdxIt != IdxEnd; ++IdxIt, ++IdxOpNum) {
             const CSVOffsets *IdxCSVOffset = OffsetTuple[IdxOpNum];
@@ -1297,7 +1310,7 @@ private:
                 revng_assert(ArrayNumElem);
                 LastTypeOffsets.clear();
                 for (uint64_t O = 0; O < ArrayNumElem; ++O)
-                  LastTypeOffsets.insert(O);
+                  LastTypeOffsets.push_back(O);
 
                 ConstIdxList.push_back(0);
               } else if (ElementTy->isStructTy()) {
@@ -1318,8 +1331,7 @@ private:
                   ConstIdxList.push_back(*IdxCSVOffset->begin());
 
                   revng_assert(IdxCSVOffset->size() != 0);
-                  LastTypeOffsets.clear();
-                  LastTypeOffsets.insert(IdxCSVOffset->begin(),
+                  LastTypeOffsets.assign(IdxCSVOffset->begin(),
                                          IdxCSVOffset->end());
                 }
               } else {
@@ -2307,7 +2319,7 @@ void CPUSAOA::computeAggregatedOffsets() {
           New = O;
         } else {
           revng_assert(O.size());
-          std::set<int64_t> FineGrainedOffsets;
+          CSVOffsets::OffsetSet FineGrainedOffsets;
           // Now compute the fine-grained offsets
           for (const int64_t Coarse : O) {
             int64_t Refined = Coarse;
@@ -2322,7 +2334,7 @@ void CPUSAOA::computeAggregatedOffsets() {
                 Type *AccessedTy = AccessedVar->getValueType();
                 SizeAtOffset = DL.getTypeAllocSize(AccessedTy) - InternalOffset;
                 revng_assert(SizeAtOffset > 0);
-                FineGrainedOffsets.insert(Refined - InternalOffset);
+                FineGrainedOffsets.push_back(Refined - InternalOffset);
                 CSVAccessLog << "Value: " << I << DoLog;
                 CSVAccessLog << "Insert Refined: " << Refined << DoLog;
               } else {
@@ -3056,6 +3068,47 @@ bool CPUStateAccessFixer::run() {
   return true;
 }
 
+/// Computes a string identifying a call to a helper whose arguments are either
+/// loads from env or constants.
+///
+/// The accesses to the CPU state performed by such a call depend only on the
+/// helpers and on the signature, therefore they can be reused for any other
+/// call with the same signature, in this or in other modules.
+static std::optional<std::string>
+getContextFreeSignature(const CallInst *Call, const Value *CPUStatePtr) {
+  const Function *Callee = getCallee(Call);
+  if (Callee == nullptr)
+    return std::nullopt;
+
+  std::string Result;
+  raw_string_ostream Stream(Result);
+  Stream << Callee->getName() << "(";
+  for (const Use &Argument : Call->args()) {
+    if (Argument.getOperandNo() != 0)
+      Stream << ",";
+
+    const Value *V = Argument.get();
+    if (V == CPUStatePtr) {
+      Stream << "&env";
+    } else if (auto *Load = dyn_cast<LoadInst>(V);
+               Load != nullptr
+               and Load->getPointerOperand()->stripPointerCasts()
+                     == CPUStatePtr) {
+      Stream << "env";
+    } else if (auto *Constant = dyn_cast<ConstantInt>(V)) {
+      Stream << "i" << Constant->getBitWidth() << " ";
+      Constant->getValue().print(Stream, false);
+    } else if (isa<ConstantPointerNull>(V)) {
+      Stream << "null";
+    } else {
+      return std::nullopt;
+    }
+  }
+  Stream << ")";
+
+  return Stream.str();
+}
+
 class CPUStateAccessAnalysis {
 
 private:
@@ -3103,6 +3156,12 @@ public:
 
 private:
   void forceEmptyMetadata(Function *RootFunction) const;
+
+  /// Decorates the context-free calls to helpers in \p RootFunction whose
+  /// accesses are known to \p Cache and collects the other ones in \p Missing
+  void applyCachedResults(Function *RootFunction,
+                          const HelperCallsCache &Cache,
+                          std::map<CallInst *, std::string> &Missing) const;
 };
 
 static void addAccessMetadata(const CallSiteOffsetMap &OffsetMap,
@@ -3168,6 +3227,66 @@ void CPUStateAccessAnalysis::forceEmptyMetadata(Function *RootFunction) const {
   }
 }
 
+void CPUStateAccessAnalysis::applyCachedResults(
+  Function *RootFunction,
+  const HelperCallsCache &Cache,
+  std::map<CallInst *, std::string> &Missing) const {
+  CallSiteOffsetMap CallSiteLoadOffset;
+  CallSiteOffsetMap CallSiteStoreOffset;
+  for (BasicBlock &BB : *RootFunction) {
+    for (Instruction &I : BB) {
+      if (not isCallToHelper(&I))
+        continue;
+
+      // Already decorated by a previous run
+      if (I.getMetadata(LoadMDKind) != nullptr
+          or I.getMetadata(StoreMDKind) != nullptr)
+        continue;
+
+      auto *Call = cast<CallInst>(&I);
+      auto Signature = getContextFreeSignature(Call, CPUStatePtr);
+      if (not Signature.has_value())
+        continue;
+
+      if (auto Cached = Cache.find(*Signature)) {
+        CallSiteLoadOffset.emplace(Call, Cached->Load);
+        CallSiteStoreOffset.emplace(Call, Cached->Store);
+      } else {
+        Missing.emplace(Call, std::move(*Signature));
+      }
+    }
+  }
+
+  revng_log(CSVAccessLog,
+            CallSiteLoadOffset.size() << " calls to helpers found in cache, "
+                                      << Missing.size() << " missing");
+
+  QuickMetadata QMD(M.getContext());
+  addAccessMetadata(CallSiteLoadOffset, Variables, QMD, LoadMDKind);
+  addAccessMetadata(CallSiteStoreOffset, Variables, QMD, StoreMDKind);
+}
+
+/// Records in \p Cache the results of the analysis for the calls in \p Missing.
+/// Calls that are not in the maps have been decorated with empty metadata.
+static void recordResults(HelperCallsCache &Cache,
+                          const std::map<CallInst *, std::string> &Missing,
+                          const CallSiteOffsetMap &CallSiteLoadOffset,
+                          const CallSiteOffsetMap &CallSiteStoreOffset) {
+  auto Lookup = [](const CallSiteOffsetMap &Map, CallInst *Call) {
+    auto It = Map.find(Call);
+    if (It == Map.end())
+      return CSVOffsets(CSVOffsets::KnownInPtr);
+    return It->second;
+  };
+
+  for (const auto &[Call, Signature] : Missing)
+    Cache.record(Signature,
+                 { Lookup(CallSiteLoadOffset, Call),
+                   Lookup(CallSiteStoreOffset, Call) });
+
+  Cache.save();
+}
+
 bool CPUStateAccessAnalysis::run() {
 
   if (CPUStatePtr == nullptr)
@@ -3177,6 +3296,13 @@ bool CPUStateAccessAnalysis::run() {
   Function *RootFunction = M.getFunction("root");
   revng_assert(RootFunction);
 
+  // In lazy mode, reuse the results of the analysis of the context-free calls
+  // to helpers obtained in previous runs, possibly on other modules
+  HelperCallsCache *Cache = Lazy ? HelperCallsCache::get(M) : nullptr;
+  std::map<CallInst *, std::string> Missing;
+  if (Cache != nullptr)
+    applyCachedResults(RootFunction, *Cache, Missing);
+
   // Preprocessing: detect all the functions that are directly reachable from
   // the RootFunction
   auto ReachedFunctions = computeDirectlyReachableFunctions(RootFunction,
@@ -3205,6 +3331,8 @@ bool CPUStateAccessAnalysis::run() {
   if (TaintResults.TaintedLoads.empty()
       and TaintResults.TaintedStores.empty()) {
     forceEmptyMetadata(RootFunction);
+    if (Cache != nullptr)
+      recordResults(*Cache, Missing, {}, {});
     return TaintResults.IllegalCalls.size();
   }
 
@@ -3259,6 +3387,14 @@ bool CPUStateAccessAnalysis::run() {
   }
 
   forceEmptyMetadata(RootFunction);
+
+  if (Cache != nullptr) {
+    if (Found)
+      recordResults(*Cache, Missing, CallSiteLoadOffset, CallSiteStoreOffset);
+    else
+      recordResults(*Cache, Missing, {}, {});
+  }
+
   return Found;
 }
 
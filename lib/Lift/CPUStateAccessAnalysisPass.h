@@ -14,6 +14,10 @@
 
 #include "CSVOffsets.h"
 
+/// Name of the named metadata holding the hash identifying the helpers module
+/// linked in the lifted module
+inline constexpr const char *HelpersHashName = "revng.helpers.hash";
+
 namespace llvm {
 class Instruction;
 }
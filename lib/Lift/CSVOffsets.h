@@ -4,7 +4,11 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
-#include <set>
+#include <algorithm>
+#include <iterator>
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
 
 #include "revng/Support/Assert.h"
 
@@ -15,8 +19,9 @@ class Logger;
 /// possible offsets.
 class CSVOffsets {
 
-private:
-  using OffsetSet = std::set<int64_t>;
+public:
+  /// Sorted vector of unique offsets: most accesses have very few of them
+  using OffsetSet = llvm::SmallVector<int64_t, 4>;
 
 public:
   using iterator = OffsetSet::iterator;
@@ -66,9 +71,11 @@ public:
     // Useful for debug revng_assert(not isUnknown(K) and not
     // isUnknownInPtr(K));
   }
-  CSVOffsets(Kind K, std::set<int64_t> O) : OffsetKind(K), Offsets(O) {
+  CSVOffsets(Kind K, OffsetSet O) : OffsetKind(K), Offsets(std::move(O)) {
     // Useful for debug revng_assert(not isUnknown(K) and not
     // isUnknownInPtr(K));
+    llvm::sort(Offsets);
+    Offsets.erase(std::unique(Offsets.begin(), Offsets.end()), Offsets.end());
   }
 
 public:
@@ -81,8 +88,8 @@ public:
   iterator begin() { return Offsets.begin(); }
   iterator end() { return Offsets.end(); }
 
-  const_iterator begin() const { return Offsets.cbegin(); }
-  const_iterator end() const { return Offsets.cend(); }
+  const_iterator begin() const { return Offsets.begin(); }
+  const_iterator end() const { return Offsets.end(); }
 
   size_type size() const { return Offsets.size(); }
   size_type empty() const { return Offsets.empty(); }
@@ -139,13 +146,18 @@ public:
     return K;
   }
 
-  void insert(int64_t O) { Offsets.insert(O); }
+  void insert(int64_t O) {
+    auto It = llvm::lower_bound(Offsets, O);
+    if (It == Offsets.end() or *It != O)
+      Offsets.insert(It, O);
+  }
+
   void combine(const CSVOffsets &Other) {
     Kind K0 = OffsetKind;
     Kind K1 = Other.OffsetKind;
     // For equal kinds just merge the offsets
     if (K0 == K1) {
-      Offsets.insert(Other.Offsets.begin(), Other.Offsets.end());
+      merge(Other.Offsets);
       return;
     }
 
@@ -177,7 +189,7 @@ public:
         Offsets = {};
       } else {
         OffsetKind = Kind::OutAndKnownInPtr;
-        Offsets.insert(Other.Offsets.begin(), Other.Offsets.end());
+        merge(Other.Offsets);
       }
       return;
     }
@@ -198,4 +210,23 @@ public:
     OffsetKind = Kind::Unknown;
     Offsets = {};
   }
+
+private:
+  void merge(const OffsetSet &Other) {
+    // Avoid allocating in the common case of Other being a subset
+    if (std::includes(Offsets.begin(),
+                      Offsets.end(),
+                      Other.begin(),
+                      Other.end()))
+      return;
+
+    OffsetSet Result;
+    Result.reserve(Offsets.size() + Other.size());
+    std::set_union(Offsets.begin(),
+                   Offsets.end(),
+                   Other.begin(),
+                   Other.end(),
+                   std::back_inserter(Result));
+    Offsets = std::move(Result);
+  }
 };
@@ -9,6 +9,7 @@
 #include <cstring>
 #include <fstream>
 #include <memory>
+#include <optional>
 #include <queue>
 #include <set>
 #include <sstream>
@@ -16,8 +17,12 @@
 #include <utility>
 #include <vector>
 
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/Config/llvm-config.h"
 #include "llvm/ExecutionEngine/RuntimeDyld.h"
 #include "llvm/IR/CFG.h"
 #include "llvm/IR/DiagnosticPrinter.h"
@@ -29,6 +34,10 @@
 #include "llvm/IRReader/IRReader.h"
 #include "llvm/Linker/Linker.h"
 #include "llvm/Support/Casting.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MD5.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/raw_os_ostream.h"
 #include "llvm/Transforms/InstCombine/InstCombine.h"
@@ -47,7 +56,9 @@
 #include "revng/Support/CommandLine.h"
 #include "revng/Support/Debug.h"
 #include "revng/Support/FunctionTags.h"
+#include "revng/Support/PathList.h"
 #include "revng/Support/ProgramCounterHandler.h"
+#include "revng/Support/Statistics.h"
 
 #include "CodeGenerator.h"
 #include "ExternalJumpsHandler.h"
@@ -66,9 +77,28 @@ static cl::opt<bool> RecordPTC("record-ptc",
                                cl::desc("create metadata for PTC"),
                                cl::cat(MainCategory));
 
+static cl::opt<bool> CacheHelpers("cache-helpers",
+                                  cl::desc("cache the prepared helpers module "
+                                           "in the user cache directory"),
+                                  cl::cat(MainCategory),
+                                  cl::init(true));
+
 static Logger<> PTCLog("ptc");
 static Logger<> Log("lift");
 
+/// Time spent, in milliseconds, by the PTC translating each block, and the
+/// amount of bytes each translation consumed
+static RunningStatistics PTCTranslationTime("ptc-translation-ms");
+static RunningStatistics PTCTranslationSize("ptc-translation-bytes");
+
+/// Bump this whenever prepareHelpers changes, in order to invalidate the
+/// helpers modules cached on disk
+static constexpr unsigned HelpersCacheVersion = 1;
+
+/// Prepared helpers modules, serialized as bitcode, indexed by the hash of
+/// their inputs. Modules cannot be shared across LLVMContexts, bitcode can.
+static StringMap<std::unique_ptr<MemoryBuffer>> PreparedHelpers;
+
 template<typename T, typename... ArgTypes>
 inline std::array<T, sizeof...(ArgTypes)> make_array(ArgTypes &&...Args) {
   return { { std::forward<ArgTypes>(Args)... } };
@@ -144,6 +174,21 @@ static std::unique_ptr<Module> parseIR(StringRef Path, LLVMContext &Context) {
   return Result;
 }
 
+static std::unique_ptr<Module> tryParseIR(MemoryBufferRef Buffer,
+                                          LLVMContext &Context) {
+  SMDiagnostic Errors;
+  std::unique_ptr<Module> Result = parseIR(Buffer, Errors, Context);
+
+  if (Result.get() == nullptr)
+    Errors.print("revng", dbgs());
+
+  return Result;
+}
+
+static std::unique_ptr<Module> loadHelpers(StringRef Path,
+                                           LLVMContext &Context,
+                                           std::string &Key);
+
 CodeGenerator::CodeGenerator(const RawBinaryView &RawBinary,
                              llvm::Module *TheModule,
                              const TupleTree<model::Binary> &Model,
@@ -159,7 +204,25 @@ CodeGenerator::CodeGenerator(const RawBinaryView &RawBinary,
   OriginalInstrMDKind = Context.getMDKindID("oi");
   PTCInstrMDKind = Context.getMDKindID("pi");
 
-  HelpersModule = parseIR(Helpers, Context);
+  std::string HelpersHash;
+  HelpersModule = loadHelpers(Helpers, Context, HelpersHash);
+
+  // Record the identity of the helpers, so that the analyses of the lifted
+  // module can cache their results about the helpers
+  QuickMetadata QMD(Context);
+  auto *HelpersHashMD = TheModule->getOrInsertNamedMetadata(HelpersHashName);
+  HelpersHashMD->clearOperands();
+  HelpersHashMD->addOperand(QMD.tuple(HelpersHash));
+
+  // Record the contents of the segments too: the model only describes where
+  // they are, the same model might be lifted from a different binary
+  hash_code SegmentsHash = hash_value(0);
+  for (auto &[Segment, Data] : RawBinary.segments())
+    SegmentsHash = hash_combine(SegmentsHash,
+                                hash_combine_range(Data.begin(), Data.end()));
+  auto *SegmentsHashMD = TheModule->getOrInsertNamedMetadata(SegmentsHashName);
+  SegmentsHashMD->clearOperands();
+  SegmentsHashMD->addOperand(QMD.tuple(static_cast<uint64_t>(SegmentsHash)));
 
   TheModule->setDataLayout(HelpersModule->getDataLayout());
 
@@ -576,36 +639,20 @@ bool CpuLoopExitPass::runOnModule(llvm::Module &M) {
   return true;
 }
 
-void CodeGenerator::translate(optional<uint64_t> RawVirtualAddress) {
-  using FT = FunctionType;
-
-  // Declare the abort function
-  auto *AbortTy = FunctionType::get(Type::getVoidTy(Context), false);
-  FunctionCallee AbortFunction = TheModule->getOrInsertFunction("abort",
-                                                                AbortTy);
-  {
-    auto *Abort = cast<Function>(skipCasts(AbortFunction.getCallee()));
-    FunctionTags::Exceptional.addTo(Abort);
-  }
-
+/// Prepare the helpers module to be linked in the lifted module: transform the
+/// cpu_loop function, run SROA and turn some QEMU functions into no-ops or
+/// aborts
+static void prepareHelpers(Module &HelpersModule) {
   // Prepare the helper modules by transforming the cpu_loop function and
   // running SROA
   legacy::PassManager CpuLoopPM;
   CpuLoopPM.add(new LoopInfoWrapperPass());
   CpuLoopPM.add(new CpuLoopFunctionPass(ptc.exception_index));
   CpuLoopPM.add(createSROAPass());
-  CpuLoopPM.run(*HelpersModule);
+  CpuLoopPM.run(HelpersModule);
 
   // Drop the main
-  eraseFromParent(HelpersModule->getFunction("main"));
-
-  // From syscall.c
-  new GlobalVariable(*TheModule,
-                     Type::getInt32Ty(Context),
-                     false,
-                     GlobalValue::CommonLinkage,
-                     ConstantInt::get(Type::getInt32Ty(Context), 0),
-                     StringRef("do_strace"));
+  eraseFromParent(HelpersModule.getFunction("main"));
 
   //
   // Handle some specific QEMU functions as no-ops or abort
@@ -628,7 +675,7 @@ void CodeGenerator::translate(optional<uint64_t> RawVirtualAddress) {
                                                     "qemu_thread_atexit_init",
                                                     "start_exclusive");
   for (auto Name : NoOpFunctionNames)
-    replaceFunctionWithRet(HelpersModule->getFunction(Name), 0);
+    replaceFunctionWithRet(HelpersModule.getFunction(Name), 0);
 
   // Transform in abort
 
@@ -647,18 +694,105 @@ void CodeGenerator::translate(optional<uint64_t> RawVirtualAddress) {
                                                      "do_arm_semihosting",
                                                      "EmulateAll");
   for (auto Name : AbortFunctionNames) {
-    Function *TheFunction = HelpersModule->getFunction(Name);
+    Function *TheFunction = HelpersModule.getFunction(Name);
     if (TheFunction != nullptr) {
-      revng_assert(HelpersModule->getFunction("abort") != nullptr);
+      revng_assert(HelpersModule.getFunction("abort") != nullptr);
       BasicBlock *NewBody = replaceFunction(TheFunction);
-      CallInst::Create(HelpersModule->getFunction("abort"), {}, NewBody);
-      new UnreachableInst(Context, NewBody);
+      CallInst::Create(HelpersModule.getFunction("abort"), {}, NewBody);
+      new UnreachableInst(HelpersModule.getContext(), NewBody);
     }
   }
 
-  replaceFunctionWithRet(HelpersModule->getFunction("page_check_range"), 1);
-  replaceFunctionWithRet(HelpersModule->getFunction("page_get_flags"),
+  replaceFunctionWithRet(HelpersModule.getFunction("page_check_range"), 1);
+  replaceFunctionWithRet(HelpersModule.getFunction("page_get_flags"),
                          0xffffffff);
+}
+
+static std::string helpersCacheKey(MemoryBufferRef Helpers) {
+  MD5 Hasher;
+  Hasher.update(Helpers.getBuffer());
+  Hasher.update(LLVM_VERSION_STRING);
+  Hasher.update((Twine(HelpersCacheVersion) + " "
+                 + Twine(ptc.exception_index))
+                  .str());
+
+  MD5::MD5Result Result;
+  Hasher.final(Result);
+  return Result.digest().str().str();
+}
+
+/// Load the helpers module from \p Path and prepare it, possibly reusing the
+/// result of a previous preparation of the same module
+///
+/// \param Key set to the hash identifying the prepared helpers module
+static std::unique_ptr<Module> loadHelpers(StringRef Path,
+                                           LLVMContext &Context,
+                                           std::string &Key) {
+  auto MaybeBuffer = MemoryBuffer::getFile(Path);
+  revng_check(MaybeBuffer, "Cannot read the helpers module");
+  MemoryBufferRef Helpers = (*MaybeBuffer)->getMemBufferRef();
+
+  Key = helpersCacheKey(Helpers);
+  std::optional<std::string> CachePath;
+  if (CacheHelpers)
+    CachePath = getCachePath("helpers", Key + ".bc");
+
+  auto It = PreparedHelpers.find(Key);
+  if (It == PreparedHelpers.end() and CachePath.has_value()) {
+    if (auto Cached = MemoryBuffer::getFile(*CachePath)) {
+      revng_log(Log, "Loading the prepared helpers from " << *CachePath);
+      It = PreparedHelpers.try_emplace(Key, std::move(*Cached)).first;
+    }
+  }
+
+  if (It != PreparedHelpers.end()) {
+    if (auto Result = tryParseIR(It->second->getMemBufferRef(), Context))
+      return Result;
+
+    // The cached module is corrupted, prepare it again
+    PreparedHelpers.erase(It);
+  }
+
+  std::unique_ptr<Module> Result = tryParseIR(Helpers, Context);
+  revng_check(Result != nullptr, "Cannot parse the helpers module");
+  prepareHelpers(*Result);
+
+  SmallVector<char, 0> Bitcode;
+  {
+    raw_svector_ostream Stream(Bitcode);
+    WriteBitcodeToFile(*Result, Stream);
+  }
+  StringRef BitcodeRef(Bitcode.data(), Bitcode.size());
+
+  if (CachePath.has_value()) {
+    if (Error E = writeFileAtomically(*CachePath, BitcodeRef))
+      revng_log(Log, "Cannot cache the helpers: " << toString(std::move(E)));
+  }
+
+  PreparedHelpers[Key] = MemoryBuffer::getMemBufferCopy(BitcodeRef, Path);
+
+  return Result;
+}
+
+void CodeGenerator::translate(optional<uint64_t> RawVirtualAddress) {
+  using FT = FunctionType;
+
+  // Declare the abort function
+  auto *AbortTy = FunctionType::get(Type::getVoidTy(Context), false);
+  FunctionCallee AbortFunction = TheModule->getOrInsertFunction("abort",
+                                                                AbortTy);
+  {
+    auto *Abort = cast<Function>(skipCasts(AbortFunction.getCallee()));
+    FunctionTags::Exceptional.addTo(Abort);
+  }
+
+  // From syscall.c
+  new GlobalVariable(*TheModule,
+                     Type::getInt32Ty(Context),
+                     false,
+                     GlobalValue::CommonLinkage,
+                     ConstantInt::get(Type::getInt32Ty(Context), 0),
+                     StringRef("do_strace"));
 
   //
   // Record globals for marking them as internal after linking
@@ -880,9 +1014,13 @@ void CodeGenerator::translate(optional<uint64_t> RawVirtualAddress) {
       break;
     }
 
-    ConsumedSize = ptc.translate(VirtualAddress.address(),
-                                 Type,
-                                 InstructionList.get());
+    {
+      ScopedRunningStatisticsTimer Timer(PTCTranslationTime);
+      ConsumedSize = ptc.translate(VirtualAddress.address(),
+                                   Type,
+                                   InstructionList.get());
+    }
+    PTCTranslationSize.push(ConsumedSize);
 
     if (ConsumedSize == 0) {
       Translator.emitNewPCCall(Builder, VirtualAddress, 1, nullptr);
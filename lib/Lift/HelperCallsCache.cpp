@@ -0,0 +1,154 @@
+/// \file HelperCallsCache.cpp
+/// \brief Cache of the accesses to the CPU state of context-free helper calls
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "revng/Support/Debug.h"
+#include "revng/Support/PathList.h"
+
+#include "CPUStateAccessAnalysisPass.h"
+#include "HelperCallsCache.h"
+
+using namespace llvm;
+
+static Logger<> Log("helper-calls-cache");
+
+cl::opt<bool> CacheHelperAccesses("cache-helper-accesses",
+                                  cl::desc("persist the accesses to the CPU "
+                                           "state of context-free calls to "
+                                           "helpers in the user cache "
+                                           "directory"),
+                                  cl::cat(MainCategory),
+                                  cl::init(false));
+
+HelperCallsCache::HelperCallsCache(std::string Path) : Path(std::move(Path)) {
+  load();
+}
+
+HelperCallsCache *HelperCallsCache::get(const Module &M) {
+  static std::mutex CachesMutex;
+  static std::map<std::string, HelperCallsCache> Caches;
+
+  NamedMDNode *HashMD = M.getNamedMetadata(HelpersHashName);
+  if (HashMD == nullptr or HashMD->getNumOperands() != 1)
+    return nullptr;
+
+  auto *Tuple = HashMD->getOperand(0);
+  if (Tuple->getNumOperands() != 1)
+    return nullptr;
+
+  auto *Hash = dyn_cast<MDString>(Tuple->getOperand(0));
+  if (Hash == nullptr)
+    return nullptr;
+
+  std::lock_guard Lock(CachesMutex);
+  std::string Key = Hash->getString().str();
+  auto It = Caches.find(Key);
+  if (It != Caches.end())
+    return &It->second;
+
+  std::optional<std::string> Path;
+  if (CacheHelperAccesses)
+    Path = getCachePath("helper-accesses", getFileName(Key));
+
+  if (Path.has_value())
+    It = Caches.try_emplace(Key, std::move(*Path)).first;
+  else
+    It = Caches.try_emplace(Key).first;
+
+  return &It->second;
+}
+
+std::string HelperCallsCache::getFileName(StringRef HelpersHash) {
+  return ("v" + Twine(Version) + "-" + HelpersHash + ".txt").str();
+}
+
+static void serialize(raw_ostream &Stream, const CSVOffsets &Offsets) {
+  Stream << static_cast<unsigned>(Offsets.getKind());
+  for (int64_t Offset : Offsets)
+    Stream << " " << Offset;
+}
+
+static std::optional<CSVOffsets> deserialize(StringRef Text) {
+  SmallVector<StringRef, 8> Parts;
+  Text.split(Parts, ' ');
+
+  unsigned Kind = 0;
+  if (Parts[0].getAsInteger(10, Kind) or Kind > CSVOffsets::OutAndUnknownInPtr)
+    return std::nullopt;
+
+  auto OffsetsKind = static_cast<CSVOffsets::Kind>(Kind);
+  if (not CSVOffsets::isPtr(OffsetsKind))
+    return std::nullopt;
+
+  CSVOffsets::OffsetSet Offsets;
+  for (StringRef Part : llvm::drop_begin(Parts)) {
+    int64_t Offset = 0;
+    if (Part.getAsInteger(10, Offset))
+      return std::nullopt;
+    Offsets.push_back(Offset);
+  }
+
+  return CSVOffsets(OffsetsKind, std::move(Offsets));
+}
+
+void HelperCallsCache::load() {
+  revng_assert(Path.has_value());
+
+  auto MaybeBuffer = MemoryBuffer::getFile(*Path);
+  if (not MaybeBuffer)
+    return;
+
+  // Each line is in the form: signature, load offsets, store offsets
+  SmallVector<StringRef, 64> Lines;
+  (*MaybeBuffer)->getBuffer().split(Lines, '\n', -1, false);
+  for (StringRef Line : Lines) {
+    SmallVector<StringRef, 3> Fields;
+    Line.split(Fields, '\t');
+    if (Fields.size() != 3)
+      continue;
+
+    auto Load = deserialize(Fields[1]);
+    auto Store = deserialize(Fields[2]);
+    if (not Load.has_value() or not Store.has_value()) {
+      revng_log(Log, "Ignoring malformed cache entry: " << Line);
+      continue;
+    }
+
+    Entries.try_emplace(Fields[0].str(), Accesses{ *Load, *Store });
+  }
+}
+
+void HelperCallsCache::save() {
+  std::lock_guard Lock(Mutex);
+  if (not Changed or not Path.has_value())
+    return;
+
+  std::string Buffer;
+  raw_string_ostream Stream(Buffer);
+  for (const auto &[Signature, Results] : Entries) {
+    Stream << Signature << "\t";
+    serialize(Stream, Results.Load);
+    Stream << "\t";
+    serialize(Stream, Results.Store);
+    Stream << "\n";
+  }
+
+  if (auto Error = writeFileAtomically(*Path, Stream.str())) {
+    revng_log(Log,
+              "Cannot store the helper calls cache: "
+                << toString(std::move(Error)));
+    return;
+  }
+
+  Changed = false;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "llvm/ADT/StringRef.h"
+
+#include "revng/Support/CommandLine.h"
+
+#include "CSVOffsets.h"
+
+namespace llvm {
+class Module;
+}
+
+/// Whether to persist in the user cache directory the results of the analysis
+/// of the context-free calls to helpers
+extern llvm::cl::opt<bool> CacheHelperAccesses;
+
+/// Cache of the accesses to the CPU state performed by context-free calls to
+/// helpers, i.e., calls whose arguments are env, loads from env or constants.
+///
+/// There's a cache for each helpers module, shared by all the runs of the
+/// analysis in this process. If CacheHelperAccesses is enabled, it's also
+/// persisted in the user cache directory.
+class HelperCallsCache {
+public:
+  /// Bump this whenever CPUStateAccessAnalysis or the format of the cache
+  /// change, in order to invalidate the caches persisted on disk
+  static constexpr unsigned Version = 1;
+
+public:
+  struct Accesses {
+    CSVOffsets Load;
+    CSVOffsets Store;
+  };
+
+private:
+  std::optional<std::string> Path;
+  std::map<std::string, Accesses> Entries;
+  bool Changed = false;
+  mutable std::mutex Mutex;
+
+public:
+  /// Create an in-memory cache
+  HelperCallsCache() = default;
+
+  /// Create a cache persisted at \p Path, loading its current contents
+  explicit HelperCallsCache(std::string Path);
+
+public:
+  /// \return the cache for the helpers linked in \p M, or nullptr if they are
+  ///         not known
+  static HelperCallsCache *get(const llvm::Module &M);
+
+  /// \return the name of the file persisting the cache for the helpers module
+  ///         identified by \p HelpersHash
+  static std::string getFileName(llvm::StringRef HelpersHash);
+
+public:
+  std::optional<Accesses> find(const std::string &Signature) const {
+    std::lock_guard Lock(Mutex);
+    auto It = Entries.find(Signature);
+    if (It == Entries.end())
+      return std::nullopt;
+    return It->second;
+  }
+
+  void record(const std::string &Signature, Accesses &&Results) {
+    std::lock_guard Lock(Mutex);
+    Changed |= Entries.try_emplace(Signature, std::move(Results)).second;
+  }
+
+  /// Write the cache to disk, if it's persisted and it changed
+  void save();
+
+private:
+  void load();
+};
@@ -17,6 +17,7 @@
 #include "boost/type_traits/is_same.hpp"
 
 #include "llvm/ADT/DepthFirstIterator.h"
+#include "llvm/ADT/SetVector.h"
 #include "llvm/Analysis/BasicAliasAnalysis.h"
 #include "llvm/Analysis/ScopedNoAliasAA.h"
 #include "llvm/CodeGen/UnreachableBlockElim.h"
@@ -69,6 +70,14 @@ Logger<> RegisterJTLog("registerjt");
 
 CounterMap<std::string> HarvestingStats("harvesting");
 RunningStatistics BlocksAnalyzedByAVI("blocks-analyzed-by-avi");
+CounterMap<std::string> MemoryUsage("jump-target-manager-bytes");
+
+cl::opt<unsigned> AVISliceRadius("avi-slice-radius",
+                                 cl::desc("if non-zero, harvest with AVI only "
+                                          "the code within this amount of "
+                                          "basic blocks from the new ones"),
+                                 cl::cat(MainCategory),
+                                 cl::init(0));
 
 RegisterPass<TranslateDirectBranchesPass> X("translate-db",
                                             "Translate Direct Branches"
@@ -415,7 +424,9 @@ MaterializedValue JumpTargetManager::readFromPointer(Type *Type,
   }
   auto LoadAddress = fromGeneric(RawLoadAddress);
 
-  UnusedCodePointers.erase(LoadAddress);
+  auto CodePointerIt = UnusedCodePointers.find(LoadAddress);
+  if (CodePointerIt != UnusedCodePointers.end())
+    ReadCodePointers.set(CodePointerIt - UnusedCodePointers.begin());
   registerReadRange(LoadAddress, LoadSize);
 
   // Prevent overflow when computing the label interval
@@ -508,21 +519,7 @@ JumpTargetManager::JumpTargetManager(Function *TheFunction,
   //
   // Collect executable ranges from the model
   //
-  for (const model::Segment &Segment : Model->Segments()) {
-    if (Segment.IsExecutable()) {
-      if (Segment.Sections().size() > 0) {
-        for (const model::Section &Section : Segment.Sections()) {
-          if (Section.ContainsCode()) {
-            ExecutableRanges.emplace_back(Section.StartAddress(),
-                                          Section.endAddress());
-          }
-        }
-      } else {
-        ExecutableRanges.emplace_back(Segment.StartAddress(),
-                                      Segment.endAddress());
-      }
-    }
-  }
+  ExecutableRanges = Model->executableRanges();
 
   // Configure GlobalValueNumbering
   StringMap<cl::Option *> &Options(cl::getRegisteredOptions());
@@ -541,6 +538,9 @@ void JumpTargetManager::harvestGlobalData() {
   for (MetaAddress Address : Model->ExtraCodeAddresses())
     registerJT(Address, JTReason::GlobalData);
 
+  // Collect the pointers to code in a single batch, which sorts them once at
+  // the end
+  auto CodePointers = UnusedCodePointers.batch_insert_or_assign();
   for (auto &[Segment, Data] : BinaryView.segments()) {
     MetaAddress StartVirtualAddress = Segment.StartAddress();
     const unsigned char *DataStart = Data.begin();
@@ -554,22 +554,28 @@ void JumpTargetManager::harvestGlobalData() {
       if (IsLittleEndian)
         findCodePointers<uint64_t, endianness::little>(StartVirtualAddress,
                                                        DataStart,
-                                                       DataEnd);
+                                                       DataEnd,
+                                                       CodePointers);
       else
         findCodePointers<uint64_t, endianness::big>(StartVirtualAddress,
                                                     DataStart,
-                                                    DataEnd);
+                                                    DataEnd,
+                                                    CodePointers);
     } else if (PointerSize == 4) {
       if (IsLittleEndian)
         findCodePointers<uint32_t, endianness::little>(StartVirtualAddress,
                                                        DataStart,
-                                                       DataEnd);
+                                                       DataEnd,
+                                                       CodePointers);
       else
         findCodePointers<uint32_t, endianness::big>(StartVirtualAddress,
                                                     DataStart,
-                                                    DataEnd);
+                                                    DataEnd,
+                                                    CodePointers);
     }
   }
+  CodePointers.commit();
+  ReadCodePointers.resize(UnusedCodePointers.size());
 
   revng_log(JTCountLog,
             "JumpTargets found in global data: " << std::dec
@@ -579,7 +585,9 @@ void JumpTargetManager::harvestGlobalData() {
 template<typename value_type, unsigned endian>
 void JumpTargetManager::findCodePointers(MetaAddress StartVirtualAddress,
                                          const unsigned char *Start,
-                                         const unsigned char *End) {
+                                         const unsigned char *End,
+                                         CodePointersSet::BatchInsertOrAssigner
+                                           &CodePointers) {
   using support::endianness;
   using support::endian::read;
   for (auto Pos = Start; Pos < End - sizeof(value_type); Pos++) {
@@ -592,7 +600,7 @@ void JumpTargetManager::findCodePointers(MetaAddress StartVirtualAddress,
     BasicBlock *Result = registerJT(Value, JTReason::GlobalData);
 
     if (Result != nullptr)
-      UnusedCodePointers.insert(StartVirtualAddress + (Pos - Start));
+      CodePointers.insert_or_assign(StartVirtualAddress + (Pos - Start));
   }
 }
 
@@ -1380,6 +1388,102 @@ CallInst *JumpTargetManager::getJumpTarget(BasicBlock *Target) {
   return nullptr;
 }
 
+/// Estimate of the memory used by a node-based container (e.g., std::map): each
+/// node holds the value, three pointers and the color
+template<typename T>
+static size_t nodesSize(const T &Container) {
+  using value_type = typename T::value_type;
+  return Container.size() * (sizeof(value_type) + 4 * sizeof(void *));
+}
+
+template<typename T>
+static size_t vectorSize(const T &Container) {
+  return Container.capacity() * sizeof(typename T::value_type);
+}
+
+void JumpTargetManager::reportMemoryUsage() const {
+  MemoryUsage.push("JumpTargets", nodesSize(JumpTargets));
+  MemoryUsage.push("OriginalInstructionAddresses",
+                   nodesSize(OriginalInstructionAddresses));
+  MemoryUsage.push("UnusedCodePointers",
+                   UnusedCodePointers.size() * sizeof(MetaAddress)
+                     + ReadCodePointers.getMemorySize());
+  MemoryUsage.push("SimpleLiterals", vectorSize(SimpleLiterals));
+  MemoryUsage.push("Unexplored", vectorSize(Unexplored));
+  MemoryUsage.push("ToPurge", nodesSize(ToPurge));
+  MemoryUsage.push("AVIPCWhiteList", nodesSize(AVIPCWhiteList));
+}
+
+JumpTargetManager::MetaAddressSet
+JumpTargetManager::sliceAVIWhitelist(unsigned Radius,
+                                     std::set<BasicBlock *> &Slice) {
+  MetaAddressSet Result;
+
+  // Collect the new basic blocks (i.e., those in AVIPCWhiteList)
+  std::vector<BasicBlock *> NewBlocks;
+  for (User *NewPCUser : TheModule.getFunction("newpc")->users()) {
+    auto *I = cast<Instruction>(NewPCUser);
+    auto WhitelistedMA = addressFromNewPC(I);
+    if (WhitelistedMA.isValid() and AVIPCWhiteList.count(WhitelistedMA) != 0)
+      NewBlocks.push_back(I->getParent());
+  }
+
+  auto IsJumpTarget = [this](BasicBlock *BB) {
+    auto MA = getBasicBlockAddress(BB);
+    return MA.isValid() and isJumpTarget(MA);
+  };
+
+  // Proceed backward for at least Radius basic blocks and, after that, until
+  // we meet a jump target, so that the whole slice is reachable from the
+  // dispatcher. As in inflateAVIWhitelist, we stop at the dispatcher, since it
+  // is not a translated basic block, and at function calls, since
+  // harvestWithAVI redirected the call edges to anypc before getting here.
+  std::queue<std::pair<BasicBlock *, unsigned>> Backward;
+  for (BasicBlock *BB : NewBlocks)
+    if (Slice.insert(BB).second)
+      Backward.emplace(BB, 0);
+
+  while (not Backward.empty()) {
+    auto [BB, Distance] = Backward.front();
+    Backward.pop();
+
+    bool JumpTarget = IsJumpTarget(BB);
+    if (JumpTarget)
+      Result.insert(getBasicBlockAddress(BB));
+
+    if (JumpTarget and Distance >= Radius)
+      continue;
+
+    for (BasicBlock *Predecessor : predecessors(BB))
+      if (isTranslatedBB(Predecessor) and Slice.insert(Predecessor).second)
+        Backward.emplace(Predecessor, Distance + 1);
+  }
+
+  // Proceed forward for Radius basic blocks: the new basic blocks might have
+  // introduced new paths reaching indirect jumps that have already been
+  // analyzed. For the same reasons as above, we do not enter the callees.
+  std::set<BasicBlock *> Visited(NewBlocks.begin(), NewBlocks.end());
+  std::queue<std::pair<BasicBlock *, unsigned>> Forward;
+  for (BasicBlock *BB : Visited)
+    Forward.emplace(BB, 0);
+
+  while (not Forward.empty()) {
+    auto [BB, Distance] = Forward.front();
+    Forward.pop();
+
+    Slice.insert(BB);
+
+    if (Distance >= Radius)
+      continue;
+
+    for (BasicBlock *Successor : successors(BB))
+      if (isTranslatedBB(Successor) and Visited.insert(Successor).second)
+        Forward.emplace(Successor, Distance + 1);
+  }
+
+  return Result;
+}
+
 JumpTargetManager::MetaAddressSet JumpTargetManager::inflateAVIWhitelist() {
   MetaAddressSet Result;
 
@@ -1471,7 +1575,12 @@ void JumpTargetManager::harvestWithAVI() {
     }
 
     // Compute AVIJumpTargetWhitelist
-    auto AVIJumpTargetWhitelist = inflateAVIWhitelist();
+    std::set<BasicBlock *> Slice;
+    MetaAddressSet AVIJumpTargetWhitelist;
+    if (AVISliceRadius == 0)
+      AVIJumpTargetWhitelist = inflateAVIWhitelist();
+    else
+      AVIJumpTargetWhitelist = sliceAVIWhitelist(AVISliceRadius, Slice);
 
     // Prune the dispatcher
     setCFGForm(CFGForm::RecoveredOnly, &AVIJumpTargetWhitelist);
@@ -1484,6 +1593,30 @@ void JumpTargetManager::harvestWithAVI() {
     // Clone the function
     OptimizedFunction = CloneFunction(TheFunction, OldToNew);
 
+    // Restrict the clone to the slice: make the edges leaving it jump to anypc
+    // and drop what is no longer reachable
+    if (AVISliceRadius != 0) {
+      auto *NewAnyPC = cast<BasicBlock>(OldToNew[AnyPC]);
+      for (BasicBlock *BB : Slice) {
+        auto It = OldToNew.find(BB);
+        if (It == OldToNew.end())
+          continue;
+
+        Instruction *Terminator = BB->getTerminator();
+        auto *NewBB = cast<BasicBlock>(It->second);
+        Instruction *NewTerminator = NewBB->getTerminator();
+        for (unsigned I = 0; I < Terminator->getNumSuccessors(); ++I) {
+          BasicBlock *Successor = Terminator->getSuccessor(I);
+          if (isTranslatedBB(Successor) and Slice.count(Successor) == 0) {
+            NewTerminator->getSuccessor(I)->removePredecessor(NewBB);
+            NewTerminator->setSuccessor(I, NewAnyPC);
+          }
+        }
+      }
+
+      removeUnreachableBlocks(*OptimizedFunction);
+    }
+
     // Restore callees after function_call
     for (auto [U, BB] : Undo)
       U->set(BB);
@@ -1491,9 +1624,12 @@ void JumpTargetManager::harvestWithAVI() {
     Callees.erase(nullptr);
     llvm::IRBuilder<> Builder(Context);
     for (BasicBlock *BB : Callees) {
-      if (OldToNew.count(BB) == 0)
+      // Skip basic blocks that have not been cloned or that are not part of
+      // the slice
+      auto It = OldToNew.find(BB);
+      if (It == OldToNew.end() or It->second == nullptr)
         continue;
-      BB = cast<BasicBlock>(OldToNew[BB]);
+      BB = cast<BasicBlock>(It->second);
       revng_assert(BB->getTerminator() != nullptr);
       Builder.SetInsertPoint(BB->getFirstNonPHI());
 
@@ -1539,7 +1675,7 @@ void JumpTargetManager::harvestWithAVI() {
       BasicBlock *BB = Call->getParent();
       if (BB->getParent() == TheFunction) {
         auto It = OldToNew.find(Call);
-        if (It == OldToNew.end())
+        if (It == OldToNew.end() or It->second == nullptr)
           continue;
         Builder.SetInsertPoint(cast<CallInst>(&*It->second));
         Instruction *ComposedIntegerPC = PCH->composeIntegerPC(Builder);
@@ -1836,6 +1972,19 @@ void JumpTargetManager::harvestWithAVI() {
       // This is a call to `exit_tb`, transfer the revng.abi metadata on the
       // call as revng.targets for later processing
       revng_assert(TV.I != nullptr);
+
+      // When slicing, not all the paths reaching TV.I might have been
+      // analyzed: preserve the targets found in the previous rounds
+      auto *Old = dyn_cast_or_null<MDTuple>(TV.I->getMetadata("revng.targets"));
+      if (AVISliceRadius != 0 and Old != nullptr) {
+        SmallSetVector<Metadata *, 16> Operands;
+        for (const MDOperand &Operand : Old->operands())
+          Operands.insert(Operand.get());
+        for (const MDOperand &Operand : T->operands())
+          Operands.insert(Operand.get());
+        T = MDTuple::get(Context, Operands.getArrayRef());
+      }
+
       TV.I->setMetadata("revng.targets", T);
     }
 
@@ -1868,7 +2017,9 @@ void JumpTargetManager::harvest() {
   if (empty()) {
     HarvestingStats.push("harvest 1: SimpleLiterals");
     revng_log(JTCountLog, "Collecting simple literals");
-    for (MetaAddress PC : SimpleLiterals)
+    llvm::sort(SimpleLiterals);
+    auto End = std::unique(SimpleLiterals.begin(), SimpleLiterals.end());
+    for (MetaAddress PC : llvm::make_range(SimpleLiterals.begin(), End))
       registerJT(PC, JTReason::SimpleLiteral);
     SimpleLiterals.clear();
   }
@@ -13,9 +13,11 @@
 #include "boost/icl/interval_set.hpp"
 #include "boost/type_traits/is_same.hpp"
 
+#include "llvm/ADT/BitVector.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/PassManager.h"
 
+#include "revng/ADT/SortedVector.h"
 #include "revng/BasicAnalyses/MaterializedValue.h"
 #include "revng/Lift/Lift.h"
 #include "revng/Model/Architecture.h"
@@ -208,6 +210,7 @@ public:
 public:
   using BlockMap = std::map<MetaAddress, JumpTarget>;
   using RangesVector = std::vector<std::pair<MetaAddress, MetaAddress>>;
+  using CodePointersSet = SortedVector<MetaAddress>;
   using CSAAFactory = std::function<CPUStateAccessAnalysisPass *(void)>;
 
 public:
@@ -416,7 +419,14 @@ public:
 
     using namespace model::Architecture;
     unsigned ReadSize = getPointerSize(Model->Architecture());
+    reportMemoryUsage();
+
+    size_t Index = 0;
     for (MetaAddress MemoryAddress : UnusedCodePointers) {
+      // Ignore the code pointers that have been read
+      if (ReadCodePointers.test(Index++))
+        continue;
+
       // Read using the original endianess, we want the correct address
       auto MaybeRawPC = BinaryView.readInteger(MemoryAddress, ReadSize);
       MetaAddress PC = MetaAddress::invalid();
@@ -436,6 +446,7 @@ public:
 
     // We no longer need this information
     freeContainer(UnusedCodePointers);
+    freeContainer(ReadCodePointers);
   }
 
   MetaAddress fromPC(uint64_t PC) const {
@@ -506,7 +517,7 @@ public:
   /// Simple literals are registered as possible jump targets before attempting
   /// more expensive techniques.
   void registerSimpleLiteral(MetaAddress Address) {
-    SimpleLiterals.insert(Address);
+    SimpleLiterals.push_back(Address);
   }
 
   ProgramCounterHandler *programCounterHandler() { return PCH; }
@@ -548,7 +559,8 @@ private:
   template<typename value_type, unsigned endian>
   void findCodePointers(MetaAddress StartVirtualAddress,
                         const unsigned char *Start,
-                        const unsigned char *End);
+                        const unsigned char *End,
+                        CodePointersSet::BatchInsertOrAssigner &CodePointers);
 
   void harvestWithAVI();
 
@@ -556,8 +568,21 @@ private:
 
   MetaAddressSet inflateAVIWhitelist();
 
+  /// Like inflateAVIWhitelist, but also collect in \p Slice the basic blocks
+  /// within \p Radius basic blocks from the new ones, which are the only ones
+  /// harvestWithAVI needs to analyze
+  ///
+  /// \note the call edges must have been redirected to anypc, otherwise the
+  ///       slice would extend to the callers and callees of the new code.
+  MetaAddressSet sliceAVIWhitelist(unsigned Radius,
+                                   std::set<llvm::BasicBlock *> &Slice);
+
   llvm::CallInst *getJumpTarget(llvm::BasicBlock *Target);
 
+  /// Record, in the jump-target-manager-bytes statistic, an estimate of the
+  /// memory used by each data structure
+  void reportMemoryUsage() const;
+
 private:
   using InstructionMap = std::map<MetaAddress, llvm::Instruction *>;
 
@@ -583,12 +608,17 @@ private:
 
   unsigned NewBranches = 0;
 
-  std::set<MetaAddress> UnusedCodePointers;
+  /// Addresses of the pointers to code found in global data, sorted
+  CodePointersSet UnusedCodePointers;
+  /// Which elements of UnusedCodePointers have been read by the code
+  llvm::BitVector ReadCodePointers;
   interval_set ReadIntervalSet;
 
   CFGForm::Values CurrentCFGForm;
   std::set<llvm::BasicBlock *> ToPurge;
-  std::set<MetaAddress> SimpleLiterals;
+  /// Simple literals collected since the last harvesting, possibly
+  /// duplicated
+  std::vector<MetaAddress> SimpleLiterals;
   CSAAFactory CreateCSAA;
 
   ProgramCounterHandler *PCH;
@@ -17,6 +17,7 @@ extern "C" {
 #include "revng/Pipeline/AllRegistries.h"
 #include "revng/Pipes/FileContainer.h"
 #include "revng/Pipes/Kinds.h"
+#include "revng/Pipes/MappedBinaryCache.h"
 #include "revng/Pipes/ModelGlobal.h"
 #include "revng/Pipes/RootKind.h"
 #include "revng/Support/IRAnnotators.h"
@@ -34,9 +35,7 @@ void Lift::run(Context &Ctx,
 
   const TupleTree<model::Binary> &Model = getModelFromContext(Ctx);
 
-  auto BufferOrError = MemoryBuffer::getFileOrSTDIN(*SourceBinary.path());
-  auto Buffer = cantFail(errorOrToExpected(std::move(BufferOrError)));
-  RawBinaryView RawBinary(*Model, Buffer->getBuffer());
+  auto Buffer = cantFail(getBinaryFromContext(Ctx, *SourceBinary.path()));
 
   // Perform lifting
   llvm::legacy::PassManager PM;
@@ -49,6 +49,25 @@ TypePath Binary::recordNewType(UpcastablePointer<Type> &&T) {
   return getTypePath(It->get());
 }
 
+std::vector<std::pair<MetaAddress, MetaAddress>>
+Binary::executableRanges() const {
+  std::vector<std::pair<MetaAddress, MetaAddress>> Result;
+  for (const model::Segment &Segment : Segments()) {
+    if (not Segment.IsExecutable())
+      continue;
+
+    if (Segment.Sections().size() > 0) {
+      for (const model::Section &Section : Segment.Sections())
+        if (Section.ContainsCode())
+          Result.emplace_back(Section.StartAddress(), Section.endAddress());
+    } else {
+      Result.emplace_back(Segment.StartAddress(), Segment.endAddress());
+    }
+  }
+
+  return Result;
+}
+
 bool Binary::verifyTypes() const {
   return verifyTypes(false);
 }
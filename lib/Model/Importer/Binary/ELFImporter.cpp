@@ -177,7 +177,8 @@ Error ELFImporter<T, HasAddend>::import(const ImporterOptions &Options) {
     .BaseAddress = (Type != ELF::ET_DYN ? 0 : Options.BaseAddress),
     .DebugInfo = Options.DebugInfo,
     .EnableRemoteDebugInfo = Options.EnableRemoteDebugInfo,
-    .AdditionalDebugInfoPaths = Options.AdditionalDebugInfoPaths
+    .AdditionalDebugInfoPaths = Options.AdditionalDebugInfoPaths,
+    .DebugInfoThreads = Options.DebugInfoThreads
   };
 
   if (not(Type == ELF::ET_DYN or Type == ELF::ET_EXEC))
@@ -351,7 +352,7 @@ Error ELFImporter<T, HasAddend>::import(const ImporterOptions &Options) {
   if (AdjustedOptions.DebugInfo != DebugInfoLevel::No) {
     // Import Dwarf
     DwarfImporter Importer(Model);
-    Importer.import(TheBinary.getFileName(), AdjustedOptions);
+    Importer.import(TheBinary, AdjustedOptions);
 
     // Now we try to find missing types in the dependencies.
     findMissingTypes(TheELF, AdjustedOptions);
@@ -5,12 +5,15 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include "llvm/Object/ObjectFile.h"
+
 #include "revng/Model/Binary.h"
 #include "revng/Model/Importer/Binary/BinaryImporter.h"
 #include "revng/Model/Importer/Binary/ImportBinaryAnalysis.h"
 #include "revng/Model/Importer/Binary/Options.h"
 #include "revng/Model/Importer/DebugInfo/DwarfImporter.h"
 #include "revng/Pipeline/RegisterAnalysis.h"
+#include "revng/Pipes/MappedBinaryCache.h"
 #include "revng/Pipes/ModelGlobal.h"
 #include "revng/Support/ResourceFinder.h"
 #include "revng/TupleTree/TupleTree.h"
@@ -24,8 +27,18 @@ llvm::Error ImportBinaryAnalysis::run(pipeline::Context &Context,
 
   TupleTree<model::Binary> &Model = getWritableModelFromContext(Context);
 
+  auto MaybeBinary = getBinaryFromContext(Context, *SourceBinary.path());
+  if (not MaybeBinary)
+    return MaybeBinary.takeError();
+
+  using llvm::object::ObjectFile;
+  auto MaybeObject = ObjectFile::createObjectFile((*MaybeBinary)
+                                                    ->getMemBufferRef());
+  if (not MaybeObject)
+    return MaybeObject.takeError();
+
   const ImporterOptions &Options = importerOptions();
-  if (llvm::Error Error = importBinary(Model, *SourceBinary.path(), Options))
+  if (llvm::Error Error = importBinary(Model, **MaybeObject, Options))
     return Error;
 
   if (!Options.AdditionalDebugInfoPaths.empty()) {
@@ -58,9 +58,18 @@ cl::opt<bool> EnableRemoteDebugInfo("enable-remote-debug-info",
                                     cl::cat(MainCategory),
                                     cl::init(false));
 
+constexpr SR DescThreads = "Number of threads used to import debug "
+                           "information. The result does not depend on it.";
+cl::opt<unsigned> DebugInfoThreads("debug-info-threads",
+                                   cl::desc(DescThreads),
+                                   cl::value_desc("threads"),
+                                   cl::cat(MainCategory),
+                                   cl::init(1));
+
 const ImporterOptions importerOptions() {
   return ImporterOptions{ .BaseAddress = BaseAddress,
                           .DebugInfo = DebugInfo,
                           .EnableRemoteDebugInfo = EnableRemoteDebugInfo,
-                          .AdditionalDebugInfoPaths = ImportDebugInfo };
+                          .AdditionalDebugInfoPaths = ImportDebugInfo,
+                          .DebugInfoThreads = DebugInfoThreads };
 }
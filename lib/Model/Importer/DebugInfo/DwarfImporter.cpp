@@ -5,11 +5,15 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <atomic>
 #include <csignal>
 #include <optional>
+#include <random>
+#include <thread>
 
 #include "llvm/ADT/DepthFirstIterator.h"
 #include "llvm/ADT/EquivalenceClasses.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/BinaryFormat/Dwarf.h"
 #include "llvm/DebugInfo/DWARF/DWARFContext.h"
@@ -171,17 +175,35 @@ private:
   std::set<const model::Type *> InvalidPrimitives;
   std::set<const DWARFDie *> InProgressDies;
 
+  /// The compile units whose types are imported by this converter
+  SmallVector<DWARFUnit *, 0> Units;
+
+  /// The IDs of new types are drawn from here instead of the global
+  /// generator, so that converters running concurrently on different compile
+  /// units produce the same types regardless of how they are scheduled, see
+  /// getTypeIDSeed
+  std::mt19937_64 TypeIDs;
+
 public:
   DwarfToModelConverter(DwarfImporter &Importer,
                         DWARFContext &DICtx,
                         size_t Index,
                         size_t AltIndex,
-                        uint64_t PreferredBaseAddress) :
+                        uint64_t PreferredBaseAddress,
+                        ArrayRef<DWARFUnit *> Units = {},
+                        std::optional<uint64_t> TypeIDSeed = std::nullopt) :
     Importer(Importer),
     Model(Importer.getModel()),
     Index(Index),
     AltIndex(AltIndex),
-    DICtx(DICtx) {
+    DICtx(DICtx),
+    Units(Units.begin(), Units.end()) {
+
+    if (this->Units.empty())
+      for (const auto &CU : DICtx.compile_units())
+        this->Units.push_back(CU.get());
+
+    TypeIDs.seed(TypeIDSeed.has_value() ? *TypeIDSeed : getTypeIDSeed({}));
 
     Architecture = Model->Architecture();
     BaseAddress = PreferredBaseAddress;
@@ -297,9 +319,14 @@ private:
     }
   }
 
+  template<typename T>
+  model::UpcastableType newType() {
+    return model::makeTypeWithID(T::AssociatedKind, TypeIDs());
+  }
+
   template<typename T>
   [[maybe_unused]] T *createPlaceholderType(const DWARFDie &Die) {
-    auto NewType = model::makeType<T>();
+    auto NewType = newType<T>();
     T *Result = cast<T>(NewType.get());
     record(Die, Model->recordNewType(std::move(NewType)), false);
     return Result;
@@ -343,7 +370,7 @@ private:
 
     case llvm::dwarf::DW_TAG_subroutine_type:
       record(Die,
-             Model->recordNewType(model::makeType<model::CABIFunctionType>()),
+             Model->recordNewType(newType<model::CABIFunctionType>()),
              false);
       break;
     case llvm::dwarf::DW_TAG_typedef:
@@ -382,9 +409,9 @@ private:
   }
 
   void materializeTypesWithIdentity() {
-    for (const auto &CU : DICtx.compile_units()) {
+    for (DWARFUnit *CU : Units) {
       for (const auto &Entry : CU->dies()) {
-        DWARFDie Die = { CU.get(), &Entry };
+        DWARFDie Die = { CU, &Entry };
         auto Tag = Die.getTag();
         if (isType(Tag) and hasModelIdentity(Tag)) {
           auto MaybeDeclaration = Die.find(DW_AT_declaration);
@@ -795,9 +822,9 @@ private:
   }
 
   void resolveAllTypes() {
-    for (const auto &CU : DICtx.compile_units()) {
+    for (DWARFUnit *CU : Units) {
       for (const auto &Entry : CU->dies()) {
-        DWARFDie Die = { CU.get(), &Entry };
+        DWARFDie Die = { CU, &Entry };
         if (not isType(Die.getTag()))
           continue;
         resolveType(Die, true);
@@ -805,11 +832,184 @@ private:
     }
   }
 
+  /// Groups the compile units so that the types of a group never reference
+  /// DIEs of another group. Groups are sorted by their first compile unit.
+  SmallVector<SmallVector<DWARFUnit *, 0>, 0> partitionUnits() {
+    DenseMap<const DWARFUnit *, size_t> UnitIndices;
+    EquivalenceClasses<size_t> Groups;
+    for (size_t I = 0; I < Units.size(); ++I) {
+      UnitIndices[Units[I]] = I;
+      Groups.insert(I);
+    }
+
+    // Note: this also forces the parsing of all the DIEs. DWARFContext and
+    //       DWARFUnit parse lazily and are not thread-safe, after this loop
+    //       they are only read from.
+    for (size_t I = 0; I < Units.size(); ++I) {
+      DWARFUnit *CU = Units[I];
+      for (const auto &Entry : CU->dies()) {
+        DWARFDie Die = { CU, &Entry };
+        auto MaybeType = Die.find(DW_AT_type);
+        if (not MaybeType or MaybeType->getForm() == DW_FORM_GNU_ref_alt)
+          continue;
+
+        auto MaybeOffset = MaybeType->getAsReference();
+        if (not MaybeOffset
+            or (*MaybeOffset >= CU->getOffset()
+                and *MaybeOffset < CU->getNextUnitOffset()))
+          continue;
+
+        auto It = UnitIndices.find(DICtx.getCompileUnitForOffset(*MaybeOffset));
+        if (It != UnitIndices.end())
+          Groups.unionSets(I, It->second);
+      }
+    }
+
+    SmallVector<SmallVector<DWARFUnit *, 0>, 0> Result;
+    DenseMap<size_t, size_t> LeaderToGroup;
+    for (size_t I = 0; I < Units.size(); ++I) {
+      size_t Leader = Groups.getLeaderValue(I);
+      auto [It, New] = LeaderToGroup.try_emplace(Leader, Result.size());
+      if (New)
+        Result.emplace_back();
+      Result[It->second].push_back(Units[I]);
+    }
+
+    return Result;
+  }
+
+  /// The types of a group of compile units, imported in a separate model
+  struct PartialTypeSystem {
+    SmallVector<DWARFUnit *, 0> Units;
+    uint64_t TypeIDSeed = 0;
+    TupleTree<model::Binary> Model;
+    std::unique_ptr<DwarfImporter> Importer;
+    std::map<size_t, const model::Type *> Placeholders;
+    size_t TypesWithIdentityCount = 0;
+  };
+
+  void importPartialTypeSystem(PartialTypeSystem &Partial) {
+    Partial.Model->Architecture() = Model->Architecture();
+    Partial.Model->DefaultABI() = Model->DefaultABI();
+    Partial.Importer = std::make_unique<DwarfImporter>(Partial.Model);
+
+    DwarfToModelConverter Converter(*Partial.Importer,
+                                    DICtx,
+                                    Index,
+                                    AltIndex,
+                                    BaseAddress,
+                                    Partial.Units,
+                                    Partial.TypeIDSeed);
+    Converter.materializeTypesWithIdentity();
+    Converter.resolveAllTypes();
+
+    Partial.Placeholders = std::move(Converter.Placeholders);
+    Partial.TypesWithIdentityCount = Converter.TypesWithIdentityCount;
+  }
+
+  /// \return the seed of the type IDs of the partial type system importing
+  ///         \p Group or, if \p Group is empty, of the types created directly
+  ///         in the model
+  ///
+  /// The seed only depends on -model-type-id-seed, on the DWARF and on the
+  /// types already in the model, so that importing twice in the same model
+  /// draws different IDs.
+  uint64_t getTypeIDSeed(ArrayRef<DWARFUnit *> Group) const {
+    uint64_t Seed = llvm::hash_combine(model::getTypeIDSeed().value_or(0),
+                                       Model->Types().size(),
+                                       Index);
+    if (Group.empty())
+      return Seed;
+
+    DWARFUnit *First = Group.front();
+    return llvm::hash_combine(Seed,
+                              First->getOffset(),
+                              First->getLength(),
+                              getName(First->getUnitDIE()));
+  }
+
+  /// Imports the types of independent groups of compile units concurrently,
+  /// each in a partial type system, then moves them into the model.
+  ///
+  /// The groups, the seeds of their type IDs and the merge order only depend on
+  /// the DWARF, therefore the result is the same for any number of \p Threads,
+  /// including one.
+  void importTypes(unsigned Threads) {
+    // Types from the alternative debug info file live in the model and cannot
+    // be referenced from a partial type system, import them directly in the
+    // model, no matter the number of threads
+    if (AltIndex != static_cast<size_t>(-1)) {
+      materializeTypesWithIdentity();
+      resolveAllTypes();
+      return;
+    }
+
+    auto Groups = partitionUnits();
+    std::vector<PartialTypeSystem> Partials(Groups.size());
+    for (size_t I = 0; I < Groups.size(); ++I) {
+      Partials[I].TypeIDSeed = getTypeIDSeed(Groups[I]);
+      Partials[I].Units = std::move(Groups[I]);
+    }
+
+    revng_log(DILogger,
+              "Importing " << Units.size() << " compile units in "
+                           << Partials.size() << " independent groups");
+
+    // Keep the log readable
+    if (DILogger.isEnabled())
+      Threads = 1;
+
+    std::atomic<size_t> NextPartial = 0;
+    auto Worker = [this, &Partials, &NextPartial]() {
+      for (size_t I = NextPartial++; I < Partials.size(); I = NextPartial++)
+        importPartialTypeSystem(Partials[I]);
+    };
+
+    std::vector<std::thread> Workers;
+    Threads = std::min<size_t>(Threads, Partials.size());
+    for (unsigned I = 1; I < Threads; ++I)
+      Workers.emplace_back(Worker);
+    Worker();
+    for (std::thread &Thread : Workers)
+      Thread.join();
+
+    // Merge the partial type systems in order. Type IDs are unique across
+    // them, only primitive types might be duplicated.
+    std::vector<model::UpcastableType> NewTypes;
+    std::set<model::Type::Key> NewPrimitiveTypes;
+    TypesWithIdentityCount = 0;
+    for (PartialTypeSystem &Partial : Partials) {
+      for (model::UpcastableType &Type : Partial.Model->Types()) {
+        if (isa<model::PrimitiveType>(Type.get())) {
+          model::Type::Key Key = Type->key();
+          if (Model->Types().count(Key) != 0
+              or not NewPrimitiveTypes.insert(Key).second)
+            continue;
+        } else {
+          revng_assert(Model->Types().count(Type->key()) == 0);
+        }
+
+        NewTypes.push_back(std::move(Type));
+      }
+
+      // Moving an UpcastablePointer preserves the pointee, the placeholders
+      // are still valid
+      Placeholders.merge(Partial.Placeholders);
+      TypesWithIdentityCount += Partial.TypesWithIdentityCount;
+    }
+    Model->recordNewTypes(std::move(NewTypes));
+
+    // References in the moved types still point to the partial models
+    Model.initializeReferences();
+    for (PartialTypeSystem &Partial : Partials)
+      Importer.importRecordedTypes(*Partial.Importer);
+  }
+
   std::optional<model::TypePath> getSubprogramPrototype(const DWARFDie &Die) {
     using namespace model;
 
     // Create function type
-    UpcastableType NewType = makeType<CABIFunctionType>();
+    UpcastableType NewType = newType<CABIFunctionType>();
     auto *FunctionType = cast<model::CABIFunctionType>(NewType.get());
 
     // Detect ABI
@@ -969,9 +1169,8 @@ private:
   }
 
 public:
-  void run() {
-    materializeTypesWithIdentity();
-    resolveAllTypes();
+  void run(unsigned Threads) {
+    importTypes(Threads);
     createFunctions();
     cleanupTypeSystem();
     fixModel(Model);
@@ -1087,7 +1286,7 @@ static void error(StringRef Prefix, std::error_code EC) {
 static std::optional<std::string>
 findDebugInfoFileByName(StringRef FileName,
                         StringRef DebugFileName,
-                        llvm::object::ObjectFile *ELF) {
+                        const llvm::object::ObjectFile *ELF) {
   // Let's find it in canonical places, where debug info was fetched.
   //  1) Look for a .gnu_debuglink/.gnu_debugaltlink/.debug_sup section.
   //  The .debug file should be in canonical places.
@@ -1207,12 +1406,27 @@ void DwarfImporter::import(StringRef FileName, const ImporterOptions &Options) {
   Expected<std::unique_ptr<Binary>> BinOrErr = object::createBinary(*Buffer);
   error(FileName, errorToErrorCode(BinOrErr.takeError()));
 
+  if (auto *Object = dyn_cast<ObjectFile>(BinOrErr->get())) {
+    import(*Object, Options);
+  } else {
+    import(*BinOrErr->get(),
+           FileName,
+           Options.BaseAddress,
+           Options.DebugInfoThreads);
+  }
+}
+
+void DwarfImporter::import(const llvm::object::ObjectFile &TheBinary,
+                           const ImporterOptions &Options) {
+  using namespace llvm::object;
+  StringRef FileName = TheBinary.getFileName();
+
   // Find Debugging Information.
   // If the file has debug info sections within itself, no need for finding
   // it on the device.
   // TODO: When we add support for Split DWARF, this will need additional
   // improvement.
-  auto HasDebugInfo = [](ObjectFile *Object) {
+  auto HasDebugInfo = [](const ObjectFile *Object) {
     for (const SectionRef &Section : Object->sections()) {
       StringRef SectionName;
       if (Expected<StringRef> NameOrErr = Section.getName()) {
@@ -1237,45 +1451,47 @@ void DwarfImporter::import(StringRef FileName, const ImporterOptions &Options) {
       revng_log(DILogger, "Can't create binary for " << FilePath);
       llvm::consumeError(ExpectedBinary.takeError());
     } else {
-      import(*ExpectedBinary->getBinary(), TheDebugFile, Options.BaseAddress);
+      import(*ExpectedBinary->getBinary(),
+             TheDebugFile,
+             Options.BaseAddress,
+             Options.DebugInfoThreads);
     }
   };
 
-  if (auto *ELF = dyn_cast<ObjectFile>(BinOrErr->get())) {
-    if (Options.DebugInfo != DebugInfoLevel::No && !HasDebugInfo(ELF)) {
-      // There are no .debug_* sections in the file itself, let's try to find it
-      // on the device, otherwise find it on web by using the `fetch-debuginfo`
-      // tool.
-      auto DebugFile = getDebugFileName(BinOrErr->get());
-      if (!DebugFile.size()) {
-        revng_log(DILogger, "Can't find file name of the debug file.");
+  const ObjectFile *ELF = &TheBinary;
+  if (Options.DebugInfo != DebugInfoLevel::No && !HasDebugInfo(ELF)) {
+    // There are no .debug_* sections in the file itself, let's try to find it
+    // on the device, otherwise find it on web by using the `fetch-debuginfo`
+    // tool.
+    auto DebugFile = getDebugFileName(ELF);
+    if (!DebugFile.size()) {
+      revng_log(DILogger, "Can't find file name of the debug file.");
+      return;
+    }
+    auto DebugFilePath = findDebugInfoFileByName(FileName, DebugFile, ELF);
+    if (!DebugFilePath) {
+      if (!::Runner.isProgramAvailable("revng")) {
+        revng_log(DILogger,
+                  "Can't find `revng` binary to run `fetch-debuginfo`.");
         return;
       }
-      auto DebugFilePath = findDebugInfoFileByName(FileName, DebugFile, ELF);
-      if (!DebugFilePath) {
-        if (!::Runner.isProgramAvailable("revng")) {
-          revng_log(DILogger,
-                    "Can't find `revng` binary to run `fetch-debuginfo`.");
-          return;
-        }
 
-        int ExitCode = runFetchDebugInfoWithLevel(FileName);
-        if (ExitCode != 0) {
-          revng_log(DILogger,
-                    "Failed to find debug info with `revng model "
-                    "fetch-debuginfo`.");
-        } else {
-          DebugFilePath = findDebugInfoFileByName(FileName, DebugFile, ELF);
-          if (DebugFilePath)
-            PerformImport(*DebugFilePath, DebugFile);
-        }
+      int ExitCode = runFetchDebugInfoWithLevel(FileName);
+      if (ExitCode != 0) {
+        revng_log(DILogger,
+                  "Failed to find debug info with `revng model "
+                  "fetch-debuginfo`.");
       } else {
-        PerformImport(*DebugFilePath, DebugFile);
+        DebugFilePath = findDebugInfoFileByName(FileName, DebugFile, ELF);
+        if (DebugFilePath)
+          PerformImport(*DebugFilePath, DebugFile);
       }
+    } else {
+      PerformImport(*DebugFilePath, DebugFile);
     }
   }
 
-  import(*BinOrErr->get(), FileName, Options.BaseAddress);
+  import(TheBinary, FileName, Options.BaseAddress, Options.DebugInfoThreads);
 }
 
 auto zipPairs(auto &&R) {
@@ -1437,7 +1653,8 @@ inline void detectAliases(const llvm::object::ObjectFile &ELF,
 
 void DwarfImporter::import(const llvm::object::Binary &TheBinary,
                            StringRef FileName,
-                           std::uint64_t PreferredBaseAddress) {
+                           std::uint64_t PreferredBaseAddress,
+                           unsigned Threads) {
   using namespace llvm::object;
 
   if (auto *ELF = dyn_cast<ObjectFile>(&TheBinary)) {
@@ -1465,7 +1682,7 @@ void DwarfImporter::import(const llvm::object::Binary &TheBinary,
                                     LoadedFiles.size(),
                                     AltIndex,
                                     PreferredBaseAddress);
-    Converter.run();
+    Converter.run(Threads);
 
     detectAliases(*ELF, Model);
   }
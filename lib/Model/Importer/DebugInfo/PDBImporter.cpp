@@ -5,6 +5,10 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <atomic>
+#include <thread>
+#include <variant>
+
 #include "llvm/DebugInfo/CodeView/CVSymbolVisitor.h"
 #include "llvm/DebugInfo/CodeView/CVTypeVisitor.h"
 #include "llvm/DebugInfo/CodeView/LazyRandomTypeCollection.h"
@@ -22,6 +26,8 @@
 #include "llvm/DebugInfo/PDB/Native/PDBFile.h"
 #include "llvm/DebugInfo/PDB/Native/SymbolStream.h"
 #include "llvm/DebugInfo/PDB/PDB.h"
+#include "llvm/Support/BinaryByteStream.h"
+#include "llvm/Support/BinaryStreamReader.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Process.h"
 #include "llvm/Support/Program.h"
@@ -52,14 +58,147 @@ static llvm::cl::opt<std::string> UsePDB("use-pdb",
                                          llvm::cl::desc("Path to the PDB."),
                                          llvm::cl::cat(MainCategory));
 
+/// Invokes \p Callable on each index in [0, \p Count) from \p Threads threads,
+/// handing out indices in batches of \p BatchSize
+template<typename CallableType>
+static void parallelForEach(size_t Count,
+                            unsigned Threads,
+                            size_t BatchSize,
+                            CallableType &&Callable) {
+  std::atomic<size_t> NextBatch = 0;
+  auto Worker = [&]() {
+    for (size_t Start = NextBatch.fetch_add(BatchSize); Start < Count;
+         Start = NextBatch.fetch_add(BatchSize)) {
+      size_t End = std::min(Start + BatchSize, Count);
+      for (size_t I = Start; I < End; ++I)
+        Callable(I);
+    }
+  };
+
+  size_t Batches = (Count + BatchSize - 1) / BatchSize;
+  Threads = std::min<size_t>(Threads, Batches);
+  std::vector<std::thread> Workers;
+  for (unsigned I = 1; I < Threads; ++I)
+    Workers.emplace_back(Worker);
+  Worker();
+  for (std::thread &Thread : Workers)
+    Thread.join();
+}
+
 namespace {
+
+using DecodedMember = std::variant<DataMemberRecord,
+                                   EnumeratorRecord,
+                                   OneMethodRecord>;
+
+/// A type record of the TPI stream deserialized ahead of time. Deserialization
+/// is independent for each record and it is performed concurrently, the
+/// records are then committed to the model in order.
+struct DecodedTypeRecord {
+  CVType Type;
+  TypeIndex Index;
+  std::variant<std::monostate,
+               ClassRecord,
+               EnumRecord,
+               ProcedureRecord,
+               UnionRecord,
+               ArgListRecord,
+               PointerRecord,
+               ModifierRecord,
+               ArrayRecord,
+               MemberFunctionRecord,
+               std::vector<DecodedMember>>
+    Decoded;
+  std::optional<std::string> Error;
+};
+
+/// Deserializes the records that are relevant for PDBImporterTypeVisitor
+class PDBTypeRecordDecoder : public TypeVisitorCallbacks {
+private:
+  DecodedTypeRecord &Current;
+
+public:
+  PDBTypeRecordDecoder(DecodedTypeRecord &Current) : Current(Current) {}
+
+  static void decode(DecodedTypeRecord &Record) {
+    PDBTypeRecordDecoder Decoder(Record);
+    if (auto Err = visitTypeRecord(Record.Type, Record.Index, Decoder))
+      Record.Error = toString(std::move(Err));
+  }
+
+private:
+  template<typename T>
+  Error record(T &Record) {
+    Current.Decoded = Record;
+    return Error::success();
+  }
+
+  template<typename T>
+  Error recordMember(T &Member) {
+    std::get<std::vector<DecodedMember>>(Current.Decoded).push_back(Member);
+    return Error::success();
+  }
+
+public:
+  Error visitKnownRecord(CVType &, ClassRecord &R) override {
+    return record(R);
+  }
+  Error visitKnownRecord(CVType &, EnumRecord &R) override { return record(R); }
+  Error visitKnownRecord(CVType &, ProcedureRecord &R) override {
+    return record(R);
+  }
+  Error visitKnownRecord(CVType &, UnionRecord &R) override {
+    return record(R);
+  }
+  Error visitKnownRecord(CVType &, ArgListRecord &R) override {
+    return record(R);
+  }
+  Error visitKnownRecord(CVType &, PointerRecord &R) override {
+    return record(R);
+  }
+  Error visitKnownRecord(CVType &, ModifierRecord &R) override {
+    return record(R);
+  }
+  Error visitKnownRecord(CVType &, ArrayRecord &R) override {
+    return record(R);
+  }
+  Error visitKnownRecord(CVType &, MemberFunctionRecord &R) override {
+    return record(R);
+  }
+
+  Error visitKnownRecord(CVType &, FieldListRecord &FieldList) override {
+    Current.Decoded = std::vector<DecodedMember>();
+    return visitMemberRecordStream(FieldList.Data, *this);
+  }
+
+  Error visitKnownMember(CVMemberRecord &, DataMemberRecord &M) override {
+    return recordMember(M);
+  }
+  Error visitKnownMember(CVMemberRecord &, EnumeratorRecord &M) override {
+    return recordMember(M);
+  }
+  Error visitKnownMember(CVMemberRecord &, OneMethodRecord &M) override {
+    return recordMember(M);
+  }
+};
+
+/// The procedures of a module symbol stream. The stream is copied out of the
+/// PDB, since reading from the MSF streams is not thread-safe.
+struct ModuleProcedures {
+  std::vector<uint8_t> Data;
+  std::vector<std::pair<CVSymbol, ProcSym>> Procedures;
+  std::optional<std::string> Error;
+};
+
 class PDBImporterImpl {
 private:
   PDBImporter &Importer;
   DenseMap<TypeIndex, model::TypePath> ProcessedTypes;
+  unsigned Threads;
 
 public:
-  PDBImporterImpl(PDBImporter &Importer) : Importer(Importer) {}
+  PDBImporterImpl(PDBImporter &Importer, unsigned Threads) :
+    Importer(Importer), Threads(Threads) {}
   void run(NativeSession &Session);
 
 private:
@@ -106,6 +245,9 @@ public:
   Error visitTypeBegin(CVType &Record) override;
   Error visitTypeBegin(CVType &Record, TypeIndex TI) override;
 
+  /// Replays the callbacks of a record decoded by PDBTypeRecordDecoder
+  Error visitDecodedRecord(DecodedTypeRecord &Record);
+
   Error visitKnownRecord(CVType &Record, ClassRecord &Class) override;
   Error
   visitKnownMember(CVMemberRecord &Record, EnumeratorRecord &Member) override;
@@ -173,52 +315,96 @@ void PDBImporterImpl::populateTypes() {
     return;
   }
 
+  // Collect the records sequentially, LazyRandomTypeCollection is not
+  // thread-safe
+  LazyRandomTypeCollection &Types = InputFile->types();
+  std::vector<DecodedTypeRecord> Records;
+  for (auto Index = Types.getFirst(); Index; Index = Types.getNext(*Index))
+    Records.push_back({ Types.getType(*Index), *Index, {}, std::nullopt });
+
+  constexpr size_t BatchSize = 4096;
+  parallelForEach(Records.size(), Threads, BatchSize, [&Records](size_t I) {
+    PDBTypeRecordDecoder::decode(Records[I]);
+  });
+
   PDBImporterTypeVisitor TypeVisitor(Importer.getModel(),
                                      InputFile->types(),
                                      ProcessedTypes);
-  if (auto Err = visitTypeStream(InputFile->types(), TypeVisitor)) {
-    revng_log(DILogger, "Error during visiting types: " << Err);
-    consumeError(std::move(Err));
+  for (DecodedTypeRecord &Record : Records) {
+    if (Record.Error.has_value()) {
+      revng_log(DILogger, "Error during visiting types: " << *Record.Error);
+      return;
+    }
+
+    if (auto Err = TypeVisitor.visitDecodedRecord(Record)) {
+      revng_log(DILogger, "Error during visiting types: " << Err);
+      consumeError(std::move(Err));
+      return;
+    }
+  }
+}
+
+static bool isProcedure(SymbolKind Kind) {
+  switch (Kind) {
+  case SymbolKind::S_GPROC32:
+  case SymbolKind::S_LPROC32:
+  case SymbolKind::S_GPROC32_ID:
+  case SymbolKind::S_LPROC32_ID:
+  case SymbolKind::S_LPROC32_DPC:
+  case SymbolKind::S_LPROC32_DPC_ID:
+    return true;
+  default:
+    return false;
+  }
+}
+
+static void decodeProcedures(ModuleProcedures &Module) {
+  BinaryByteStream Stream(Module.Data, llvm::support::little);
+  BinaryStreamReader Reader(Stream);
+  CVSymbolArray Symbols;
+  if (auto Err = Reader.readArray(Symbols, Reader.bytesRemaining())) {
+    Module.Error = toString(std::move(Err));
+    return;
+  }
+
+  for (const CVSymbol &Symbol : Symbols) {
+    if (not isProcedure(Symbol.kind()))
+      continue;
+
+    auto MaybeProc = SymbolDeserializer::deserializeAs<ProcSym>(Symbol);
+    if (not MaybeProc) {
+      Module.Error = toString(MaybeProc.takeError());
+      return;
+    }
+
+    Module.Procedures.emplace_back(Symbol, std::move(*MaybeProc));
   }
 }
 
+/// Copies the symbol stream of each module
 class PDBSymbolHandler {
 private:
   PDBImporter &Importer;
-  DenseMap<TypeIndex, model::TypePath> &ProcessedTypes;
-  NativeSession &Session;
   InputFile &Input;
+  std::vector<ModuleProcedures> &Modules;
 
 public:
   PDBSymbolHandler(PDBImporter &Importer,
-                   DenseMap<TypeIndex, model::TypePath> &ProcessedTypes,
-                   NativeSession &Session,
-                   InputFile &Input) :
-    Importer(Importer),
-    ProcessedTypes(ProcessedTypes),
-    Session(Session),
-    Input(Input) {}
+                   InputFile &Input,
+                   std::vector<ModuleProcedures> &Modules) :
+    Importer(Importer), Input(Input), Modules(Modules) {}
 
   Error operator()(uint32_t Modi, const SymbolGroup &SG) {
     auto ExpectedModS = getModuleDebugStream(*Importer.getPDBFile(), Modi);
     if (ExpectedModS) {
       ModuleDebugStreamRef &ModS = *ExpectedModS;
-
-      SymbolVisitorCallbackPipeline Pipeline;
-      SymbolDeserializer Deserializer(nullptr, CodeViewContainer::Pdb);
-      PDBImporterSymbolVisitor SymVisitor(Importer.getModel(),
-                                          ProcessedTypes,
-                                          Session,
-                                          Importer.getBaseAddress());
-
-      Pipeline.addCallbackToPipeline(Deserializer);
-      Pipeline.addCallbackToPipeline(SymVisitor);
-      CVSymbolVisitor Visitor(Pipeline);
-      auto SS = ModS.getSymbolsSubstream();
-      if (auto Err = Visitor.visitSymbolStream(ModS.getSymbolArray(),
-                                               SS.Offset))
+      BinaryStreamReader Reader(ModS.getSymbolArray().getUnderlyingStream());
+      ArrayRef<uint8_t> Data;
+      if (auto Err = Reader.readBytes(Data, Reader.bytesRemaining()))
         return createStringError(errorToErrorCode(std::move(Err)),
                                  Input.getFilePath());
+
+      Modules.push_back({ { Data.begin(), Data.end() }, {}, std::nullopt });
     } else {
       // If the module stream does not exist, it is not an
       // error condition.
@@ -240,12 +426,33 @@ void PDBImporterImpl::populateSymbolsWithTypes(NativeSession &Session) {
   FilterOptions Filters;
   LinePrinter Printer(/*Indent=*/2, false, nulls(), Filters);
   const PrintScope HeaderScope(Printer, /*IndentLevel=*/2);
-  PDBSymbolHandler SymbolHandler(Importer, ProcessedTypes, Session, *InputFile);
+  std::vector<ModuleProcedures> Modules;
+  PDBSymbolHandler SymbolHandler(Importer, *InputFile, Modules);
   if (auto Err = iterateSymbolGroups(*InputFile, HeaderScope, SymbolHandler)) {
     revng_log(DILogger, "Unable to parse symbols: " << Err);
     consumeError(std::move(Err));
     return;
   }
+
+  constexpr size_t BatchSize = 1;
+  parallelForEach(Modules.size(), Threads, BatchSize, [&Modules](size_t I) {
+    decodeProcedures(Modules[I]);
+  });
+
+  // Commit the procedures in order, since the first one wins
+  PDBImporterSymbolVisitor SymVisitor(Importer.getModel(),
+                                      ProcessedTypes,
+                                      Session,
+                                      Importer.getBaseAddress());
+  for (ModuleProcedures &Module : Modules) {
+    for (auto &[Record, Proc] : Module.Procedures)
+      cantFail(SymVisitor.visitKnownRecord(Record, Proc));
+
+    if (Module.Error.has_value()) {
+      revng_log(DILogger, "Unable to parse symbols: " << *Module.Error);
+      return;
+    }
+  }
 }
 
 void PDBImporterImpl::run(NativeSession &Session) {
@@ -473,12 +680,38 @@ void PDBImporter::import(const COFFObjectFile &TheBinary,
     }
   }
 
-  PDBImporterImpl ModelCreator(*this);
+  PDBImporterImpl ModelCreator(*this, Options.DebugInfoThreads);
   ModelCreator.run(*TheNativeSession);
 }
 
 // ==== Implementation of the Model type recordings. ==== //
 
+Error PDBImporterTypeVisitor::visitDecodedRecord(DecodedTypeRecord &Record) {
+  if (auto Err = visitTypeBegin(Record.Type, Record.Index))
+    return Err;
+
+  auto Visit = [this, &Record](auto &Decoded) -> Error {
+    using T = std::decay_t<decltype(Decoded)>;
+    if constexpr (std::is_same_v<T, std::monostate>) {
+      return Error::success();
+    } else if constexpr (std::is_same_v<T, std::vector<DecodedMember>>) {
+      for (DecodedMember &Member : Decoded) {
+        CVMemberRecord MemberRecord;
+        auto VisitMember = [this, &MemberRecord](auto &M) {
+          return this->visitKnownMember(MemberRecord, M);
+        };
+        if (auto Err = std::visit(VisitMember, Member))
+          return Err;
+      }
+      return Error::success();
+    } else {
+      return this->visitKnownRecord(Record.Type, Decoded);
+    }
+  };
+
+  return std::visit(Visit, Record.Decoded);
+}
+
 Error PDBImporterTypeVisitor::visitTypeBegin(CVType &Record) {
   return visitTypeBegin(Record, TypeIndex::fromArrayIndex(Types.size()));
 }
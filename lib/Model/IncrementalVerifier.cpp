@@ -0,0 +1,328 @@
+/// \file IncrementalVerifier.cpp
+/// \brief Verification of model::Binary that can be repeated after a diff
+///        without re-verifying the whole model
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include "revng/Model/IncrementalVerifier.h"
+
+using namespace llvm;
+
+namespace model {
+
+using FieldsEnum = TupleLikeTraits<model::Binary>::Fields;
+
+template<typename T>
+static auto keyOf(const T &Object) {
+  return KeyedObjectTraits<T>::key(Object);
+}
+
+static void addUse(std::vector<model::Type::Key> &Uses,
+                   const model::TypePath &Path) {
+  if (const model::Type *T = Path.getConst())
+    Uses.push_back(T->key());
+}
+
+template<typename T>
+static void addCustomName(std::vector<Identifier> &Names, const T &Object) {
+  if (not Object.CustomName().empty())
+    Names.push_back(Object.CustomName());
+}
+
+static void describe(const model::Function &F, auto &Info) {
+  addCustomName(Info.CustomNames, F);
+  addUse(Info.Uses, F.Prototype());
+  for (const model::CallSitePrototype &CSP : F.CallSitePrototypes())
+    addUse(Info.Uses, CSP.Prototype());
+}
+
+static void describe(const model::DynamicFunction &DF, auto &Info) {
+  addCustomName(Info.CustomNames, DF);
+  addUse(Info.Uses, DF.Prototype());
+}
+
+static void describe(const model::Segment &S, auto &Info) {
+  addCustomName(Info.CustomNames, S);
+}
+
+static void describe(const model::UpcastableType &Type, auto &Info) {
+  addCustomName(Info.CustomNames, *Type);
+  if (auto *Enum = dyn_cast<EnumType>(Type.get()))
+    for (const model::EnumEntry &Entry : Enum->Entries())
+      addCustomName(Info.CustomNames, Entry);
+
+  Info.TypeName = Type->name();
+
+  for (const model::QualifiedType &Edge : Type->edges())
+    addUse(Info.Uses, Edge.UnqualifiedType());
+}
+
+/// Returns the key of the element of a keyed collection affected by \p Change:
+/// either the second element of the path or, for additions and removals, the
+/// key of the element itself
+template<typename KeyType, typename ElementType>
+static std::optional<KeyType>
+affectedKey(const TupleTreeDiff<model::Binary>::Change &Change) {
+  const TupleTreePath &Path = Change.Path;
+  if (Path.size() > 1) {
+    if (auto *Key = Path[1].tryGet<KeyType>())
+      return *Key;
+    return std::nullopt;
+  }
+
+  const auto &Element = Change.New.has_value() ? Change.New : Change.Old;
+  if (not Element.has_value())
+    return std::nullopt;
+
+  if (auto *Value = std::get_if<ElementType>(&*Element))
+    return keyOf(*Value);
+
+  return std::nullopt;
+}
+
+void IncrementalVerifier::reset() {
+  Valid = false;
+  Entities.clear();
+  CustomNames.clear();
+  TypeNames.clear();
+  Users.clear();
+}
+
+bool IncrementalVerifier::verify(const model::Binary &Model,
+                                 VerifyHelper &VH) {
+  reset();
+
+  if (not Model.verify(VH))
+    return false;
+
+  // The model is valid, there's no need to check the names while recording
+  // them
+  auto Record = [this, &VH](const Entity &E, const auto &Object) {
+    EntityInfo Info;
+    describe(Object, Info);
+    bool Success = record(E, std::move(Info), VH);
+    revng_assert(Success);
+  };
+
+  for (const model::Function &F : Model.Functions())
+    Record(keyOf(F), F);
+
+  for (const model::DynamicFunction &DF : Model.ImportedDynamicFunctions())
+    Record(keyOf(DF), DF);
+
+  for (const model::Segment &S : Model.Segments())
+    Record(keyOf(S), S);
+
+  for (const model::UpcastableType &Type : Model.Types())
+    Record(keyOf(Type), Type);
+
+  Valid = true;
+  return true;
+}
+
+/// Collects the entities affected by \p Diff. Returns false if it's not
+/// possible to verify the diff incrementally.
+bool IncrementalVerifier::collectTouched(const TupleTreeDiff<Binary> &Diff,
+                                         std::set<Entity> &Touched) const {
+  for (const auto &Change : Diff.Changes) {
+    const TupleTreePath &Path = Change.Path;
+    if (Path.size() == 0)
+      return false;
+
+    auto *Field = Path[0].tryGet<size_t>();
+    if (Field == nullptr)
+      return false;
+
+    std::optional<Entity> Key;
+    switch (static_cast<FieldsEnum>(*Field)) {
+    case FieldsEnum::Functions:
+      Key = affectedKey<FunctionKey, model::Function>(Change);
+      break;
+
+    case FieldsEnum::ImportedDynamicFunctions:
+      Key = affectedKey<DynamicFunctionKey, model::DynamicFunction>(Change);
+      break;
+
+    case FieldsEnum::Segments:
+      Key = affectedKey<SegmentKey, model::Segment>(Change);
+      break;
+
+    case FieldsEnum::Types:
+      Key = affectedKey<TypeKey, model::UpcastableType>(Change);
+      break;
+
+    case FieldsEnum::EntryPoint:
+    case FieldsEnum::ImportedLibraries:
+    case FieldsEnum::ExtraCodeAddresses:
+      // Not subject to verification
+      continue;
+
+    default:
+      // Architecture, DefaultABI and DefaultPrototype affect the whole model
+      return false;
+    }
+
+    if (not Key.has_value())
+      return false;
+
+    Touched.insert(*Key);
+  }
+
+  // Changing a type might invalidate all of the entities referencing it
+  std::vector<Entity> Worklist(Touched.begin(), Touched.end());
+  while (not Worklist.empty()) {
+    Entity Current = Worklist.back();
+    Worklist.pop_back();
+
+    auto *Type = std::get_if<TypeKey>(&Current);
+    if (Type == nullptr)
+      continue;
+
+    auto It = Users.find(*Type);
+    if (It == Users.end())
+      continue;
+
+    for (const Entity &User : It->second)
+      if (Touched.insert(User).second)
+        Worklist.push_back(User);
+  }
+
+  return true;
+}
+
+void IncrementalVerifier::forget(const Entity &E) {
+  auto It = Entities.find(E);
+  if (It == Entities.end())
+    return;
+
+  auto Decrement = [](std::map<Identifier, unsigned> &Counts,
+                      const Identifier &Name) {
+    auto CountIt = Counts.find(Name);
+    revng_assert(CountIt != Counts.end());
+    if (--CountIt->second == 0)
+      Counts.erase(CountIt);
+  };
+
+  const EntityInfo &Info = It->second;
+  for (const Identifier &Name : Info.CustomNames)
+    Decrement(CustomNames, Name);
+
+  if (Info.TypeName.has_value())
+    Decrement(TypeNames, *Info.TypeName);
+
+  for (const TypeKey &Used : Info.Uses) {
+    auto UsersIt = Users.find(Used);
+    revng_assert(UsersIt != Users.end());
+    UsersIt->second.erase(E);
+    if (UsersIt->second.empty())
+      Users.erase(UsersIt);
+  }
+
+  Entities.erase(It);
+}
+
+bool IncrementalVerifier::record(const Entity &E,
+                                 EntityInfo &&Info,
+                                 VerifyHelper &VH) {
+  bool Result = true;
+
+  for (const Identifier &Name : Info.CustomNames)
+    if (++CustomNames[Name] > 1)
+      Result = VH.fail("Duplicate name: " + Name.str().str());
+
+  if (Info.TypeName.has_value() and ++TypeNames[*Info.TypeName] > 1) {
+    Result = VH.fail(Twine("Multiple types with the following name: ")
+                     + *Info.TypeName);
+  }
+
+  for (const TypeKey &Used : Info.Uses)
+    Users[Used].insert(E);
+
+  auto [_, Inserted] = Entities.emplace(E, std::move(Info));
+  revng_assert(Inserted);
+
+  return Result;
+}
+
+std::optional<bool>
+IncrementalVerifier::verifyEntity(const model::Binary &Model,
+                                  const Entity &E,
+                                  EntityInfo &Info,
+                                  VerifyHelper &VH) const {
+  auto Verify = [&Info, &VH](const auto &Container,
+                             const auto &Key) -> std::optional<bool> {
+    auto It = Container.find(Key);
+    if (It == Container.end())
+      return std::nullopt;
+
+    const auto &Object = *It;
+    describe(Object, Info);
+
+    if constexpr (std::is_same_v<std::decay_t<decltype(Object)>,
+                                 model::UpcastableType>)
+      return Object->verify(VH);
+    else
+      return Object.verify(VH);
+  };
+
+  return std::visit(
+    [&](const auto &Key) -> std::optional<bool> {
+      using KeyType = std::decay_t<decltype(Key)>;
+      if constexpr (std::is_same_v<KeyType, FunctionKey>)
+        return Verify(Model.Functions(), Key);
+      else if constexpr (std::is_same_v<KeyType, DynamicFunctionKey>)
+        return Verify(Model.ImportedDynamicFunctions(), Key);
+      else if constexpr (std::is_same_v<KeyType, SegmentKey>)
+        return Verify(Model.Segments(), Key);
+      else
+        return Verify(Model.Types(), Key);
+    },
+    E);
+}
+
+bool IncrementalVerifier::verify(const model::Binary &Model,
+                                 const TupleTreeDiff<model::Binary> &Diff,
+                                 VerifyHelper &VH) {
+  std::set<Entity> Touched;
+  if (not Valid or not collectTouched(Diff, Touched))
+    return verify(Model, VH);
+
+  // Drop all the information about the touched entities first, so that the
+  // name checks below are not affected by their old names
+  for (const Entity &E : Touched)
+    forget(E);
+
+  bool Result = true;
+  for (const Entity &E : Touched) {
+    EntityInfo Info;
+    std::optional<bool> Verified = verifyEntity(Model, E, Info, VH);
+
+    // The entity has been removed
+    if (not Verified.has_value())
+      continue;
+
+    if (not *Verified) {
+      Result = VH.fail();
+      break;
+    }
+
+    if (not record(E, std::move(Info), VH)) {
+      Result = false;
+      break;
+    }
+  }
+
+  // If the model has entities we have not been told about (e.g., the diff
+  // changed the key of an element), fall back to a full verification
+  if (Result and Entities.size() != expectedEntities(Model))
+    return verify(Model, VH);
+
+  if (not Result)
+    reset();
+
+  return Result;
+}
+
+} // namespace model
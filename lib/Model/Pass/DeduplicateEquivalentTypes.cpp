@@ -5,9 +5,13 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/DepthFirstIterator.h"
 #include "llvm/ADT/EquivalenceClasses.h"
+#include "llvm/ADT/Hashing.h"
 #include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/SCCIterator.h"
 
 #include "revng/ADT/GenericGraph.h"
 #include "revng/ADT/STLExtras.h"
@@ -40,6 +44,26 @@ compareAll(SmallVector<model::Type *> &ToTest,
   }
 }
 
+/// Hash of the parts of a type compared by localCompare. Two types for which
+/// localCompare returns true are guaranteed to have the same local hash.
+static size_t localHash(const model::Type *T) {
+  hash_code Result = hash_combine(T->Kind(),
+                                  StringRef(T->CustomName()),
+                                  StringRef(T->OriginalName()));
+
+  // The target of each edge is not part of the local comparison, but the
+  // number of edges and their qualifiers are
+  auto Edges = T->edges();
+  Result = hash_combine(Result, Edges.size());
+  for (const model::QualifiedType &QT : Edges) {
+    Result = hash_combine(Result, QT.Qualifiers().size());
+    for (const model::Qualifier &Q : QT.Qualifiers())
+      Result = hash_combine(Result, Q.Kind(), Q.Size());
+  }
+
+  return Result;
+}
+
 class TypeSystemDeduplicator {
 private:
   struct TypeNode {
@@ -48,6 +72,10 @@ private:
   using Node = ForwardNode<TypeNode>;
   using Graph = GenericGraph<Node>;
 
+  /// Maximum number of refinement rounds for the hashes of types reaching a
+  /// cycle in the type graph
+  static constexpr unsigned MaxRefinementRounds = 16;
+
 private:
   std::vector<model::Type *> Types;
   EquivalenceClasses<model::Type *> StrongEquivalence;
@@ -55,6 +83,8 @@ private:
   Graph TypeGraph;
   std::map<const model::Type *, Node *> TypeToNode;
   std::vector<model::Type *> VisitOrder;
+  DenseMap<const model::Type *, size_t> LocalHashes;
+  DenseMap<const model::Type *, size_t> StructuralHashes;
 
 private:
   TypeSystemDeduplicator(TupleTree<model::Binary> &Model) {
@@ -66,20 +96,31 @@ public:
   static EquivalenceClasses<model::Type *>
   run(TupleTree<model::Binary> &Model) {
     TypeSystemDeduplicator Helper(Model);
+    Helper.computeLocalHashes();
     Helper.computeWeakEquivalenceClasses();
     Helper.createTypeGraph();
     Helper.computeVisitOrder();
+    Helper.computeStructuralHashes();
     Helper.computeStrongEquivalenceClasses();
     return std::move(Helper.StrongEquivalence);
   }
 
 private:
+  void computeLocalHashes() {
+    for (model::Type *T : Types)
+      LocalHashes[T] = localHash(T);
+  }
+
   void computeWeakEquivalenceClasses() {
     revng_log(Log, "Computing weak equivalence classes");
     LoggerIndent Indent(Log);
 
-    auto ComputeKey = [](model::Type *T) {
-      return std::pair{ T->OriginalName(), T->Kind() };
+    // Types with a different local hash are never weakly equivalent, including
+    // it in the key avoids comparing them
+    auto ComputeKey = [this](model::Type *T) {
+      return std::tuple{ StringRef(T->OriginalName()),
+                         T->Kind(),
+                         LocalHashes.lookup(T) };
     };
 
     // Sort types by the key (the name)
@@ -92,8 +133,9 @@ private:
     while (GroupStart != End) {
       // Find group end and collect types
       auto GroupKey = ComputeKey(*GroupStart);
-      std::string GroupName = (TypeKind::getName(GroupKey.second) + " "
-                               + GroupKey.first)
+      auto [GroupOriginalName, GroupKind, GroupHash] = GroupKey;
+      std::string GroupName = (TypeKind::getName(GroupKind) + " "
+                               + GroupOriginalName)
                                 .str();
       revng_log(Log, "Considering \"" << GroupName << "\"");
       LoggerIndent Indent2(Log);
@@ -105,7 +147,7 @@ private:
         ++GroupEnd;
       } while (GroupEnd != End and ComputeKey(*GroupEnd) == GroupKey);
 
-      if (not GroupKey.first.empty()) {
+      if (not GroupOriginalName.empty()) {
 
         auto Compare = [this](model::Type *Left, model::Type *Right) -> bool {
           revng_assert(Left != Right
@@ -181,6 +223,89 @@ private:
     TypeGraph.removeNode(Entry);
   }
 
+  /// Compute a structural hash for each type, Merkle-style: the hash of a type
+  /// depends on its local hash and on the hashes of the types it points to.
+  /// Types that are deep-equivalent are guaranteed to have the same structural
+  /// hash.
+  ///
+  /// Types that cannot reach a cycle get the hash of their whole subgraph.
+  /// For the other types, the hash describes the type graph unrolled up to a
+  /// certain depth: we iteratively refine it until the hashes stop telling
+  /// apart new types, or until MaxRefinementRounds.
+  void computeStructuralHashes() {
+    revng_log(Log, "Computing structural hashes");
+    LoggerIndent Indent(Log);
+
+    Node *Entry = TypeGraph.addNode(TypeNode{ nullptr });
+    for (Node *N : TypeGraph.nodes())
+      if (N != Entry)
+        Entry->addSuccessor(N);
+
+    // Visit the SCCs bottom-up: successors are handled before predecessors
+    DenseSet<Node *> ReachesCycle;
+    std::vector<Node *> ToRefine;
+    for (auto SCCIt = scc_begin(Entry); not SCCIt.isAtEnd(); ++SCCIt) {
+      const std::vector<Node *> &SCC = *SCCIt;
+      if (SCC.size() == 1 and SCC[0] == Entry)
+        continue;
+
+      bool IsAcyclic = not SCCIt.hasCycle();
+      for (Node *N : SCC)
+        for (Node *Successor : N->successors())
+          IsAcyclic = IsAcyclic and not ReachesCycle.contains(Successor);
+
+      if (IsAcyclic) {
+        revng_assert(SCC.size() == 1);
+        Node *N = SCC[0];
+        hash_code Hash = LocalHashes.lookup(N->T);
+        for (Node *Successor : N->successors())
+          Hash = hash_combine(Hash, StructuralHashes.lookup(Successor->T));
+        StructuralHashes[N->T] = Hash;
+      } else {
+        for (Node *N : SCC) {
+          ReachesCycle.insert(N);
+          ToRefine.push_back(N);
+          StructuralHashes[N->T] = LocalHashes.lookup(N->T);
+        }
+      }
+    }
+
+    TypeGraph.removeNode(Entry);
+
+    revng_log(Log,
+              ToRefine.size() << " types out of " << Types.size()
+                              << " reach a cycle");
+
+    auto CountDistinct = [this, &ToRefine]() {
+      DenseSet<size_t> Distinct;
+      for (Node *N : ToRefine)
+        Distinct.insert(StructuralHashes.lookup(N->T));
+      return Distinct.size();
+    };
+
+    size_t DistinctHashes = CountDistinct();
+    std::vector<size_t> NewHashes(ToRefine.size());
+    for (unsigned Round = 0; Round < MaxRefinementRounds; ++Round) {
+      for (auto [N, NewHash] : zip(ToRefine, NewHashes)) {
+        hash_code Hash = LocalHashes.lookup(N->T);
+        for (Node *Successor : N->successors())
+          Hash = hash_combine(Hash, StructuralHashes.lookup(Successor->T));
+        NewHash = Hash;
+      }
+
+      for (auto [N, NewHash] : zip(ToRefine, NewHashes))
+        StructuralHashes[N->T] = NewHash;
+
+      size_t NewDistinctHashes = CountDistinct();
+      revng_log(Log,
+                "Refinement round " << Round << ": " << NewDistinctHashes
+                                    << " distinct hashes");
+      if (NewDistinctHashes == DistinctHashes)
+        break;
+      DistinctHashes = NewDistinctHashes;
+    }
+  }
+
   void computeStrongEquivalenceClasses() {
     revng_log(Log, "Computing strong equivalence classes");
     LoggerIndent Indent(Log);
@@ -193,10 +318,12 @@ private:
       auto LeaderIt = WeakEquivalence.findValue(Leader);
       revng_assert(LeaderIt->isLeader());
 
-      SmallVector<model::Type *> ToTest;
-      std::copy(WeakEquivalence.member_begin(LeaderIt),
-                WeakEquivalence.member_end(),
-                std::back_inserter(ToTest));
+      // Types with different structural hashes cannot be equivalent: group
+      // the candidates by hash and deep-compare only within each group
+      std::map<size_t, SmallVector<model::Type *>> Candidates;
+      for (model::Type *T : make_range(WeakEquivalence.member_begin(LeaderIt),
+                                       WeakEquivalence.member_end()))
+        Candidates[StructuralHashes.lookup(T)].push_back(T);
 
       auto Compare = [this](model::Type *Left, model::Type *Right) {
         if (Left == Right or StrongEquivalence.isEquivalent(Left, Right))
@@ -212,7 +339,8 @@ private:
         return Result;
       };
 
-      compareAll(ToTest, Compare);
+      for (auto &[Hash, ToTest] : Candidates)
+        compareAll(ToTest, Compare);
     }
   }
 
@@ -298,6 +298,12 @@ public:
 
 static llvm::ManagedStatic<RNG> IDGenerator;
 
+std::optional<uint64_t> getTypeIDSeed() {
+  if (ModelTypeIDSeed.getNumOccurrences() == 0)
+    return std::nullopt;
+  return ModelTypeIDSeed.getValue();
+}
+
 model::Type::Type() :
   model::generated::Type(model::TypeKind::Invalid, IDGenerator->get()){};
 
@@ -67,8 +67,8 @@ public:
   T *operator->() { return Pointer; }
 };
 
-void revng::tracing::setTracing(llvm::raw_ostream *OS) {
-  Tracing.swap(OS);
+void revng::tracing::setTracing(llvm::raw_ostream *OS, TraceFormat Format) {
+  Tracing.swap(OS, Format);
 }
 
 /// Used when we want to return a stack allocated string. Copies the string onto
@@ -0,0 +1,252 @@
+/// \file BinaryReader.cpp
+/// \brief Implements the streaming reader for binary traces and the conversion
+///        of a stream of commands to the YAML trace format
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <cinttypes>
+
+#include "llvm/Support/Base64.h"
+#include "llvm/Support/YAMLTraits.h"
+
+#include "revng/PipelineC/Tracing/BinaryTrace.h"
+#include "revng/PipelineC/Tracing/Trace.h"
+
+namespace binary = revng::tracing::binary;
+
+using binary::ArgumentKind;
+using binary::RecordDecoder;
+using binary::RecordKind;
+
+static llvm::Error malformed(size_t Offset, const llvm::Twine &Reason) {
+  return llvm::createStringError(llvm::inconvertibleErrorCode(),
+                                 "Malformed binary trace at offset "
+                                   + llvm::Twine(Offset) + ": " + Reason);
+}
+
+static bool decodeArgument(RecordDecoder &Decoder,
+                           revng::tracing::Argument &Argument) {
+  std::optional<uint8_t> Kind = Decoder.readByte();
+  if (not Kind.has_value())
+    return false;
+
+  switch (static_cast<ArgumentKind>(*Kind)) {
+  case ArgumentKind::Scalar: {
+    std::optional<llvm::StringRef> Value = Decoder.readString();
+    if (not Value.has_value())
+      return false;
+    Argument.getScalar() = Value->str();
+    return true;
+  }
+
+  case ArgumentKind::Buffer: {
+    // Buffers are stored raw, but the rest of the tracing infrastructure
+    // expects them base64-encoded, as in the YAML format
+    std::optional<llvm::StringRef> Value = Decoder.readString();
+    if (not Value.has_value())
+      return false;
+    Argument.getScalar() = llvm::encodeBase64(*Value);
+    return true;
+  }
+
+  case ArgumentKind::Sequence: {
+    std::optional<uint64_t> Count = Decoder.readInteger();
+    if (not Count.has_value())
+      return false;
+
+    std::vector<std::string> &Sequence = Argument.getSequence();
+    for (uint64_t I = 0; I < *Count; ++I) {
+      std::optional<llvm::StringRef> Element = Decoder.readString();
+      if (not Element.has_value())
+        return false;
+      Sequence.push_back(Element->str());
+    }
+    return true;
+  }
+  }
+
+  return false;
+}
+
+namespace revng::tracing {
+
+llvm::Expected<std::unique_ptr<BinaryTraceReader>>
+BinaryTraceReader::fromFile(const llvm::StringRef Path) {
+  auto MaybeBuffer = llvm::MemoryBuffer::getFile(Path,
+                                                 /* IsText */ false,
+                                                 /* RequiresNullTerminator */
+                                                 false);
+  if (std::error_code EC = MaybeBuffer.getError()) {
+    return llvm::createStringError(EC,
+                                   "Unable to read input trace: "
+                                     + EC.message());
+  }
+
+  llvm::StringRef Data = (*MaybeBuffer)->getBuffer();
+  return create(Data, std::move(*MaybeBuffer));
+}
+
+llvm::Expected<std::unique_ptr<BinaryTraceReader>>
+BinaryTraceReader::fromBuffer(const llvm::MemoryBuffer &Buffer) {
+  return create(Buffer.getBuffer(), nullptr);
+}
+
+llvm::Expected<std::unique_ptr<BinaryTraceReader>>
+BinaryTraceReader::create(llvm::StringRef Data,
+                          std::unique_ptr<llvm::MemoryBuffer> Owned) {
+  if (not binary::isBinaryTrace(Data))
+    return malformed(0, "missing magic");
+
+  std::unique_ptr<BinaryTraceReader>
+    Result(new BinaryTraceReader(Data, std::move(Owned)));
+
+  llvm::StringRef Header = Data.drop_front(binary::Magic.size());
+  RecordDecoder Decoder(Header);
+  std::optional<uint64_t> Version = Decoder.readInteger();
+  if (not Version.has_value())
+    return malformed(binary::Magic.size(), "truncated header");
+
+  if (*Version != binary::Version) {
+    return llvm::createStringError(llvm::inconvertibleErrorCode(),
+                                   "Unexpected binary trace version: %" PRIu64,
+                                   *Version);
+  }
+
+  Result->Offset = binary::Magic.size() + Decoder.consumed(Header);
+  return Result;
+}
+
+/// Returns the payload of the record at the current offset, std::nullopt at
+/// the end of the trace
+llvm::Expected<std::optional<llvm::StringRef>>
+BinaryTraceReader::nextRecord(bool Consume) {
+  if (Offset == Data.size())
+    return std::nullopt;
+
+  llvm::StringRef Rest = Data.drop_front(Offset);
+  RecordDecoder Decoder(Rest);
+  std::optional<uint32_t> Size = Decoder.readRecordSize();
+  std::optional<llvm::StringRef> Payload;
+  if (Size.has_value())
+    Payload = Decoder.readBytes(*Size);
+
+  if (not Payload.has_value() or Payload->empty())
+    return malformed(Offset, "truncated record");
+
+  if (Consume)
+    Offset += Decoder.consumed(Rest);
+
+  return Payload;
+}
+
+llvm::Expected<const Command *> BinaryTraceReader::next() {
+  size_t RecordOffset = Offset;
+  auto MaybeStart = nextRecord(true);
+  if (not MaybeStart)
+    return MaybeStart.takeError();
+
+  if (not MaybeStart->has_value())
+    return nullptr;
+
+  RecordDecoder Decoder(**MaybeStart);
+  if (Decoder.readByte() != static_cast<uint8_t>(RecordKind::CommandStart))
+    return malformed(RecordOffset, "expected the start of a command");
+
+  std::optional<uint64_t> ID = Decoder.readInteger();
+  std::optional<uint64_t> StartTime = Decoder.readInteger();
+  std::optional<llvm::StringRef> Name = Decoder.readString();
+  std::optional<uint64_t> ArgumentsCount = Decoder.readInteger();
+  if (not ID or not StartTime or not Name or not ArgumentsCount)
+    return malformed(RecordOffset, "truncated command");
+
+  Current.ID = *ID;
+  Current.StartTime = *StartTime;
+  Current.Name = Name->str();
+  Current.Arguments.clear();
+  Current.Result.clear();
+  Current.EndTime = 0;
+
+  for (uint64_t I = 0; I < *ArgumentsCount; ++I) {
+    if (not decodeArgument(Decoder, Current.Arguments.emplace_back()))
+      return malformed(RecordOffset, "invalid argument #" + llvm::Twine(I));
+  }
+
+  // The end of the command is a separate record. It might be missing if the
+  // traced process terminated while the command was executing.
+  auto MaybeEnd = nextRecord(false);
+  if (not MaybeEnd)
+    return MaybeEnd.takeError();
+
+  if (not MaybeEnd->has_value())
+    return &Current;
+
+  RecordDecoder EndDecoder(**MaybeEnd);
+  if (EndDecoder.readByte() != static_cast<uint8_t>(RecordKind::CommandEnd)
+      or EndDecoder.readInteger() != Current.ID)
+    return &Current;
+
+  std::optional<llvm::StringRef> Result = EndDecoder.readString();
+  std::optional<uint64_t> EndTime = EndDecoder.readInteger();
+  if (not Result or not EndTime)
+    return malformed(Offset, "truncated command end");
+
+  Current.Result = Result->str();
+  Current.EndTime = *EndTime;
+  llvm::cantFail(nextRecord(true));
+
+  return &Current;
+}
+
+static void writeYAMLScalar(llvm::raw_ostream &OS, llvm::StringRef Value) {
+  if (llvm::yaml::needsQuotes(Value) == llvm::yaml::QuotingType::None)
+    OS << Value;
+  else
+    OS << '"' << llvm::yaml::escape(Value) << '"';
+}
+
+llvm::Error writeYAML(CommandStream &Stream, llvm::raw_ostream &OS) {
+  OS << "Version: 1\n";
+  OS << "Commands:\n";
+
+  while (true) {
+    auto MaybeCommand = Stream.next();
+    if (not MaybeCommand)
+      return MaybeCommand.takeError();
+
+    const Command *Command = *MaybeCommand;
+    if (Command == nullptr)
+      break;
+
+    OS << "- ID: " << Command->ID << "\n";
+    OS << "  StartTime: " << Command->StartTime << "\n";
+    OS << "  Name: " << Command->Name << "\n";
+    OS << "  Arguments:\n";
+    for (const Argument &Argument : Command->Arguments) {
+      OS << "  - ";
+      if (Argument.isScalar()) {
+        writeYAMLScalar(OS, Argument.getScalar());
+      } else {
+        OS << "[";
+        llvm::interleave(
+          Argument.getSequence(),
+          OS,
+          [&OS](const std::string &Element) { writeYAMLScalar(OS, Element); },
+          ", ");
+        OS << "]";
+      }
+      OS << "\n";
+    }
+
+    if (not Command->Result.empty()) {
+      OS << "  Result: " << Command->Result << "\n";
+      OS << "  EndTime: " << Command->EndTime << "\n";
+    }
+  }
+
+  OS.flush();
+  return llvm::Error::success();
+}
+
+} // namespace revng::tracing
@@ -0,0 +1,276 @@
+#pragma once
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "llvm/Support/Base64.h"
+#include "llvm/Support/YAMLTraits.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "revng/PipelineC/Tracing/BinaryTrace.h"
+#include "revng/Support/Assert.h"
+
+// Formatters receive the already-stringified components of each command from
+// the TraceWriter and take care of serializing them in a specific trace format
+class TraceFormatter {
+public:
+  virtual ~TraceFormatter() = default;
+
+public:
+  virtual void commandStart(uint64_t ID,
+                            uint64_t StartTime,
+                            llvm::StringRef Name) = 0;
+
+  // If IsString is true the value is a string provided by the user, as opposed
+  // to an integer, a boolean or a pointer
+  virtual void scalarArgument(llvm::StringRef Value, bool IsString) = 0;
+  virtual void bufferArgument(llvm::StringRef Buffer) = 0;
+
+  virtual void listStart(uint64_t Length) = 0;
+  virtual void listElement(llvm::StringRef Value, bool IsString) = 0;
+  virtual void listEnd() = 0;
+
+  // Invoked after all the arguments have been emitted, before the command is
+  // actually executed
+  virtual void argumentsEnd() = 0;
+  virtual void commandEnd(uint64_t ID,
+                          llvm::StringRef Result,
+                          uint64_t EndTime) = 0;
+};
+
+// Emits the trace as YAML, unbuffered so that the trace is always up to date
+// even in case of a crash
+class YAMLTraceFormatter : public TraceFormatter {
+private:
+  llvm::raw_ostream &OS;
+  bool FirstListElement = false;
+
+public:
+  YAMLTraceFormatter(llvm::raw_ostream &OS) : OS(OS) {
+    OS.SetUnbuffered();
+    OS << "Version: 1\n";
+    OS << "Commands:\n";
+    OS.flush();
+  }
+
+public:
+  void commandStart(uint64_t ID,
+                    uint64_t StartTime,
+                    llvm::StringRef Name) override {
+    OS << "- ID: " << ID << "\n";
+    OS << "  StartTime: " << StartTime << "\n";
+    OS << "  Name: " << Name << "\n";
+    OS << "  Arguments:\n";
+    OS.flush();
+  }
+
+  void scalarArgument(llvm::StringRef Value, bool IsString) override {
+    OS << "  - ";
+    printScalar(Value, IsString);
+    OS << "\n";
+    OS.flush();
+  }
+
+  void bufferArgument(llvm::StringRef Buffer) override {
+    OS << "  - " << llvm::encodeBase64(Buffer) << "\n";
+    OS.flush();
+  }
+
+  void listStart(uint64_t Length) override {
+    OS << "  - [";
+    FirstListElement = true;
+  }
+
+  void listElement(llvm::StringRef Value, bool IsString) override {
+    if (not FirstListElement)
+      OS << ", ";
+    FirstListElement = false;
+    printScalar(Value, IsString);
+  }
+
+  void listEnd() override {
+    OS << "]\n";
+    OS.flush();
+  }
+
+  void argumentsEnd() override {}
+
+  void commandEnd(uint64_t ID,
+                  llvm::StringRef Result,
+                  uint64_t EndTime) override {
+    OS << "  Result: " << Result << "\n";
+    OS << "  EndTime: " << EndTime << "\n";
+    OS.flush();
+  }
+
+private:
+  void printScalar(llvm::StringRef Value, bool IsString) {
+    if (IsString)
+      OS << '"' << llvm::yaml::escape(Value) << '"';
+    else
+      OS << Value;
+  }
+};
+
+// Writes data to a stream from a background thread, so that the traced
+// process does not wait for the I/O to complete. If the background thread
+// falls behind by more than MaxPending bytes, the producer waits for it.
+class AsyncTraceOutput {
+private:
+  static constexpr size_t MaxPending = 64 * 1024 * 1024;
+
+private:
+  llvm::raw_ostream &OS;
+  std::mutex Mutex;
+  std::condition_variable DataAvailable;
+  std::condition_variable SpaceAvailable;
+  std::string Pending;
+  bool Stop = false;
+  std::thread Thread;
+
+public:
+  AsyncTraceOutput(llvm::raw_ostream &OS) :
+    OS(OS), Thread([this]() { this->run(); }) {}
+
+  ~AsyncTraceOutput() {
+    {
+      std::lock_guard Lock(Mutex);
+      Stop = true;
+    }
+    DataAvailable.notify_one();
+    Thread.join();
+    OS.flush();
+  }
+
+  AsyncTraceOutput(const AsyncTraceOutput &) = delete;
+  AsyncTraceOutput(AsyncTraceOutput &&) = delete;
+  AsyncTraceOutput &operator=(const AsyncTraceOutput &) = delete;
+  AsyncTraceOutput &operator=(AsyncTraceOutput &&) = delete;
+
+public:
+  void push(llvm::StringRef Data) {
+    {
+      std::unique_lock Lock(Mutex);
+      SpaceAvailable.wait(Lock, [this]() {
+        return Pending.size() < MaxPending;
+      });
+      Pending.append(Data.data(), Data.size());
+    }
+    DataAvailable.notify_one();
+  }
+
+private:
+  void run() {
+    std::string Writing;
+    while (true) {
+      {
+        std::unique_lock Lock(Mutex);
+        DataAvailable.wait(Lock, [this]() {
+          return Stop or not Pending.empty();
+        });
+
+        if (Pending.empty() and Stop)
+          return;
+
+        std::swap(Writing, Pending);
+      }
+      SpaceAvailable.notify_all();
+
+      OS << Writing;
+      OS.flush();
+      Writing.clear();
+    }
+  }
+};
+
+// Emits the binary trace format (see BinaryTrace.h). Records are assembled in
+// memory and handed over to an AsyncTraceOutput.
+class BinaryTraceFormatter : public TraceFormatter {
+private:
+  using ArgumentKind = revng::tracing::binary::ArgumentKind;
+  using RecordKind = revng::tracing::binary::RecordKind;
+
+private:
+  size_t ArgumentsCountOffset = 0;
+  uint8_t ArgumentsCount = 0;
+  std::string Buffer;
+  revng::tracing::binary::RecordEncoder Encoder;
+  AsyncTraceOutput Output;
+
+public:
+  BinaryTraceFormatter(llvm::raw_ostream &OS) : Encoder(Buffer), Output(OS) {
+    Encoder.writeHeader();
+    flushRecord();
+  }
+
+public:
+  void commandStart(uint64_t ID,
+                    uint64_t StartTime,
+                    llvm::StringRef Name) override {
+    Encoder.beginRecord(RecordKind::CommandStart);
+    Encoder.writeInteger(ID);
+    Encoder.writeInteger(StartTime);
+    Encoder.writeString(Name);
+
+    // Reserve a byte for the number of arguments, it's patched in argumentsEnd
+    ArgumentsCountOffset = Buffer.size();
+    ArgumentsCount = 0;
+    Buffer.push_back('\0');
+  }
+
+  void scalarArgument(llvm::StringRef Value, bool IsString) override {
+    ++ArgumentsCount;
+    Encoder.writeArgumentKind(ArgumentKind::Scalar);
+    Encoder.writeString(Value);
+  }
+
+  void bufferArgument(llvm::StringRef Data) override {
+    ++ArgumentsCount;
+    Encoder.writeArgumentKind(ArgumentKind::Buffer);
+    Encoder.writeString(Data);
+  }
+
+  void listStart(uint64_t Length) override {
+    ++ArgumentsCount;
+    Encoder.writeArgumentKind(ArgumentKind::Sequence);
+    Encoder.writeInteger(Length);
+  }
+
+  void listElement(llvm::StringRef Value, bool IsString) override {
+    Encoder.writeString(Value);
+  }
+
+  void listEnd() override {}
+
+  void argumentsEnd() override {
+    // PipelineC functions have way less than 128 arguments, hence the count
+    // always fits a single ULEB128 byte
+    revng_assert(ArgumentsCount < 128);
+    Buffer[ArgumentsCountOffset] = static_cast<char>(ArgumentsCount);
+    Encoder.endRecord();
+    flushRecord();
+  }
+
+  void commandEnd(uint64_t ID,
+                  llvm::StringRef Result,
+                  uint64_t EndTime) override {
+    Encoder.beginRecord(RecordKind::CommandEnd);
+    Encoder.writeInteger(ID);
+    Encoder.writeString(Result);
+    Encoder.writeInteger(EndTime);
+    Encoder.endRecord();
+    flushRecord();
+  }
+
+private:
+  void flushRecord() {
+    Output.push(Buffer);
+    Buffer.clear();
+  }
+};
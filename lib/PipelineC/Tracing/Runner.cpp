@@ -10,12 +10,14 @@
 #include <csignal>
 
 #include "llvm/Support/Base64.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Process.h"
 #include "llvm/Support/Signals.h"
 #include "llvm/Support/raw_ostream.h"
 
 #include "revng/ADT/ConstexprString.h"
 #include "revng/PipelineC/PipelineC.h"
+#include "revng/PipelineC/Tracing/BinaryTrace.h"
 #include "revng/PipelineC/Tracing/Common.h"
 #include "revng/PipelineC/Tracing/Trace.h"
 #include "revng/Support/Assert.h"
@@ -413,33 +415,101 @@ argumentTransformer(RunnerContext &Context,
   return NewArguments;
 }
 
+namespace {
+
+/// Provides the commands of an in-memory trace
+class VectorCommandStream : public revng::tracing::CommandStream {
+private:
+  llvm::ArrayRef<revng::tracing::Command> Commands;
+
+public:
+  VectorCommandStream(llvm::ArrayRef<revng::tracing::Command> Commands) :
+    Commands(Commands) {}
+
+  llvm::Expected<const revng::tracing::Command *> next() override {
+    if (Commands.empty())
+      return nullptr;
+
+    const revng::tracing::Command *Result = &Commands.front();
+    Commands = Commands.drop_front();
+    return Result;
+  }
+};
+
+} // namespace
+
 namespace revng::tracing {
 llvm::Error Trace::run(const revng::tracing::RunTraceOptions Options) const {
-  using namespace revng;
+  VectorCommandStream Stream(this->Commands);
+  return tracing::run(Stream, Options);
+};
 
+llvm::Error run(CommandStream &Stream, const RunTraceOptions Options) {
   RunnerContext Context(Options);
 
-  const tracing::Command &FirstCommand = this->Commands.front();
-  const tracing::Command &LastCommand = this->Commands.back();
-
   // Allow rp_initialize as first command and rp_shutdown as last, in all other
-  // cases the trace is malformed and needs to be aborted
-  const size_t FirstCommandI = FirstCommand.Name == "rp_initialize" ? 1 : 0;
-  const size_t LastCommandI = this->Commands.size()
-                              - (LastCommand.Name == "rp_shutdown" ? 1 : 0);
-
-  for (size_t CommandI = FirstCommandI; CommandI < LastCommandI; CommandI++) {
-    auto &Command = this->Commands[CommandI];
-    revng_check(CommandHandler.has(Command.Name),
+  // cases the trace is malformed and needs to be aborted. Since the trace is
+  // being streamed, the last command is not known in advance: rp_shutdown is
+  // handled when the next command, if any, is encountered.
+  bool PendingShutdown = false;
+  for (size_t CommandI = 0;; CommandI++) {
+    auto MaybeCommand = Stream.next();
+    if (not MaybeCommand)
+      return MaybeCommand.takeError();
+
+    const tracing::Command *Command = *MaybeCommand;
+    if (Command == nullptr)
+      break;
+
+    if (CommandI == 0 and Command->Name == "rp_initialize")
+      continue;
+
+    if (PendingShutdown) {
+      CommandHandler["rp_shutdown"](Context, {}, "");
+      PendingShutdown = false;
+    }
+
+    if (Command->Name == "rp_shutdown") {
+      PendingShutdown = true;
+      continue;
+    }
+
+    revng_check(CommandHandler.has(Command->Name),
                 "Command handler for command not found");
-    auto Arguments = argumentTransformer(Context, Command);
+    auto Arguments = argumentTransformer(Context, *Command);
 
     if (Options.BreakAt.contains(CommandI))
       raise(SIGTRAP);
 
-    CommandHandler[Command.Name](Context, Arguments, Command.Result);
+    CommandHandler[Command->Name](Context, Arguments, Command->Result);
   }
 
   return llvm::Error::success();
-};
+}
+
+llvm::Error runFile(const llvm::StringRef Path, const RunTraceOptions Options) {
+  // The buffer is memory-mapped, binary traces are decoded while running
+  auto MaybeBuffer = llvm::MemoryBuffer::getFile(Path,
+                                                 /* IsText */ false,
+                                                 /* RequiresNullTerminator */
+                                                 false);
+  if (std::error_code EC = MaybeBuffer.getError()) {
+    return llvm::createStringError(EC,
+                                   "Unable to read input trace: "
+                                     + EC.message());
+  }
+
+  if (binary::isBinaryTrace((*MaybeBuffer)->getBuffer())) {
+    auto MaybeReader = BinaryTraceReader::fromBuffer(**MaybeBuffer);
+    if (not MaybeReader)
+      return MaybeReader.takeError();
+    return run(**MaybeReader, Options);
+  }
+
+  auto MaybeTrace = Trace::fromBuffer(**MaybeBuffer);
+  if (not MaybeTrace)
+    return MaybeTrace.takeError();
+  return MaybeTrace->run(Options);
+}
+
 } // namespace revng::tracing
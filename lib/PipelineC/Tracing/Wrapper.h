@@ -3,22 +3,27 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <thread>
 
-#include "llvm/Support/Base64.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/Support/Process.h"
 #include "llvm/Support/raw_ostream.h"
 
 #include "revng/ADT/ConstexprString.h"
 #include "revng/PipelineC/PipelineC.h"
 #include "revng/PipelineC/Tracing/Common.h"
+#include "revng/PipelineC/Tracing/Private.h"
 #include "revng/Support/Assert.h"
 
+#include "Formatters.h"
 #include "Types.h"
 
 inline constexpr auto TracingEnv = "REVNG_C_API_TRACE_PATH";
+// Either "yaml" (the default) or "binary"
+inline constexpr auto TracingFormatEnv = "REVNG_C_API_TRACE_FORMAT";
 inline auto PointerStyle = llvm::HexPrintStyle::PrefixLower;
 
 // The opposite of a std::recursive_mutex, if locked by the same thread it will
@@ -49,11 +54,11 @@ public:
 inline OncePerThreadMutex TraceMutex;
 
 // Helper class for tracing, this will be used by the the argument/return
-// handlers defined below to properly print the value of the arguments onto the
-// YAML tracing file
+// handlers defined below to convert the value of the arguments to strings,
+// which are then handed over to a TraceFormatter
 class TraceWriter {
 private:
-  llvm::raw_ostream &OS;
+  std::unique_ptr<TraceFormatter> Formatter;
   // If true it means we're outputting a function's arguments, whereas if it is
   // false it means that we're outputting its return value.
   // This is needed because sometimes, for the same data type, we want to output
@@ -64,49 +69,42 @@ private:
   // Integer used to compute the ID of the command
   uint64_t ID = 0;
 
+  // Stringified return value of the current command
+  llvm::SmallString<32> Result;
+
 public:
-  TraceWriter(llvm::raw_ostream &OS) : OS(OS) {
-    OS.SetUnbuffered();
-    printHeader();
-  }
+  TraceWriter(std::unique_ptr<TraceFormatter> &&Formatter) :
+    Formatter(std::move(Formatter)) {}
 
 public:
   void functionPrelude(const llvm::StringRef Name) {
-    OS << "- ID: " << ID++ << "\n";
-    OS << "  StartTime: " << getUnixMillis() << "\n";
-    OS << "  Name: " << Name << "\n";
-    OS << "  Arguments:\n";
+    Formatter->commandStart(ID, getUnixMillis(), Name);
     OutputtingArguments = true;
-    OS.flush();
   }
 
-  void newArgument() {
-    OS << "  - ";
-    OS.flush();
-  }
+  void functionArgumentsEnd() { Formatter->argumentsEnd(); }
 
   // For integral types we still keep the template parameter. This is to avoid
   // the overload selector doing an implicit conversion of unexpected types to
   // these types
   template<IntegerType T>
   void printValue(const T &Int) {
-    OS << Int << "\n";
-    OS.flush();
+    llvm::SmallString<24> String;
+    llvm::raw_svector_ostream(String) << Int;
+    printScalar(String);
   }
 
   template<typename T>
     requires std::is_same_v<T, bool>
   void printValue(const T &Bool) {
-    OS << (Bool ? "true" : "false") << "\n";
-    OS.flush();
+    printScalar(Bool ? "true" : "false");
   }
 
   template<typename T>
     requires std::is_same_v<T, char>
   void printValue(const T *String) {
     if (OutputtingArguments) {
-      OS << reprString(String) << "\n";
-      OS.flush();
+      Formatter->scalarArgument(String, true);
     } else {
       printPointer(String);
     }
@@ -122,84 +120,69 @@ public:
     // NOTE: if reading traces becomes a major task, it might be beneficial to
     // switch to a representation with increasing indexes, e.g. object_1,
     // object_2, ...
-    OS << PointerPrefix;
-    llvm::write_hex(OS, reinterpret_cast<uintptr_t>(Ptr), PointerStyle);
-    OS << "\n";
-    OS.flush();
+    printScalar(pointerToString(Ptr));
   }
 
   void printBuffer(const llvm::StringRef Input) {
-    OS << llvm::encodeBase64(Input) << "\n";
-    OS.flush();
+    Formatter->bufferArgument(Input);
   }
 
   template<IntegerType T>
   void printList(const T IntList[], uint64_t Length) {
     using IntT = max_int<T>;
-    OS << "[";
+    Formatter->listStart(Length);
     for (uint64_t I = 0; I < Length; I++) {
-      OS << static_cast<IntT>(IntList[I]);
-      if (I < Length - 1) {
-        OS << ", ";
-      }
+      llvm::SmallString<24> String;
+      llvm::raw_svector_ostream(String) << static_cast<IntT>(IntList[I]);
+      Formatter->listElement(String, false);
     }
-    OS << "]\n";
-    OS.flush();
+    Formatter->listEnd();
   }
 
   template<typename T>
     requires std::is_same_v<T, char>
   void printList(const T *StringList[], uint64_t Length) {
-    OS << "[";
-    for (uint64_t I = 0; I < Length; I++) {
-      OS << reprString(StringList[I]);
-      if (I < Length - 1) {
-        OS << ", ";
-      }
-    }
-    OS << "]\n";
-    OS.flush();
+    Formatter->listStart(Length);
+    for (uint64_t I = 0; I < Length; I++)
+      Formatter->listElement(StringList[I], true);
+    Formatter->listEnd();
   }
 
   template<RPType T>
   void printList(const T *PtrList[], uint64_t Length) {
-    OS << "[";
-    for (uint64_t I = 0; I < Length; I++) {
-      OS << PointerPrefix;
-      llvm::write_hex(OS,
-                      reinterpret_cast<uintptr_t>(PtrList[I]),
-                      PointerStyle);
-      if (I < Length - 1) {
-        OS << ", ";
-      }
-    }
-    OS << "]\n";
-    OS.flush();
+    Formatter->listStart(Length);
+    for (uint64_t I = 0; I < Length; I++)
+      Formatter->listElement(pointerToString(PtrList[I]), false);
+    Formatter->listEnd();
   }
 
   template<typename... T>
     requires(sizeof...(T) < 2)
   void printReturn(T... ReturnValue) {
     OutputtingArguments = false;
-    OS << "  Result: ";
     if constexpr (sizeof...(T) == 0) {
-      OS << "null\n";
+      Result = "null";
     } else {
       printValue(ReturnValue...);
     }
-    OS << "  EndTime: " << getUnixMillis() << "\n";
-    OS.flush();
+    Formatter->commandEnd(ID++, Result, getUnixMillis());
   }
 
 private:
-  void printHeader() {
-    OS << "Version: 1\n";
-    OS << "Commands:\n";
-    OS.flush();
+  void printScalar(const llvm::StringRef String) {
+    if (OutputtingArguments)
+      Formatter->scalarArgument(String, false);
+    else
+      Result = String;
   }
 
-  std::string reprString(const char *String) {
-    return '"' + llvm::yaml::escape(String) + '"';
+  template<typename T>
+  static llvm::SmallString<32> pointerToString(const T *Ptr) {
+    llvm::SmallString<32> Result;
+    llvm::raw_svector_ostream OS(Result);
+    OS << PointerPrefix;
+    llvm::write_hex(OS, reinterpret_cast<uintptr_t>(Ptr), PointerStyle);
+    return Result;
   }
 
   // Returns the number of milliseconds since epoch
@@ -210,26 +193,49 @@ private:
   }
 };
 
+inline std::unique_ptr<TraceFormatter>
+makeFormatter(llvm::raw_ostream &OS, revng::tracing::TraceFormat Format) {
+  switch (Format) {
+  case revng::tracing::TraceFormat::YAML:
+    return std::make_unique<YAMLTraceFormatter>(OS);
+  case revng::tracing::TraceFormat::Binary:
+    return std::make_unique<BinaryTraceFormatter>(OS);
+  }
+
+  revng_abort();
+}
+
 class TracingRuntime {
 private:
-  std::optional<TraceWriter> Writer;
   std::optional<llvm::raw_fd_ostream> OS;
+  std::optional<TraceWriter> Writer;
 
 public:
   TracingRuntime() {
     if (auto Path = llvm::sys::Process::GetEnv(TracingEnv)) {
+      using revng::tracing::TraceFormat;
+      TraceFormat Format = TraceFormat::YAML;
+      if (auto FormatName = llvm::sys::Process::GetEnv(TracingFormatEnv)) {
+        if (*FormatName == "binary")
+          Format = TraceFormat::Binary;
+        else
+          revng_check(*FormatName == "yaml", "Unknown trace format");
+      }
+
       std::error_code EC;
       OS.emplace(*Path, EC);
       revng_assert(!EC);
-      Writer.emplace(*OS);
+      Writer.emplace(makeFormatter(*OS, Format));
     }
   }
 
-  void swap(llvm::raw_ostream *NewOS = nullptr) {
+  void swap(llvm::raw_ostream *NewOS = nullptr,
+            revng::tracing::TraceFormat Format = {}) {
+    // The writer needs to go first, since it might flush pending data to OS
     Writer.reset();
     OS.reset();
     if (NewOS != nullptr) {
-      Writer.emplace(*NewOS);
+      Writer.emplace(makeFormatter(*NewOS, Format));
     }
   }
 
@@ -250,7 +256,6 @@ inline TracingRuntime Tracing;
 
 template<ConstexprString Name, int I, int N, typename... T>
 inline void handleArgument(std::tuple<T...> Args) {
-  Tracing->newArgument();
   using ArgT = decltype(std::get<I>(Args));
   using RArgT = std::remove_reference_t<ArgT>;
   ArgT Argument = std::get<I>(Args);
@@ -300,6 +305,7 @@ inline decltype(auto) wrap(CalleeT Callee, ArgsT... Args) {
 
     Tracing->functionPrelude(std::string_view(Name));
     handleArguments<Name>(Args...);
+    Tracing->functionArgumentsEnd();
     if constexpr (std::is_same_v<ReturnT, void>) {
       Callee(std::forward<ArgsT>(Args)...);
       Tracing->printReturn();
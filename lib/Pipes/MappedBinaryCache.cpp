@@ -0,0 +1,75 @@
+/// \file MappedBinaryCache.cpp
+/// \brief Sharing of the memory-mapped input binaries across pipes
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include "llvm/Support/FileSystem.h"
+
+#include "revng/Pipes/MappedBinaryCache.h"
+
+using namespace llvm;
+
+namespace revng::pipes {
+
+Expected<MappedBinaryCache::Buffer> MappedBinaryCache::map(StringRef Path) {
+  // Without the null terminator requirement, files larger than a few pages are
+  // mapped rather than read. The standard input, pipes and devices are read.
+  constexpr bool IsText = false;
+  constexpr bool RequiresNullTerminator = false;
+  auto MaybeBuffer = MemoryBuffer::getFileOrSTDIN(Path,
+                                                  IsText,
+                                                  RequiresNullTerminator);
+  if (not MaybeBuffer)
+    return errorCodeToError(MaybeBuffer.getError());
+
+  return Buffer(std::move(*MaybeBuffer));
+}
+
+Expected<MappedBinaryCache::Buffer> MappedBinaryCache::get(StringRef Path) {
+  // The standard input has no status
+  if (Path == "-")
+    return map(Path);
+
+  sys::fs::file_status Status;
+  if (std::error_code EC = sys::fs::status(Path, Status))
+    return errorCodeToError(EC);
+
+  // We cannot tell whether the contents of pipes and devices have changed
+  if (not sys::fs::is_regular_file(Status))
+    return map(Path);
+
+  auto It = Entries.find(Path);
+  if (It != Entries.end()) {
+    const Entry &Cached = It->second;
+    if (Cached.ID == Status.getUniqueID() and Cached.Size == Status.getSize()
+        and Cached.LastModification == Status.getLastModificationTime())
+      return Cached.Data;
+  }
+
+  auto MaybeBuffer = map(Path);
+  if (not MaybeBuffer)
+    return MaybeBuffer.takeError();
+
+  Entries[Path] = Entry{ Status.getUniqueID(),
+                         Status.getSize(),
+                         Status.getLastModificationTime(),
+                         *MaybeBuffer };
+  return std::move(*MaybeBuffer);
+}
+
+Expected<MappedBinaryCache::Buffer>
+getBinaryFromContext(const pipeline::Context &Ctx, StringRef Path) {
+  auto MaybeCache = Ctx.getExternalContext<MappedBinaryCache>(
+    MappedBinaryCacheName);
+  if (not MaybeCache) {
+    // Contexts not built by the PipelineManager have no cache
+    consumeError(MaybeCache.takeError());
+    return MappedBinaryCache::map(Path);
+  }
+
+  return (*MaybeCache)->get(Path);
+}
+
+} // namespace revng::pipes
@@ -52,12 +52,14 @@ public:
   void print(llvm::raw_ostream &OS) const { OS << ""; }
 };
 
-static Context setUpContext(LLVMContext &Context) {
+static Context setUpContext(LLVMContext &Context,
+                            MappedBinaryCache &Binaries) {
   const auto &ModelName = revng::ModelGlobalName;
   class Context Ctx;
 
   Ctx.addGlobal<revng::ModelGlobal>(ModelName);
   Ctx.addExternalContext("LLVMContext", Context);
+  Ctx.addExternalContext(MappedBinaryCacheName, Binaries);
   return Ctx;
 }
 
@@ -151,7 +153,8 @@ PipelineManager::createContexts(llvm::ArrayRef<std::string> EnablingFlags,
   PipelineManager Manager;
   Manager.ExecutionDirectory = ExecutionDirectory.str();
   Manager.Context = std::make_unique<llvm::LLVMContext>();
-  auto Ctx = setUpContext(*Manager.Context);
+  Manager.Binaries = std::make_unique<MappedBinaryCache>();
+  auto Ctx = setUpContext(*Manager.Context, *Manager.Binaries);
   Manager.PipelineContext = make_unique<pipeline::Context>(std::move(Ctx));
 
   auto Loader = setupLoader(*Manager.PipelineContext, EnablingFlags);
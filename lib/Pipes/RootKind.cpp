@@ -14,6 +14,7 @@
 #include "revng/Pipeline/Kind.h"
 #include "revng/Pipeline/Target.h"
 #include "revng/Pipes/Kinds.h"
+#include "revng/Pipes/ModelGlobal.h"
 #include "revng/Pipes/RootKind.h"
 #include "revng/Support/FunctionTags.h"
 #include "revng/TupleTree/Visits.h"
@@ -42,6 +43,22 @@ IsolatedRootKind::symbolToTarget(const llvm::Function &Symbol) const {
   return std::nullopt;
 }
 
+/// Check if the lifter would ignore \p Address if it was listed among the
+/// ExtraCodeAddresses of \p Model
+static bool isIgnoredByLift(const model::Binary &Model,
+                            const MetaAddress &Address) {
+  // JumpTargetManager::registerJT ignores addresses that are not executable
+  // without any side effect, so adding or removing them cannot change the
+  // lifted module
+  for (const auto &[Start, End] : Model.executableRanges()) {
+    if (Start.addressLowerThanOrEqual(Address)
+        and Address.addressLowerThan(End))
+      return false;
+  }
+
+  return true;
+}
+
 void RootKind::getInvalidations(const Context &Ctx,
                                 TargetsList &ToRemove,
                                 const GlobalTupleTreeDiff &Base) const {
@@ -53,10 +70,37 @@ void RootKind::getInvalidations(const Context &Ctx,
   const TupleTreePath ToCheck = *stringAsPath<model::Binary>("/ExtraCodeAddre"
                                                              "ss"
                                                              "es");
+  const TupleTreePath Segments = *stringAsPath<model::Binary>("/Segments");
+
+  // If the segments changed, the executable ranges in the current model do not
+  // tell us which addresses were executable before the diff
+  bool SegmentsChanged = llvm::any_of(Diff->Changes,
+                                      [&Segments](const auto &Entry) {
+                                        return Segments.isPrefixOf(Entry.Path);
+                                      });
+
+  const model::Binary &Model = *revng::getModelFromContext(Ctx);
+  auto AffectsLift = [&](const auto &Value) {
+    if (not Value.has_value())
+      return false;
 
-  bool RootChanged = llvm::any_of(Diff->Changes, [&ToCheck](const auto &Entry) {
+    const auto *Address = std::get_if<MetaAddress>(&*Value);
+    if (Address == nullptr or not Address->isValid() or SegmentsChanged)
+      return true;
+
+    return not isIgnoredByLift(Model, *Address);
+  };
+
+  bool RootChanged = llvm::any_of(Diff->Changes, [&](const auto &Entry) {
     const auto &[Path, Old, New] = Entry;
-    return ToCheck.isPrefixOf(Path);
+    if (not ToCheck.isPrefixOf(Path))
+      return false;
+
+    // Changes deeper than the set itself are not expected, be conservative
+    if (Path.size() != ToCheck.size())
+      return true;
+
+    return AffectsLift(Old) or AffectsLift(New);
   });
 
   if (RootChanged)
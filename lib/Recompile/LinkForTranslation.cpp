@@ -148,6 +148,7 @@ void appendTo(Container &&Range, auto &Destination) {
 
 static CommandList linkingArgs(const model::Binary &Model,
                                llvm::StringRef InputBinary,
+                               const llvm::MemoryBuffer &Buffer,
                                llvm::StringRef ObjectFile,
                                llvm::StringRef OutputBinary) {
   CommandList Result;
@@ -160,9 +161,6 @@ static CommandList linkingArgs(const model::Binary &Model,
                                                        "translation",
                                                        "");
 
-  auto MaybeBuffer = llvm::MemoryBuffer::getFileOrSTDIN(InputBinary);
-  revng_assert(MaybeBuffer);
-  llvm::MemoryBuffer &Buffer = **MaybeBuffer;
   RawBinaryView BinaryView(Model, Buffer.getBuffer());
 
   Command Linker("ld.bfd");
@@ -315,17 +313,36 @@ static CommandList linkingArgs(const model::Binary &Model,
   return Result;
 }
 
+static std::unique_ptr<llvm::MemoryBuffer> readBinary(llvm::StringRef Path) {
+  auto MaybeBuffer = llvm::MemoryBuffer::getFileOrSTDIN(Path);
+  revng_assert(MaybeBuffer);
+  return std::move(*MaybeBuffer);
+}
+
 void linkForTranslation(const model::Binary &Model,
                         llvm::StringRef InputBinary,
+                        const llvm::MemoryBuffer &InputBinaryBuffer,
                         llvm::StringRef ObjectFile,
                         llvm::StringRef OutputBinary) {
   CommandList Commands = linkingArgs(Model,
                                      InputBinary,
+                                     InputBinaryBuffer,
                                      ObjectFile,
                                      OutputBinary);
   Commands.run();
 }
 
+void linkForTranslation(const model::Binary &Model,
+                        llvm::StringRef InputBinary,
+                        llvm::StringRef ObjectFile,
+                        llvm::StringRef OutputBinary) {
+  linkForTranslation(Model,
+                     InputBinary,
+                     *readBinary(InputBinary),
+                     ObjectFile,
+                     OutputBinary);
+}
+
 void printLinkForTranslationCommands(llvm::raw_ostream &OS,
                                      const model::Binary &Model,
                                      llvm::StringRef InputBinary,
@@ -333,6 +350,7 @@ void printLinkForTranslationCommands(llvm::raw_ostream &OS,
                                      llvm::StringRef OutputBinary) {
   CommandList Commands = linkingArgs(Model,
                                      InputBinary,
+                                     *readBinary(InputBinary),
                                      ObjectFile,
                                      OutputBinary);
   Commands.print(OS);
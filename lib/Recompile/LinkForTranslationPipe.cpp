@@ -7,6 +7,7 @@
 //
 
 #include "revng/Pipeline/AllRegistries.h"
+#include "revng/Pipes/MappedBinaryCache.h"
 #include "revng/Pipes/ModelGlobal.h"
 #include "revng/Recompile/LinkForTranslation.h"
 #include "revng/Recompile/LinkForTranslationPipe.h"
@@ -25,8 +26,10 @@ void LinkForTranslation::run(const Context &Ctx,
     return;
 
   const model::Binary &Model = *getModelFromContext(Ctx);
+  auto Binary = cantFail(getBinaryFromContext(Ctx, *InputBinary.path()));
   linkForTranslation(Model,
                      *InputBinary.path(),
+                     *Binary,
                      *ObjectFile.path(),
                      OutputBinary.getOrCreatePath());
 }
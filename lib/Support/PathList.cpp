@@ -5,6 +5,7 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
 
 #include "revng/Support/Assert.h"
 #include "revng/Support/Debug.h"
@@ -97,3 +98,46 @@ findFileInPaths(llvm::StringRef FileName,
 std::optional<std::string> PathList::findFile(llvm::StringRef FileName) const {
   return findFileInPaths(FileName, SearchPaths);
 }
+
+std::optional<std::string> getCachePath(llvm::StringRef Directory,
+                                        llvm::StringRef FileName) {
+  llvm::SmallString<128> Result;
+  if (not llvm::sys::path::cache_directory(Result))
+    return std::nullopt;
+
+  llvm::sys::path::append(Result, "revng", Directory, FileName);
+  return Result.str().str();
+}
+
+llvm::Error writeFileAtomically(llvm::StringRef Path, llvm::StringRef Data) {
+  using namespace llvm;
+
+  StringRef Directory = sys::path::parent_path(Path);
+  if (std::error_code EC = sys::fs::create_directories(Directory))
+    return createFileError(Directory, EC);
+
+  int FD = -1;
+  SmallString<128> TemporaryPath;
+  auto Pattern = Path + "-%%%%%%";
+  if (auto EC = sys::fs::createUniqueFile(Pattern, FD, TemporaryPath))
+    return createFileError(Pattern, EC);
+
+  std::error_code EC;
+  {
+    raw_fd_ostream Stream(FD, true);
+    Stream << Data;
+    Stream.close();
+    EC = Stream.error();
+    Stream.clear_error();
+  }
+
+  if (not EC)
+    EC = sys::fs::rename(TemporaryPath, Path);
+
+  if (EC) {
+    sys::fs::remove(TemporaryPath);
+    return createFileError(Path, EC);
+  }
+
+  return Error::success();
+}
@@ -0,0 +1,215 @@
+/// \file CallGraphIndex.cpp
+/// \brief
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <algorithm>
+#include <cstdint>
+
+#include "llvm/ADT/STLExtras.h"
+
+#include "revng/Pipeline/Location.h"
+#include "revng/Pipes/Ranks.h"
+#include "revng/Yield/CallEdge.h"
+#include "revng/Yield/CrossRelations/CallGraphIndex.h"
+#include "revng/Yield/CrossRelations/CrossRelations.h"
+
+namespace CR = yield::crossrelations;
+
+CR::CallGraphIndex::CallGraphIndex(const model::Binary &Binary) {
+  Functions.reserve(Binary.Functions().size());
+  for (const model::Function &Function : Binary.Functions())
+    Functions.push_back(Function.Entry());
+
+  DynamicFunctions.reserve(Binary.ImportedDynamicFunctions().size());
+  for (const auto &Function : Binary.ImportedDynamicFunctions())
+    DynamicFunctions.push_back(Function.OriginalName());
+
+  Offsets.assign(Functions.size() + 1, 0);
+  Known.assign(Functions.size(), false);
+  Fingerprints.assign(Functions.size(), 0);
+  MissingFunctions = Functions.size();
+}
+
+bool CR::CallGraphIndex::hasSameNodes(const model::Binary &Binary) const {
+  if (Binary.Functions().size() != Functions.size()
+      or Binary.ImportedDynamicFunctions().size() != DynamicFunctions.size())
+    return false;
+
+  auto SameEntry = [](const model::Function &Function,
+                      const MetaAddress &Entry) {
+    return Function.Entry() == Entry;
+  };
+  auto SameName = [](const model::DynamicFunction &Function,
+                     const std::string &Name) {
+    return Function.OriginalName() == Name;
+  };
+  return std::equal(Binary.Functions().begin(),
+                    Binary.Functions().end(),
+                    Functions.begin(),
+                    SameEntry)
+         and std::equal(Binary.ImportedDynamicFunctions().begin(),
+                        Binary.ImportedDynamicFunctions().end(),
+                        DynamicFunctions.begin(),
+                        SameName);
+}
+
+std::optional<CR::CallGraphIndex::NodeID>
+CR::CallGraphIndex::functionID(const MetaAddress &Entry) const {
+  auto It = std::lower_bound(Functions.begin(), Functions.end(), Entry);
+  if (It == Functions.end() or *It != Entry)
+    return std::nullopt;
+  return It - Functions.begin();
+}
+
+std::optional<CR::CallGraphIndex::NodeID>
+CR::CallGraphIndex::dynamicFunctionID(llvm::StringRef Name) const {
+  auto Compare = [](const std::string &LHS, llvm::StringRef RHS) {
+    return llvm::StringRef(LHS) < RHS;
+  };
+  auto It = std::lower_bound(DynamicFunctions.begin(),
+                             DynamicFunctions.end(),
+                             Name,
+                             Compare);
+  if (It == DynamicFunctions.end() or *It != Name)
+    return std::nullopt;
+  return Functions.size() + (It - DynamicFunctions.begin());
+}
+
+void CR::CallGraphIndex::update(llvm::ArrayRef<const efa::FunctionMetadata *>
+                                  Metadata,
+                                llvm::ArrayRef<uint64_t> NewFingerprints) {
+  revng_assert(NewFingerprints.empty()
+               or NewFingerprints.size() == Metadata.size());
+  if (Metadata.empty())
+    return;
+
+  // Collect the new call sites of each function. If a function appears more
+  // than once, the last one wins.
+  constexpr uint32_t Unchanged = UINT32_MAX;
+  std::vector<CallSite> NewCallSites;
+  std::vector<uint32_t> NewBegin(Functions.size(), Unchanged);
+  std::vector<uint32_t> NewEnd(Functions.size(), Unchanged);
+  for (size_t I = 0; I < Metadata.size(); ++I) {
+    const efa::FunctionMetadata &FunctionMetadata = *Metadata[I];
+    std::optional<NodeID> Caller = functionID(FunctionMetadata.Entry());
+    revng_assert(Caller.has_value());
+
+    NewBegin[*Caller] = NewCallSites.size();
+    for (const auto &BasicBlock : FunctionMetadata.ControlFlowGraph()) {
+      for (const auto &Edge : BasicBlock.Successors()) {
+        auto *CallEdge = llvm::dyn_cast<efa::CallEdge>(Edge.get());
+        if (CallEdge == nullptr)
+          continue;
+
+        // Ignore non-call edges
+        if (not efa::FunctionEdgeType::isCall(Edge->Type()))
+          continue;
+
+        // TODO: embed information about the call instruction into the call
+        //       site after yield starts providing it.
+        std::optional<NodeID> Callee;
+        const auto &Destination = Edge->Destination();
+        if (Destination.isValid())
+          Callee = functionID(Destination.notInlinedAddress());
+        else if (not CallEdge->DynamicFunction().empty())
+          Callee = dynamicFunctionID(CallEdge->DynamicFunction());
+
+        // Ignore indirect calls and calls to unknown functions
+        if (Callee.has_value())
+          NewCallSites.push_back({ BasicBlock.ID(), *Callee });
+      }
+    }
+    NewEnd[*Caller] = NewCallSites.size();
+
+    if (not Known[*Caller]) {
+      Known[*Caller] = true;
+      --MissingFunctions;
+    }
+    Fingerprints[*Caller] = NewFingerprints.empty() ? 0 : NewFingerprints[I];
+  }
+
+  // Compute the new offsets: the replaced functions take the size of their
+  // new call sites, the others keep their current size
+  std::vector<uint32_t> MergedOffsets(Offsets.size(), 0);
+  for (NodeID Caller = 0; Caller < Functions.size(); ++Caller) {
+    uint32_t Size = NewBegin[Caller] != Unchanged ?
+                      NewEnd[Caller] - NewBegin[Caller] :
+                      Offsets[Caller + 1] - Offsets[Caller];
+    MergedOffsets[Caller + 1] = MergedOffsets[Caller] + Size;
+  }
+
+  // Fill the new call sites vector
+  std::vector<CallSite> MergedCallSites;
+  MergedCallSites.reserve(MergedOffsets.back());
+  for (NodeID Caller = 0; Caller < Functions.size(); ++Caller) {
+    if (NewBegin[Caller] != Unchanged) {
+      MergedCallSites.insert(MergedCallSites.end(),
+                             NewCallSites.begin() + NewBegin[Caller],
+                             NewCallSites.begin() + NewEnd[Caller]);
+    } else {
+      llvm::append_range(MergedCallSites, callSites(Caller));
+    }
+  }
+
+  Offsets = std::move(MergedOffsets);
+  CallSites = std::move(MergedCallSites);
+}
+
+CR::CrossRelations CR::CallGraphIndex::toCrossRelations() const {
+  namespace ranks = revng::ranks;
+
+  // Group the call sites by callee (i.e., transpose the CSR)
+  std::vector<uint32_t> CalleeOffsets(size() + 1, 0);
+  for (const CallSite &Site : CallSites)
+    ++CalleeOffsets[Site.Callee + 1];
+  for (size_t I = 1; I < CalleeOffsets.size(); ++I)
+    CalleeOffsets[I] += CalleeOffsets[I - 1];
+
+  struct IncomingCall {
+    NodeID Caller;
+    const CallSite *Site;
+  };
+  std::vector<IncomingCall> Incoming(CallSites.size());
+  std::vector<uint32_t> Next(CalleeOffsets.begin(), CalleeOffsets.end() - 1);
+  for (NodeID Caller = 0; Caller < Functions.size(); ++Caller)
+    for (const CallSite &Site : callSites(Caller))
+      Incoming[Next[Site.Callee]++] = { Caller, &Site };
+
+  // Only now produce the locations
+  CrossRelations Result;
+  auto Inserter = Result.Relations().batch_insert();
+  for (NodeID Node = 0; Node < size(); ++Node) {
+    std::string Location;
+    RelationType::Values Kind;
+    if (isFunction(Node)) {
+      Location = pipeline::location(ranks::Function, function(Node)).toString();
+      Kind = RelationType::IsCalledFrom;
+    } else {
+      Location = pipeline::location(ranks::DynamicFunction,
+                                    dynamicFunction(Node).str())
+                   .toString();
+      Kind = RelationType::IsDynamicallyCalledFrom;
+    }
+
+    SortedVector<RelationTarget> Related;
+    auto RelatedInserter = Related.batch_insert_or_assign();
+    for (uint32_t I = CalleeOffsets[Node]; I < CalleeOffsets[Node + 1]; ++I) {
+      const auto &[Caller, Site] = Incoming[I];
+      auto CallLocation = pipeline::location(ranks::BasicBlock,
+                                             Functions[Caller],
+                                             Site->Block);
+      RelationTarget Target(Kind, CallLocation.toString());
+      RelatedInserter.insert_or_assign(std::move(Target));
+    }
+    RelatedInserter.commit();
+
+    Inserter.insert(RelationDescription(std::move(Location),
+                                        std::move(Related)));
+  }
+  Inserter.commit();
+
+  return Result;
+}
@@ -5,10 +5,11 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
-#include <unordered_map>
+#include <algorithm>
+#include <limits>
 
-#include "llvm/ADT/BreadthFirstIterator.h"
-#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
 
 #include "revng/Yield/CallGraphs/CallGraphSlices.h"
 
@@ -16,94 +17,197 @@ using NodeView = const yield::Graph::Node *;
 
 static yield::Graph::Node *
 copyNode(yield::Graph &Graph, const yield::Graph::Node *Source) {
-  auto New = std::make_unique<yield::Graph::Node>(Source->data());
-  return Graph.addNode(std::move(New));
+  return Graph.addNode(Source->data());
 }
 
-/// \tparam NV local `NodeView` specialization
-/// \tparam INV inverted location `NodeView` specialization
-template<typename NV, typename INV>
-yield::Graph
-makeTreeImpl(const yield::Graph &Input, const BasicBlockID &SlicePoint) {
-  auto SlicePointPredicate = [&SlicePoint](NodeView Node) {
-    return Node->Address == SlicePoint;
+using SliceIndex = yield::calls::SliceIndex;
+
+/// Fills \p Offsets and \p Edges with the CSR representation of the
+/// transpose of the graph described by \p SourceOffsets and \p SourceEdges
+static void transpose(const std::vector<uint32_t> &SourceOffsets,
+                      const std::vector<SliceIndex::NodeID> &SourceEdges,
+                      std::vector<uint32_t> &Offsets,
+                      std::vector<SliceIndex::NodeID> &Edges) {
+  size_t NodeCount = SourceOffsets.size() - 1;
+  Offsets.assign(NodeCount + 1, 0);
+  for (SliceIndex::NodeID Target : SourceEdges)
+    ++Offsets[Target + 1];
+  for (size_t I = 1; I < Offsets.size(); ++I)
+    Offsets[I] += Offsets[I - 1];
+
+  Edges.resize(SourceEdges.size());
+  std::vector<uint32_t> Next(Offsets.begin(), Offsets.end() - 1);
+  for (SliceIndex::NodeID Source = 0; Source < NodeCount; ++Source)
+    for (uint32_t I = SourceOffsets[Source]; I < SourceOffsets[Source + 1]; ++I)
+      Edges[Next[SourceEdges[I]]++] = Source;
+}
+
+SliceIndex::SliceIndex(const yield::Graph &Input) {
+  llvm::DenseMap<NodeView, NodeID> IDs;
+  Nodes.reserve(Input.size());
+  Lookup.reserve(Input.size());
+  for (NodeView Node : Input.nodes()) {
+    IDs[Node] = Nodes.size();
+    Lookup.emplace_back(Node->Address, Nodes.size());
+    Nodes.push_back(Node);
+  }
+  llvm::sort(Lookup, [](const auto &LHS, const auto &RHS) {
+    return LHS.first < RHS.first;
+  });
+
+  SuccessorOffsets.reserve(Nodes.size() + 1);
+  SuccessorOffsets.push_back(0);
+  for (NodeView Node : Nodes) {
+    for (NodeView Successor : Node->successors())
+      Successors.push_back(IDs.lookup(Successor));
+    SuccessorOffsets.push_back(Successors.size());
+  }
+  transpose(SuccessorOffsets, Successors, PredecessorOffsets, Predecessors);
+}
+
+std::optional<SliceIndex::NodeID>
+SliceIndex::find(const BasicBlockID &Address) const {
+  auto Compare = [](const std::pair<BasicBlockID, NodeID> &Entry,
+                    const BasicBlockID &Address) {
+    return Entry.first < Address;
   };
-  auto Entry = llvm::find_if(Input.nodes(), SlicePointPredicate);
-  revng_assert(Entry != Input.nodes().end());
+  auto It = std::lower_bound(Lookup.begin(), Lookup.end(), Address, Compare);
+  if (It == Lookup.end() or It->first != Address)
+    return std::nullopt;
+  return It->second;
+}
+
+static yield::Graph makeTreeImpl(const SliceIndex &Index,
+                                 const BasicBlockID &SlicePoint,
+                                 SliceIndex::Direction Direction,
+                                 std::optional<unsigned> MaxDepth) {
+  using NodeID = SliceIndex::NodeID;
+  using Directions = SliceIndex::Direction;
+  auto Inverse = Direction == Directions::Callees ? Directions::Callers :
+                                                    Directions::Callees;
+
+  std::optional<NodeID> Entry = Index.find(SlicePoint);
+  revng_assert(Entry.has_value());
+
+  // Collect the nodes of the slice in breadth first order, stopping at
+  // `MaxDepth` calls from the entry. From now on, the nodes are identified by
+  // their position in `Order`.
+  constexpr uint32_t Missing = std::numeric_limits<uint32_t>::max();
+  llvm::DenseMap<NodeID, uint32_t> Positions;
+  std::vector<NodeID> Order = { *Entry };
+  Positions[*Entry] = 0;
+  size_t LevelEnd = Order.size();
+  unsigned Depth = 0;
+  for (size_t I = 0; I < Order.size(); ++I) {
+    if (I == LevelEnd) {
+      LevelEnd = Order.size();
+      ++Depth;
+    }
+
+    if (MaxDepth.has_value() and Depth >= *MaxDepth)
+      break;
+
+    for (NodeID Child : Index.children(Order[I], Direction)) {
+      if (Positions.try_emplace(Child, Order.size()).second)
+        Order.push_back(Child);
+    }
+  }
+
+  auto PositionOf = [&Positions](NodeID Node) -> uint32_t {
+    auto It = Positions.find(Node);
+    return It == Positions.end() ? Missing : It->second;
+  };
+
+  // Sort the slice in post order with an iterative depth first visit.
+  std::vector<uint32_t> PostOrder;
+  PostOrder.reserve(Order.size());
+  {
+    std::vector<bool> Visited(Order.size(), false);
+    std::vector<std::pair<uint32_t, size_t>> Stack = { { 0, 0 } };
+    Visited[0] = true;
+    while (not Stack.empty()) {
+      auto &[Node, NextChild] = Stack.back();
+      llvm::ArrayRef<NodeID> Children = Index.children(Order[Node], Direction);
+      if (NextChild == Children.size()) {
+        PostOrder.push_back(Node);
+        Stack.pop_back();
+        continue;
+      }
+
+      uint32_t Child = PositionOf(Children[NextChild++]);
+      if (Child != Missing and not Visited[Child]) {
+        Visited[Child] = true;
+        Stack.emplace_back(Child, 0);
+      }
+    }
+  }
 
   // Find the rank of each node, such that for any node its rank is equal to
-  // the highest rank among its children plus one.
-  llvm::ReversePostOrderTraversal ReversePostOrder(NV{ *Entry });
-  std::unordered_map<const yield::Graph::Node *, size_t> Ranks;
-  for (NodeView CurrentNode : ReversePostOrder) {
-    uint64_t &CurrentRank = Ranks[CurrentNode];
-
-    CurrentRank = 0;
-    for (auto Child : llvm::children<INV>(CurrentNode))
-      if (auto RankIterator = Ranks.find(Child); RankIterator != Ranks.end())
-        CurrentRank = std::max(RankIterator->second + 1, CurrentRank);
+  // the highest rank among its already ranked parents plus one.
+  std::vector<size_t> Ranks(Order.size(), 0);
+  {
+    std::vector<bool> Ranked(Order.size(), false);
+    for (uint32_t Node : llvm::reverse(PostOrder)) {
+      Ranked[Node] = true;
+      for (NodeID Parent : Index.children(Order[Node], Inverse)) {
+        uint32_t Position = PositionOf(Parent);
+        if (Position != Missing and Ranked[Position])
+          Ranks[Node] = std::max(Ranks[Position] + 1, Ranks[Node]);
+      }
+    }
   }
 
-  // For each node, select a single predecessor to keep connected to.
-  // The ranks calculated earlier are used to choose a specific one.
+  // For each node, select a single parent to keep connected to: the one with
+  // the highest possible rank that is still lower than the node's own rank.
   //
   // TODO: We should consider a better selection algorithm.
-  std::unordered_map<NodeView, NodeView> RealEdges;
-  for (NodeView Node : ReversePostOrder) {
-    auto NodeIt = Ranks.find(Node);
-    revng_assert(NodeIt != Ranks.end());
-
-    // Select the neighbour with the highest possible rank that is still
-    // lower than the current node's rank.
-    NodeView SelectedNeighbour = nullptr;
-    size_t SelectedNeighbourRank = 0;
-    for (NodeView Neighbour : llvm::children<INV>(Node)) {
-      if (auto Iterator = Ranks.find(Neighbour); Iterator != Ranks.end()) {
-        // If an inverse neighbour is not present in the `Ranks` table, it's not
-        // a part of the desired slice, as such we can safely ignore it.
-        size_t Rank = Iterator->second;
-        if (Rank < NodeIt->second && Rank >= SelectedNeighbourRank) {
-          SelectedNeighbour = Neighbour;
-          SelectedNeighbourRank = Rank;
-        }
+  std::vector<uint32_t> RealParents(Order.size(), Missing);
+  for (uint32_t Node = 0; Node < Order.size(); ++Node) {
+    size_t SelectedRank = 0;
+    for (NodeID Parent : Index.children(Order[Node], Inverse)) {
+      uint32_t Position = PositionOf(Parent);
+      if (Position == Missing)
+        continue;
+
+      size_t Rank = Ranks[Position];
+      if (Rank < Ranks[Node] and Rank >= SelectedRank) {
+        RealParents[Node] = Position;
+        SelectedRank = Rank;
       }
     }
-
-    auto [_, Success] = RealEdges.try_emplace(Node, SelectedNeighbour);
-    revng_assert(Success);
   }
 
   yield::Graph Result;
-  std::unordered_map<NodeView, yield::Graph::Node *> Lookup;
+  std::vector<yield::Graph::Node *> Copies(Order.size(), nullptr);
 
   // Returns the version of the node from the new graph if it exists,
   // or adds a new one to if it does not.
-  auto FindOrAddHelper = [&Result, &Lookup](NodeView OldNode) {
-    if (auto NewNode = Lookup.find(OldNode); NewNode != Lookup.end())
-      return NewNode->second;
-    else
-      return Lookup.emplace(OldNode, copyNode(Result, OldNode)).first->second;
+  auto FindOrAddHelper = [&](uint32_t Node) {
+    if (Copies[Node] == nullptr)
+      Copies[Node] = copyNode(Result, Index.node(Order[Node]));
+    return Copies[Node];
   };
 
   // Manually adding `Entry` to the result graphs guarantees that it's never
-  // empty. Since we only ever iterate on edges, this will guarantee that the
-  // produced graph is not emptry even in the cases where `Entry` has no edges.
-  Result.setEntryNode(FindOrAddHelper(*Entry));
+  // empty, even in the cases where `Entry` has no edges.
+  Result.setEntryNode(FindOrAddHelper(0));
 
   // Fill in the `Result` graph.
-  for (NodeView Node : llvm::breadth_first(NV{ *Entry })) {
-    for (auto Neighbour : llvm::children<INV>(Node)) {
-      if (Ranks.contains(Neighbour)) {
-        auto *NewNeighbour = FindOrAddHelper(Neighbour);
-        if (RealEdges.at(Node) == Neighbour) {
-          // Emit a real edge, if this is the neighbour selected earlier.
-          NewNeighbour->addSuccessor(FindOrAddHelper(Node));
-        } else {
-          // Emit a fake node otherwise.
-          auto NewNode = copyNode(Result, Node);
-          NewNode->NextAddress = NewNode->Address;
-          NewNeighbour->addSuccessor(NewNode);
-        }
+  for (uint32_t Node = 0; Node < Order.size(); ++Node) {
+    for (NodeID Parent : Index.children(Order[Node], Inverse)) {
+      uint32_t Position = PositionOf(Parent);
+      if (Position == Missing)
+        continue;
+
+      auto *NewParent = FindOrAddHelper(Position);
+      if (RealParents[Node] == Position) {
+        // Emit a real edge, if this is the parent selected earlier.
+        NewParent->addSuccessor(FindOrAddHelper(Node));
+      } else {
+        // Emit a fake node otherwise.
+        auto *Fake = copyNode(Result, Index.node(Order[Node]));
+        Fake->NextAddress = Fake->Address;
+        NewParent->addSuccessor(Fake);
       }
     }
   }
@@ -111,13 +215,20 @@ makeTreeImpl(const yield::Graph &Input, const BasicBlockID &SlicePoint) {
   return Result;
 }
 
-yield::Graph yield::calls::makeCalleeTree(const yield::Graph &Input,
-                                          const BasicBlockID &SlicePoint) {
-  // Forwards direction, makes sure no successor relation ever gets lost.
-  return makeTreeImpl<NodeView, llvm::Inverse<NodeView>>(Input, SlicePoint);
+yield::Graph yield::calls::makeCalleeTree(const SliceIndex &Index,
+                                          const BasicBlockID &SlicePoint,
+                                          std::optional<unsigned> MaxDepth) {
+  return makeTreeImpl(Index,
+                      SlicePoint,
+                      SliceIndex::Direction::Callees,
+                      MaxDepth);
 }
-yield::Graph yield::calls::makeCallerTree(const yield::Graph &Input,
-                                          const BasicBlockID &SlicePoint) {
-  // Backwards direction, makes sure no predecessor relation ever gets lost.
-  return makeTreeImpl<llvm::Inverse<NodeView>, NodeView>(Input, SlicePoint);
+
+yield::Graph yield::calls::makeCallerTree(const SliceIndex &Index,
+                                          const BasicBlockID &SlicePoint,
+                                          std::optional<unsigned> MaxDepth) {
+  return makeTreeImpl(Index,
+                      SlicePoint,
+                      SliceIndex::Direction::Callers,
+                      MaxDepth);
 }
@@ -8,10 +8,12 @@
 #include <unordered_map>
 
 #include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/raw_ostream.h"
 
 #include "revng/Model/Binary.h"
-#include "revng/PTML/Tag.h"
+#include "revng/PTML/TagWriter.h"
 #include "revng/Support/GraphAlgorithms.h"
 #include "revng/Yield/CallGraphs/CallGraphSlices.h"
 #include "revng/Yield/ControlFlow/Configuration.h"
@@ -23,7 +25,7 @@
 #include "revng/Yield/SVG.h"
 #include "revng/Yield/Support/SugiyamaStyleGraphLayout.h"
 
-using ptml::Tag;
+using ptml::TagWriter;
 
 namespace tags {
 
@@ -59,10 +61,11 @@ static std::string_view edgeTypeAsString(yield::Graph::EdgeType Type) {
 
 // clang-format off
 template <uintmax_t Numerator = 8, uintmax_t Denominator = 10>
-static std::string cubicBend(const yield::Graph::Point &From,
-                             const yield::Graph::Point &To,
-                             bool VerticalCurves,
-                             std::ratio<Numerator, Denominator> &&Bend = {}) {
+static void cubicBend(llvm::raw_ostream &OS,
+                      const yield::Graph::Point &From,
+                      const yield::Graph::Point &To,
+                      bool VerticalCurves,
+                      std::ratio<Numerator, Denominator> &&Bend = {}) {
   // clang-format on
 
   using Coordinate = yield::Graph::Coordinate;
@@ -75,75 +78,91 @@ static std::string cubicBend(const yield::Graph::Point &From,
   else
     YModifier = 0;
 
-  return llvm::formatv("C {0} {1} {2} {3} {4} {5} ",
-                       From.X + XModifier,
-                       -From.Y - YModifier,
-                       To.X - XModifier,
-                       -To.Y + YModifier,
-                       To.X,
-                       -To.Y);
+  OS << llvm::formatv("C {0} {1} {2} {3} {4} {5} ",
+                      From.X + XModifier,
+                      -From.Y - YModifier,
+                      To.X - XModifier,
+                      -To.Y + YModifier,
+                      To.X,
+                      -To.Y);
 }
 
-static std::string edge(const std::vector<yield::Graph::Point> &Path,
-                        const yield::Graph::EdgeType &Type,
-                        bool UseOrthogonalBends = true,
-                        bool UseVerticalCurves = false) {
-  std::string Points;
+static void edge(TagWriter &Writer,
+                 const std::vector<yield::Graph::Point> &Path,
+                 const yield::Graph::EdgeType &Type,
+                 bool UseOrthogonalBends = true,
+                 bool UseVerticalCurves = false) {
+  llvm::SmallString<256> Points;
+  llvm::raw_svector_ostream PointStream(Points);
 
   revng_assert(!Path.empty());
   const auto &First = Path.front();
-  Points += llvm::formatv("M {0} {1} ", First.X, -First.Y);
+  PointStream << llvm::formatv("M {0} {1} ", First.X, -First.Y);
 
   if (UseOrthogonalBends) {
     for (size_t Index = 1; Index < Path.size(); ++Index)
-      Points += llvm::formatv("L {0} {1} ", Path[Index].X, -Path[Index].Y);
+      PointStream << llvm::formatv("L {0} {1} ",
+                                   Path[Index].X,
+                                   -Path[Index].Y);
   } else {
     revng_assert(Path.size() >= 2);
     for (auto Iter = Path.begin(); Iter != std::prev(Path.end()); ++Iter)
-      Points += cubicBend(*Iter, *std::next(Iter), UseVerticalCurves);
+      cubicBend(PointStream, *Iter, *std::next(Iter), UseVerticalCurves);
   }
 
   revng_assert(!Points.empty());
   revng_assert(Points.back() == ' ');
   Points.pop_back(); // Remove an extra space at the end.
 
-  std::string Marker = llvm::formatv("url(#{0}-arrow-head)",
-                                     edgeTypeAsString(Type));
-  return Tag("path")
-    .addAttribute("class", std::string(edgeTypeAsString(Type)) += "-edge")
-    .addAttribute("d", std::move(Points))
-    .addAttribute("marker-end", std::move(Marker))
+  llvm::StringRef TypeName = edgeTypeAsString(Type);
+  auto Marker = Writer.save("url(#" + TypeName + "-arrow-head)");
+  Writer.tag("path")
+    .addAttribute("class", Writer.save(TypeName + "-edge"))
+    .addAttribute("d", Points.str())
+    .addAttribute("marker-end", Marker)
     .addAttribute("fill", "none")
-    .serialize();
+    .emit();
 }
 
-static std::string node(const yield::Node *Node,
-                        std::string &&Content,
-                        const yield::cfg::Configuration &Configuration) {
+template<typename CallableType>
+concept NodeExporter = requires(CallableType &&Callable,
+                                TagWriter &Writer,
+                                const yield::Graph::Node &Node) {
+  { Callable(Writer, Node) };
+};
+
+static void node(TagWriter &Writer,
+                 const yield::Node *Node,
+                 NodeExporter auto &&NodeContents,
+                 const yield::cfg::Configuration &Configuration) {
   yield::Graph::Size HalfSize{ Node->Size.W / 2, Node->Size.H / 2 };
   yield::Graph::Point TopLeft{ Node->Center.X - HalfSize.W,
                                -Node->Center.Y - HalfSize.H };
 
-  Tag Body("body", std::move(Content));
-  Body.addAttribute("xmlns", R"(http://www.w3.org/1999/xhtml)");
-
-  Tag Text("foreignObject", Body.serialize());
-  Text.addAttribute("class", ::tags::NodeContents)
-    .addAttribute("x", std::to_string(TopLeft.X))
-    .addAttribute("y", std::to_string(TopLeft.Y))
-    .addAttribute("width", std::to_string(Node->Size.W))
-    .addAttribute("height", std::to_string(Node->Size.H));
+  {
+    auto Text = Writer.tag("foreignObject")
+                  .addAttribute("class", ::tags::NodeContents)
+                  .addAttribute("x", std::to_string(TopLeft.X))
+                  .addAttribute("y", std::to_string(TopLeft.Y))
+                  .addAttribute("width", std::to_string(Node->Size.W))
+                  .addAttribute("height", std::to_string(Node->Size.H))
+                  .scope();
+    auto Body = Writer.tag("body")
+                  .addAttribute("xmlns", R"(http://www.w3.org/1999/xhtml)")
+                  .scope();
+    NodeContents(Writer, *Node);
+  }
 
-  Tag Border("rect");
-  Border.addAttribute("class", ::tags::NodeBody)
+  auto Rounding = std::to_string(Configuration.NodeCornerRoundingFactor);
+  Writer.tag("rect")
+    .addAttribute("class", ::tags::NodeBody)
     .addAttribute("x", std::to_string(TopLeft.X))
     .addAttribute("y", std::to_string(TopLeft.Y))
-    .addAttribute("rx", std::to_string(Configuration.NodeCornerRoundingFactor))
-    .addAttribute("ry", std::to_string(Configuration.NodeCornerRoundingFactor))
+    .addAttribute("rx", Rounding)
+    .addAttribute("ry", Rounding)
     .addAttribute("width", std::to_string(Node->Size.W))
-    .addAttribute("height", std::to_string(Node->Size.H));
-
-  return Text.serialize() + Border.serialize();
+    .addAttribute("height", std::to_string(Node->Size.H))
+    .emit();
 }
 
 struct Viewbox {
@@ -216,50 +235,44 @@ static Viewbox calculateViewbox(const yield::Graph &Graph) {
 /// (arrow origin the same as its tip), positive values shift arrow back,
 /// leaving some space between the tip and its target, negative values shift it
 /// closer to the target possibly causing an overlap.
-static std::string
-arrowHead(llvm::StringRef Name, float Size, float Concave, float Shift = 0) {
+static void arrowHead(TagWriter &Writer,
+                      llvm::StringRef Name,
+                      float Size,
+                      float Concave,
+                      float Shift = 0) {
   std::string Points = llvm::formatv("{0}, {1} {3}, {2} {0}, {0} {1}, {2}",
                                      "0",
                                      std::to_string(Size),
                                      std::to_string(Size / 2),
                                      std::to_string(Concave));
 
-  return Tag("marker",
-             Tag("polygon")
-               .addAttribute("points", std::move(Points))
-               .serialize())
-    .addAttribute("id", Name)
-    .addAttribute("markerWidth", std::to_string(Size))
-    .addAttribute("markerHeight", std::to_string(Size))
-    .addAttribute("refX", std::to_string(Size - Shift))
-    .addAttribute("refY", std::to_string(Size / 2))
-    .addAttribute("refY", std::to_string(Size / 2))
-    .addAttribute("orient", "auto")
-    .serialize();
+  auto Marker = Writer.tag("marker")
+                  .addAttribute("id", Name)
+                  .addAttribute("markerWidth", std::to_string(Size))
+                  .addAttribute("markerHeight", std::to_string(Size))
+                  .addAttribute("refX", std::to_string(Size - Shift))
+                  .addAttribute("refY", std::to_string(Size / 2))
+                  .addAttribute("orient", "auto")
+                  .scope();
+  Writer.tag("polygon").addAttribute("points", Points).emit();
 }
 
-static std::string
-duplicateArrowHeadsImpl(float Size, float Dip, float Shift = 0) {
-  return arrowHead(tags::UnconditionalArrowHead, Size, Dip, Shift)
-         + arrowHead(tags::CallArrowHead, Size, Dip, Shift)
-         + arrowHead(tags::TakenArrowHead, Size, Dip, Shift)
-         + arrowHead(tags::RefusedArrowHead, Size, Dip, Shift);
+static void
+duplicateArrowHeadsImpl(TagWriter &Writer, float Size, float Dip, float Shift) {
+  arrowHead(Writer, tags::UnconditionalArrowHead, Size, Dip, Shift);
+  arrowHead(Writer, tags::CallArrowHead, Size, Dip, Shift);
+  arrowHead(Writer, tags::TakenArrowHead, Size, Dip, Shift);
+  arrowHead(Writer, tags::RefusedArrowHead, Size, Dip, Shift);
 }
 
-static std::string
-defaultArrowHeads(const yield::cfg::Configuration &Configuration) {
+static void defaultArrowHeads(TagWriter &Writer,
+                              const yield::cfg::Configuration &Configuration) {
   if (Configuration.UseOrthogonalBends == true)
-    return duplicateArrowHeadsImpl(8, 3, 0);
+    duplicateArrowHeadsImpl(Writer, 8, 3, 0);
   else
-    return duplicateArrowHeadsImpl(8, 3, 2);
+    duplicateArrowHeadsImpl(Writer, 8, 3, 2);
 }
 
-template<typename CallableType>
-concept NodeExporter = requires(CallableType &&Callable,
-                                const yield::Graph::Node &Node) {
-  { Callable(Node) } -> convertible_to<std::string>;
-};
-
 constexpr bool isVertical(yield::sugiyama::LayoutOrientation Orientation) {
   return Orientation == yield::sugiyama::LayoutOrientation::TopToBottom
          || Orientation == yield::sugiyama::LayoutOrientation::BottomToTop;
@@ -276,27 +289,6 @@ static std::string exportGraph(const yield::Graph &Graph,
   if (Graph.size() == 0)
     return Result;
 
-  // Export all the edges.
-  for (const auto *From : Graph.nodes()) {
-    if (ShouldEmitEmptyNodes || From->Address.isValid()) {
-      for (const auto [To, Edge] : From->successor_edges()) {
-        if (ShouldEmitEmptyNodes || To->Address.isValid()) {
-          revng_assert(Edge != nullptr);
-          revng_assert(Edge->Status != yield::Graph::EdgeStatus::Unrouted);
-          Result += edge(Edge->Path,
-                         Edge->Type,
-                         Configuration.UseOrthogonalBends,
-                         isVertical(Orientation));
-        }
-      }
-    }
-  }
-
-  // Export all the nodes.
-  for (const auto *Node : Graph.nodes())
-    if (ShouldEmitEmptyNodes || Node->Address.isValid())
-      Result += node(Node, NodeContents(*Node), Configuration);
-
   Viewbox Box = calculateViewbox(Graph);
   std::string SerializedBox = llvm::formatv("{0} {1} {2} {3}",
                                             Box.TopLeft.X,
@@ -304,13 +296,48 @@ static std::string exportGraph(const yield::Graph &Graph,
                                             Box.BottomRight.X - Box.TopLeft.X,
                                             Box.BottomRight.Y - Box.TopLeft.Y);
 
-  Tag ArrowHeads("defs", defaultArrowHeads(Configuration));
-  return Tag("svg", ArrowHeads.serialize() + std::move(Result))
-    .addAttribute("xmlns", R"(http://www.w3.org/2000/svg)")
-    .addAttribute("viewbox", std::move(SerializedBox))
-    .addAttribute("width", std::to_string(Box.BottomRight.X - Box.TopLeft.X))
-    .addAttribute("height", std::to_string(Box.BottomRight.Y - Box.TopLeft.Y))
-    .serialize();
+  llvm::raw_string_ostream OS(Result);
+  {
+    TagWriter Writer(OS);
+    auto Width = std::to_string(Box.BottomRight.X - Box.TopLeft.X);
+    auto Height = std::to_string(Box.BottomRight.Y - Box.TopLeft.Y);
+    auto SVG = Writer.tag("svg")
+                 .addAttribute("xmlns", R"(http://www.w3.org/2000/svg)")
+                 .addAttribute("viewbox", SerializedBox)
+                 .addAttribute("width", Width)
+                 .addAttribute("height", Height)
+                 .scope();
+
+    {
+      auto ArrowHeads = Writer.tag("defs").scope();
+      defaultArrowHeads(Writer, Configuration);
+    }
+
+    // Export all the edges.
+    for (const auto *From : Graph.nodes()) {
+      if (ShouldEmitEmptyNodes || From->Address.isValid()) {
+        for (const auto [To, Edge] : From->successor_edges()) {
+          if (ShouldEmitEmptyNodes || To->Address.isValid()) {
+            revng_assert(Edge != nullptr);
+            revng_assert(Edge->Status != yield::Graph::EdgeStatus::Unrouted);
+            edge(Writer,
+                 Edge->Path,
+                 Edge->Type,
+                 Configuration.UseOrthogonalBends,
+                 isVertical(Orientation));
+          }
+        }
+      }
+    }
+
+    // Export all the nodes.
+    for (const auto *Node : Graph.nodes())
+      if (ShouldEmitEmptyNodes || Node->Address.isValid())
+        node(Writer, Node, NodeContents, Configuration);
+  }
+  OS.flush();
+
+  return Result;
 }
 
 std::string
@@ -327,13 +354,12 @@ yield::svg::controlFlowGraph(const yield::Function &InternalFunction,
   constexpr auto Orientation = yield::sugiyama::LayoutOrientation::TopToBottom;
   sugiyama::layout(Graph, Configuration, Orientation);
 
-  auto Content = [&](const yield::Graph::Node &Node) {
+  auto Content = [&](TagWriter &Writer, const yield::Graph::Node &Node) {
     if (Node.Address.isValid())
-      return yield::ptml::controlFlowNode(Node.Address,
-                                          InternalFunction,
-                                          Binary);
-    else
-      return std::string{};
+      yield::ptml::controlFlowNode(Writer,
+                                   Node.Address,
+                                   InternalFunction,
+                                   Binary);
   };
   return exportGraph<true>(Graph, Configuration, Orientation, Content);
 }
@@ -369,22 +395,21 @@ struct LabelNodeHelper {
     }
   }
 
-  std::string operator()(const yield::Graph::Node &Node) const {
+  void operator()(TagWriter &Writer, const yield::Graph::Node &Node) const {
     revng_assert(Node.Address.isValid());
     if (Node.NextAddress.isValid()) {
       revng_assert(Node.Address == Node.NextAddress);
-      return yield::ptml::shallowFunctionLink(Node.NextAddress
-                                                .notInlinedAddress(),
-                                              Binary);
+      yield::ptml::shallowFunctionLink(Writer,
+                                       Node.NextAddress.notInlinedAddress(),
+                                       Binary);
+      return;
     }
 
+    MetaAddress Entry = Node.Address.notInlinedAddress();
     if (!RootNodeLocation.has_value() || *RootNodeLocation == Node.Address)
-      return yield::ptml::functionNameDefinition(Node.Address
-                                                   .notInlinedAddress(),
-                                                 Binary);
+      yield::ptml::functionNameDefinition(Writer, Entry, Binary);
     else
-      return yield::ptml::functionLink(Node.Address.notInlinedAddress(),
-                                       Binary);
+      yield::ptml::functionLink(Writer, Entry, Binary);
   }
 };
 
@@ -412,7 +437,9 @@ std::string yield::svg::callGraph(const CrossRelations &Relations,
     Result.setEntryNode(EntryPoints.front());
   }
 
-  auto InternalGraph = calls::makeCalleeTree(Result);
+  const BasicBlockID &EntryAddress = Result.getEntryNode()->Address;
+  auto InternalGraph = calls::makeCalleeTree(calls::SliceIndex(Result),
+                                             EntryAddress);
   Helper.computeSizes(InternalGraph);
 
   sugiyama::layout(InternalGraph, Configuration, Orientation, Ranking, true);
@@ -503,6 +530,14 @@ static yield::Graph combineHalvesHelper(const BasicBlockID &SlicePoint,
 std::string yield::svg::callGraphSlice(const BasicBlockID &SlicePoint,
                                        const CrossRelations &Relations,
                                        const model::Binary &Binary) {
+  auto Graph = Relations.toYieldGraph();
+  return callGraphSlice(SlicePoint, calls::SliceIndex(Graph), Binary);
+}
+
+std::string yield::svg::callGraphSlice(const BasicBlockID &SlicePoint,
+                                       const calls::SliceIndex &Index,
+                                       const model::Binary &Binary,
+                                       std::optional<unsigned> MaxDepth) {
   // TODO: make configuration accessible from outside.
   auto Configuration = cfg::Configuration::getDefault();
   Configuration.UseOrthogonalBends = false;
@@ -512,8 +547,7 @@ std::string yield::svg::callGraphSlice(const BasicBlockID &SlicePoint,
   LabelNodeHelper Helper{ Binary, Configuration, SlicePoint };
 
   // Ready the forwards facing part of the slice
-  auto ForwardsGraph = calls::makeCalleeTree(Relations.toYieldGraph(),
-                                             SlicePoint);
+  auto ForwardsGraph = calls::makeCalleeTree(Index, SlicePoint, MaxDepth);
   for (auto *From : ForwardsGraph.nodes())
     for (auto [To, Label] : From->successor_edges())
       Label->Type = yield::Graph::EdgeType::Taken;
@@ -521,8 +555,7 @@ std::string yield::svg::callGraphSlice(const BasicBlockID &SlicePoint,
   sugiyama::layout(ForwardsGraph, Configuration, Orientation, Ranking, true);
 
   // Ready the backwards facing part of the slice
-  auto BackwardsGraph = calls::makeCallerTree(Relations.toYieldGraph(),
-                                              SlicePoint);
+  auto BackwardsGraph = calls::makeCallerTree(Index, SlicePoint, MaxDepth);
   for (auto *From : BackwardsGraph.nodes())
     for (auto [To, Label] : From->successor_edges())
       Label->Type = yield::Graph::EdgeType::Refused;
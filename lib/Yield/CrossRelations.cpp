@@ -6,12 +6,13 @@
 //
 
 #include <unordered_map>
+#include <vector>
 
 #include "revng/ADT/STLExtras.h"
 #include "revng/Model/Binary.h"
 #include "revng/Pipeline/Location.h"
 #include "revng/Pipes/Ranks.h"
-#include "revng/Yield/CallEdge.h"
+#include "revng/Yield/CrossRelations/CallGraphIndex.h"
 #include "revng/Yield/CrossRelations/CrossRelations.h"
 
 namespace CR = yield::crossrelations;
@@ -21,63 +22,15 @@ CR::CrossRelations::CrossRelations(const MetadataContainer &Metadata,
                                    const model::Binary &Binary) {
   revng_assert(Metadata.size() == Binary.Functions().size());
 
-  namespace ranks = revng::ranks;
-
-  // Make sure all the functions are present.
-  for (auto Inserter = Relations().batch_insert();
-       const auto &Function : Binary.Functions()) {
-    const auto Location = pipeline::location(ranks::Function, Function.Entry());
-    Inserter.insert(CR::RelationDescription(Location.toString(), {}));
-  }
+  std::vector<const efa::FunctionMetadata *> Functions;
+  Functions.reserve(Metadata.size());
+  for (const efa::FunctionMetadata &FunctionMetadata : Metadata)
+    Functions.push_back(&FunctionMetadata);
 
-  // Make sure all the dynamic functions are also present
-  for (auto Inserter = Relations().batch_insert();
-       const auto &Function : Binary.ImportedDynamicFunctions()) {
-    const auto Location = pipeline::location(ranks::DynamicFunction,
-                                             Function.OriginalName());
-    Inserter.insert(CR::RelationDescription(Location.toString(), {}));
-  }
+  CallGraphIndex Index(Binary);
+  Index.update(Functions);
 
-  for (const auto &[EntryAddress, ControlFlowGraph] : Metadata) {
-    for (const auto &BasicBlock : ControlFlowGraph) {
-      auto CallLocation = pipeline::location(ranks::BasicBlock,
-                                             EntryAddress,
-                                             BasicBlock.ID());
-
-      for (const auto &Edge : BasicBlock.Successors()) {
-        if (auto *CallEdge = llvm::dyn_cast<efa::CallEdge>(Edge.get())) {
-          if (efa::FunctionEdgeType::isCall(Edge->Type())) {
-            if (const auto &Callee = Edge->Destination(); Callee.isValid()) {
-              // TODO: embed information about the call instruction into
-              //       `CallLocation` after yield starts providing it.
-
-              auto CalleeAddress = Callee.notInlinedAddress();
-              auto L = pipeline::location(ranks::Function, CalleeAddress)
-                         .toString();
-              if (auto It = Relations().find(L); It != Relations().end()) {
-                CR::RelationTarget T(CR::RelationType::IsCalledFrom,
-                                     CallLocation.toString());
-                It->Related().insert(std::move(T));
-              }
-            } else if (!CallEdge->DynamicFunction().empty()) {
-              auto L = pipeline::location(ranks::DynamicFunction,
-                                          CallEdge->DynamicFunction())
-                         .toString();
-              if (auto It = Relations().find(L); It != Relations().end()) {
-                CR::RelationTarget T(CR::RelationType::IsDynamicallyCalledFrom,
-                                     CallLocation.toString());
-                It->Related().insert(std::move(T));
-              }
-            } else {
-              // Ignore indirect calls.
-            }
-          } else {
-            // Ignore non-call edges.
-          }
-        }
-      }
-    }
-  }
+  *this = Index.toCrossRelations();
 }
 
 template<typename AddNodeCallable, typename AddEdgeCallable>
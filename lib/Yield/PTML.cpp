@@ -5,11 +5,15 @@
 /// \file PTML.cpp
 /// \brief
 
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/raw_ostream.h"
+
 #include "revng/ADT/Concepts.h"
 #include "revng/EarlyFunctionAnalysis/ControlFlowGraph.h"
 #include "revng/Model/Binary.h"
 #include "revng/PTML/Constants.h"
 #include "revng/PTML/Tag.h"
+#include "revng/PTML/TagWriter.h"
 #include "revng/Pipeline/Location.h"
 #include "revng/Pipes/Ranks.h"
 #include "revng/Yield/ControlFlow/FallthroughDetection.h"
@@ -18,7 +22,7 @@
 
 using pipeline::serializedLocation;
 using ptml::str;
-using ptml::Tag;
+using ptml::TagWriter;
 namespace attributes = ptml::attributes;
 namespace ptmlScopes = ptml::scopes;
 namespace tags = ptml::tags;
@@ -59,9 +63,10 @@ static std::string labelAddress(const BasicBlockID &Address) {
   return Result;
 }
 
-static std::string label(const yield::BasicBlock &BasicBlock,
-                         const yield::Function &Function,
-                         const model::Binary &Binary) {
+static void label(TagWriter &Writer,
+                  const yield::BasicBlock &BasicBlock,
+                  const yield::Function &Function,
+                  const model::Binary &Binary) {
   std::string LabelName;
   std::string FunctionPath;
   std::string Location;
@@ -77,22 +82,22 @@ static std::string label(const yield::BasicBlock &BasicBlock,
   }
   using model::Architecture::getAssemblyLabelIndicator;
   auto LabelIndicator = getAssemblyLabelIndicator(Binary.Architecture());
-  Tag LabelTag(tags::Span, LabelName);
+  auto LabelTag = Writer.tag(tags::Span);
   LabelTag.addAttribute(attributes::Token, tokenTypes::Label)
     .addAttribute(attributes::LocationDefinition, Location);
   if (!FunctionPath.empty())
     LabelTag.addAttribute(attributes::ModelEditPath, FunctionPath);
+  LabelTag.emit(LabelName);
 
-  return LabelTag.serialize()
-         + Tag(tags::Span, LabelIndicator)
-             .addAttribute(attributes::Token, tokenTypes::LabelIndicator)
-             .serialize();
+  Writer.tag(tags::Span)
+    .addAttribute(attributes::Token, tokenTypes::LabelIndicator)
+    .emit(LabelIndicator);
 }
 
-static std::string indent() {
-  return Tag(tags::Span, "  ")
+static void indent(TagWriter &Writer) {
+  Writer.tag(tags::Span)
     .addAttribute(attributes::Token, ptml::tokens::Indentation)
-    .serialize();
+    .emit("  ");
 }
 
 static std::string targetPath(const BasicBlockID &Target,
@@ -157,7 +162,7 @@ static std::set<std::string> targets(const yield::BasicBlock &BasicBlock,
   return Result;
 }
 
-static std::string tagTypeAsString(const yield::TagType::Values &Type) {
+static llvm::StringRef tagTypeAsString(const yield::TagType::Values &Type) {
   switch (Type) {
   case yield::TagType::Immediate:
     return tokenTypes::ImmediateValue;
@@ -179,26 +184,26 @@ static std::string tagTypeAsString(const yield::TagType::Values &Type) {
   }
 }
 
-static std::string
-tokenTag(llvm::StringRef Buffer, const yield::TagType::Values &Tag) {
-  std::string TagStr = tagTypeAsString(Tag);
-  if (!TagStr.empty()) {
-    return ::Tag(tags::Span, Buffer)
-      .addAttribute(attributes::Token, TagStr)
-      .serialize();
-  } else {
-    return Buffer.str();
-  }
+static void tokenTag(TagWriter &Writer,
+                     llvm::StringRef Buffer,
+                     const yield::TagType::Values &Tag) {
+  llvm::StringRef TagStr = tagTypeAsString(Tag);
+  if (!TagStr.empty())
+    Writer.tag(tags::Span).addAttribute(attributes::Token, TagStr).emit(Buffer);
+  else
+    Writer.stream() << Buffer;
 }
 
-static std::string taggedText(const yield::Instruction &Instruction) {
+static void taggedText(TagWriter &Writer,
+                       const yield::Instruction &Instruction) {
   revng_assert(!Instruction.Tags().empty(),
                "Tagless instructions are not supported");
   revng_assert(!Instruction.Disassembled().empty(),
                "Empty disassembled instructions are not supported");
 
-  std::vector TagMap(Instruction.Disassembled().size(),
-                     yield::TagType::Invalid);
+  llvm::StringRef Text = Instruction.Disassembled();
+  llvm::SmallVector<yield::TagType::Values, 64> TagMap(Text.size(),
+                                                       yield::TagType::Invalid);
   for (yield::Tag Tag : Instruction.Tags()) {
     revng_assert(Tag.Type() != yield::TagType::Invalid,
                  "\"Invalid\" TagType encountered");
@@ -207,53 +212,50 @@ static std::string taggedText(const yield::Instruction &Instruction) {
     }
   }
 
-  std::string Result;
-  std::string Buffer;
+  // Emit each run of characters sharing the same tag type as a single token
+  size_t Start = 0;
   yield::TagType::Values Tag = yield::TagType::Invalid;
-  for (size_t Index = 0; Index < Instruction.Disassembled().size(); Index++) {
+  for (size_t Index = 0; Index < Text.size(); Index++) {
     if (Tag != TagMap[Index]) {
-      Result += tokenTag(Buffer, Tag);
+      tokenTag(Writer, Text.slice(Start, Index), Tag);
       Tag = TagMap[Index];
-      Buffer.clear();
+      Start = Index;
     }
-    Buffer += Instruction.Disassembled()[Index];
   }
-  Result += tokenTag(Buffer, Tag);
-
-  return Result;
+  tokenTag(Writer, Text.substr(Start), Tag);
 }
 
-static std::string instruction(const yield::Instruction &Instruction,
-                               const yield::BasicBlock &BasicBlock,
-                               const yield::Function &Function,
-                               const model::Binary &Binary,
-                               bool AddTargets = false) {
-
-  // Tagged instruction body.
-  std::string Result = taggedText(Instruction);
-  size_t Tail = Instruction.Disassembled().size() + 1;
-
-  Tag Location = Tag(tags::Span)
-                   .addAttribute(attributes::LocationDefinition,
-                                 serializedLocation(ranks::Instruction,
-                                                    Function.Entry(),
-                                                    BasicBlock.ID(),
-                                                    Instruction.Address()));
-  Tag Out = Tag(tags::Div, std::move(Result))
-              .addAttribute(attributes::Scope, scopes::Instruction);
-
+static void instruction(TagWriter &Writer,
+                        const yield::Instruction &Instruction,
+                        const yield::BasicBlock &BasicBlock,
+                        const yield::Function &Function,
+                        const model::Binary &Binary,
+                        bool AddTargets = false) {
+  Writer.tag(tags::Span)
+    .addAttribute(attributes::LocationDefinition,
+                  serializedLocation(ranks::Instruction,
+                                     Function.Entry(),
+                                     BasicBlock.ID(),
+                                     Instruction.Address()))
+    .emit();
+
+  auto Out = Writer.tag(tags::Div);
+  Out.addAttribute(attributes::Scope, scopes::Instruction);
   if (AddTargets) {
     auto Targets = targets(BasicBlock, Function, Binary);
     Out.addListAttribute(attributes::LocationReferences, Targets);
   }
 
-  return Location + Out;
+  // Tagged instruction body.
+  auto Scope = Out.scope();
+  taggedText(Writer, Instruction);
 }
 
-static std::string basicBlock(const yield::BasicBlock &BasicBlock,
-                              const yield::Function &Function,
-                              const model::Binary &Binary,
-                              std::string Label) {
+static void basicBlock(TagWriter &Writer,
+                       const yield::BasicBlock &BasicBlock,
+                       const yield::Function &Function,
+                       const model::Binary &Binary,
+                       bool EmitLabel) {
   revng_assert(!BasicBlock.Instructions().empty());
   auto FromIterator = BasicBlock.Instructions().begin();
   auto ToIterator = std::prev(BasicBlock.Instructions().end());
@@ -262,83 +264,98 @@ static std::string basicBlock(const yield::BasicBlock &BasicBlock,
     --ToIterator;
   }
 
-  std::string Result;
-  for (auto Iterator = FromIterator; Iterator != ToIterator; ++Iterator) {
-    Result += indent() + instruction(*Iterator, BasicBlock, Function, Binary)
-              + "\n";
-  }
-  Result += indent()
-            + instruction(*(ToIterator++), BasicBlock, Function, Binary, true)
-            + "\n";
+  auto Scope = Writer.tag(tags::Div)
+                 .addAttribute(attributes::Scope, scopes::BasicBlock)
+                 .scope();
 
-  std::string LabelString;
-  if (!Label.empty()) {
-    LabelString = Label + "\n";
+  if (EmitLabel) {
+    label(Writer, BasicBlock, Function, Binary);
+    Writer.stream() << "\n";
   } else {
-    std::string Location = serializedLocation(ranks::BasicBlock,
-                                              model::Function(Function.Entry())
-                                                .key(),
-                                              BasicBlock.ID());
-    LabelString = Tag(tags::Span)
-                    .addAttribute(attributes::LocationDefinition, Location)
-                    .serialize();
+    Writer.tag(tags::Span)
+      .addAttribute(attributes::LocationDefinition,
+                    serializedLocation(ranks::BasicBlock,
+                                       model::Function(Function.Entry()).key(),
+                                       BasicBlock.ID()))
+      .emit();
   }
 
-  return Tag(tags::Div, LabelString + Result)
-    .addAttribute(attributes::Scope, scopes::BasicBlock)
-    .serialize();
+  for (auto Iterator = FromIterator; Iterator != ToIterator; ++Iterator) {
+    indent(Writer);
+    instruction(Writer, *Iterator, BasicBlock, Function, Binary);
+    Writer.stream() << "\n";
+  }
+  indent(Writer);
+  instruction(Writer, *(ToIterator++), BasicBlock, Function, Binary, true);
+  Writer.stream() << "\n";
 }
 
+/// \return false if \p FirstBlock is part of another labeled block, in which
+///         case nothing is emitted
 template<bool ShouldMergeFallthroughTargets>
-static std::string labeledBlock(const yield::BasicBlock &FirstBlock,
-                                const yield::Function &Function,
-                                const model::Binary &Binary) {
-  std::string Result;
-  std::string Label = label(FirstBlock, Function, Binary);
-
+static bool labeledBlock(TagWriter &Writer,
+                         const yield::BasicBlock &FirstBlock,
+                         const yield::Function &Function,
+                         const model::Binary &Binary) {
   if constexpr (ShouldMergeFallthroughTargets == false) {
-    Result = basicBlock(FirstBlock, Function, Binary, std::move(Label)) + "\n";
+    basicBlock(Writer, FirstBlock, Function, Binary, true);
   } else {
     auto BasicBlocks = yield::cfg::labeledBlock(FirstBlock, Function, Binary);
     if (BasicBlocks.empty())
-      return "";
+      return false;
 
     bool IsFirst = true;
     for (const auto &BasicBlock : BasicBlocks) {
-      Result += basicBlock(*BasicBlock, Function, Binary, IsFirst ? Label : "");
+      basicBlock(Writer, *BasicBlock, Function, Binary, IsFirst);
       IsFirst = false;
     }
-    Result += "\n";
   }
 
+  Writer.stream() << "\n";
+  return true;
+}
+
+/// Runs \p Emitter on a TagWriter and returns what has been written
+template<typename CallableType>
+static std::string emitToString(CallableType &&Emitter) {
+  std::string Result;
+  llvm::raw_string_ostream OS(Result);
+  {
+    TagWriter Writer(OS);
+    Emitter(Writer);
+  }
+  OS.flush();
   return Result;
 }
 
 std::string yield::ptml::functionAssembly(const yield::Function &Function,
                                           const model::Binary &Binary) {
-  std::string Result;
+  return emitToString([&](TagWriter &Writer) {
+    auto Scope = Writer.tag(tags::Div)
+                   .addAttribute(attributes::Scope, scopes::Function)
+                   .scope();
+    for (const auto &BasicBlock : Function.ControlFlowGraph())
+      labeledBlock<true>(Writer, BasicBlock, Function, Binary);
+  });
+}
 
-  for (const auto &BasicBlock : Function.ControlFlowGraph()) {
-    Result += labeledBlock<true>(BasicBlock, Function, Binary);
-  }
+void yield::ptml::controlFlowNode(TagWriter &Writer,
+                                  const BasicBlockID &Address,
+                                  const yield::Function &Function,
+                                  const model::Binary &Binary) {
+  auto Iterator = Function.ControlFlowGraph().find(Address);
+  revng_assert(Iterator != Function.ControlFlowGraph().end());
 
-  using pipeline::serializedLocation;
-  namespace ranks = revng::ranks;
-  return ::Tag(tags::Div, Result)
-    .addAttribute(attributes::Scope, scopes::Function)
-    .serialize();
+  bool Emitted = labeledBlock<false>(Writer, *Iterator, Function, Binary);
+  revng_assert(Emitted);
 }
 
 std::string yield::ptml::controlFlowNode(const BasicBlockID &Address,
                                          const yield::Function &Function,
                                          const model::Binary &Binary) {
-  auto Iterator = Function.ControlFlowGraph().find(Address);
-  revng_assert(Iterator != Function.ControlFlowGraph().end());
-
-  auto Result = labeledBlock<false>(*Iterator, Function, Binary);
-  revng_assert(!Result.empty());
-
-  return Result;
+  return emitToString([&](TagWriter &Writer) {
+    controlFlowNode(Writer, Address, Function, Binary);
+  });
 }
 
 namespace callGraphTokens {
@@ -348,53 +365,78 @@ static constexpr auto ShallowNodeLabel = "call-graph.shallow-node-label";
 
 } // namespace callGraphTokens
 
-static Tag functionLinkHelper(const model::Function &Function,
-                              llvm::StringRef TokenAttributeValue) {
-  Tag Result(tags::Div, Function.name());
+using pipeline::serializedLocation;
+
+static void functionLinkHelper(TagWriter &Writer,
+                               const MetaAddress &FunctionEntryPoint,
+                               const model::Binary &Binary,
+                               llvm::StringRef TokenAttributeValue,
+                               bool IsDefinition) {
+  if (FunctionEntryPoint.isInvalid())
+    return;
+
+  const model::Function &Function = Binary.Functions().at(FunctionEntryPoint);
+  std::string Location = serializedLocation(revng::ranks::Function,
+                                            FunctionEntryPoint);
+
+  auto Result = Writer.tag(tags::Div);
   Result.addAttribute(attributes::Token, TokenAttributeValue);
+  if (IsDefinition)
+    Result.addAttribute(attributes::LocationDefinition, Location);
+  else
+    Result.addListAttribute(attributes::LocationReferences, Location);
+  Result.emit(Function.name());
+}
 
-  return Result;
+void yield::ptml::functionNameDefinition(TagWriter &Writer,
+                                         const MetaAddress &FunctionEntryPoint,
+                                         const model::Binary &Binary) {
+  functionLinkHelper(Writer,
+                     FunctionEntryPoint,
+                     Binary,
+                     callGraphTokens::NodeLabel,
+                     true);
 }
 
-using pipeline::serializedLocation;
+void yield::ptml::functionLink(TagWriter &Writer,
+                               const MetaAddress &FunctionEntryPoint,
+                               const model::Binary &Binary) {
+  functionLinkHelper(Writer,
+                     FunctionEntryPoint,
+                     Binary,
+                     callGraphTokens::NodeLabel,
+                     false);
+}
+
+void yield::ptml::shallowFunctionLink(TagWriter &Writer,
+                                      const MetaAddress &FunctionEntryPoint,
+                                      const model::Binary &Binary) {
+  functionLinkHelper(Writer,
+                     FunctionEntryPoint,
+                     Binary,
+                     callGraphTokens::ShallowNodeLabel,
+                     false);
+}
 
 std::string
 yield::ptml::functionNameDefinition(const MetaAddress &FunctionEntryPoint,
                                     const model::Binary &Binary) {
-  if (FunctionEntryPoint.isInvalid())
-    return "";
-
-  return functionLinkHelper(Binary.Functions().at(FunctionEntryPoint),
-                            callGraphTokens::NodeLabel)
-    .addAttribute(attributes::LocationDefinition,
-                  serializedLocation(revng::ranks::Function,
-                                     FunctionEntryPoint))
-    .serialize();
+  return emitToString([&](TagWriter &Writer) {
+    functionNameDefinition(Writer, FunctionEntryPoint, Binary);
+  });
 }
 
 std::string yield::ptml::functionLink(const MetaAddress &FunctionEntryPoint,
                                       const model::Binary &Binary) {
-  if (FunctionEntryPoint.isInvalid())
-    return "";
-
-  return functionLinkHelper(Binary.Functions().at(FunctionEntryPoint),
-                            callGraphTokens::NodeLabel)
-    .addListAttribute(attributes::LocationReferences,
-                      serializedLocation(revng::ranks::Function,
-                                         FunctionEntryPoint))
-    .serialize();
+  return emitToString([&](TagWriter &Writer) {
+    functionLink(Writer, FunctionEntryPoint, Binary);
+  });
 }
 
 std::string
 yield::ptml::shallowFunctionLink(const MetaAddress &FunctionEntryPoint,
                                  const model::Binary &Binary) {
-  if (FunctionEntryPoint.isInvalid())
-    return "";
-
-  return functionLinkHelper(Binary.Functions().at(FunctionEntryPoint),
-                            callGraphTokens::ShallowNodeLabel)
-    .addListAttribute(attributes::LocationReferences,
-                      serializedLocation(revng::ranks::Function,
-                                         FunctionEntryPoint))
-    .serialize();
+  return emitToString([&](TagWriter &Writer) {
+    shallowFunctionLink(Writer, FunctionEntryPoint, Binary);
+  });
 }
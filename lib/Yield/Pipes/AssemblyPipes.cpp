@@ -4,12 +4,13 @@
 
 #include "revng/EarlyFunctionAnalysis/FunctionMetadata.h"
 #include "revng/EarlyFunctionAnalysis/FunctionMetadataCache.h"
-#include "revng/Lift/LoadBinaryPass.h"
 #include "revng/Model/Binary.h"
+#include "revng/Model/RawBinaryView.h"
 #include "revng/Pipeline/AllRegistries.h"
 #include "revng/Pipeline/Pipe.h"
 #include "revng/Pipeline/RegisterPipe.h"
 #include "revng/Pipes/Kinds.h"
+#include "revng/Pipes/MappedBinaryCache.h"
 #include "revng/Pipes/ModelGlobal.h"
 #include "revng/Yield/Assembly/DisassemblyHelper.h"
 #include "revng/Yield/Function.h"
@@ -31,9 +32,9 @@ void ProcessAssembly::run(pipeline::Context &Context,
 
   // Access the binary
   revng_assert(SourceBinary.path().has_value());
-  auto MaybeBinary = loadBinary(*Model, *SourceBinary.path());
-  revng_assert(MaybeBinary);
-  const RawBinaryView &BinaryView = MaybeBinary->first;
+  auto Binary = llvm::cantFail(getBinaryFromContext(Context,
+                                                    *SourceBinary.path()));
+  const RawBinaryView BinaryView(*Model, Binary->getBuffer());
 
   // Access the llvm module
   const llvm::Module &Module = TargetList.getModule();
@@ -2,9 +2,15 @@
 // This file is distributed under the MIT License. See LICENSE.md for details.
 //
 
+#include <optional>
+#include <vector>
+
+#include "llvm/ADT/Hashing.h"
+
 #include "revng/EarlyFunctionAnalysis/FunctionMetadata.h"
 #include "revng/EarlyFunctionAnalysis/FunctionMetadataCache.h"
 #include "revng/Model/Binary.h"
+#include "revng/Model/IRHelpers.h"
 #include "revng/Pipeline/Location.h"
 #include "revng/Pipeline/Pipe.h"
 #include "revng/Pipeline/RegisterContainerFactory.h"
@@ -13,6 +19,8 @@
 #include "revng/Pipes/Kinds.h"
 #include "revng/Pipes/ModelGlobal.h"
 #include "revng/Pipes/TupleTreeContainer.h"
+#include "revng/Yield/CallGraphs/CallGraphSlices.h"
+#include "revng/Yield/CrossRelations/CallGraphIndex.h"
 #include "revng/Yield/CrossRelations/CrossRelations.h"
 #include "revng/Yield/Generated/ForwardDecls.h"
 #include "revng/Yield/Pipes/ProcessCallGraph.h"
@@ -31,16 +39,39 @@ void ProcessCallGraph::run(pipeline::Context &Context,
   // Access the llvm module
   const llvm::Module &Module = TargetList.getModule();
 
-  // Gather function metadata
-  SortedVector<efa::FunctionMetadata> Metadata;
-  for (const auto &LLVMFunction : FunctionTags::Isolated.functions(&Module))
-    Metadata.insert(*::detail::extractFunctionMetadata(&LLVMFunction));
+  // The call sites collected in the previous runs are still valid as long as
+  // the set of functions did not change
+  if (not Index.hasSameNodes(*Model))
+    Index = yield::crossrelations::CallGraphIndex(*Model);
+
+  // Collect the metadata of the functions whose metadata changed
+  std::vector<TupleTree<efa::FunctionMetadata>> Changed;
+  std::vector<const efa::FunctionMetadata *> ChangedMetadata;
+  std::vector<uint64_t> ChangedFingerprints;
+  for (const auto &LLVMFunction : FunctionTags::Isolated.functions(&Module)) {
+    auto *MD = LLVMFunction.getMetadata(FunctionMetadataMDName);
+    auto *YAML = llvm::cast<llvm::MDString>(MD->getOperand(0));
+    uint64_t Fingerprint = llvm::hash_value(YAML->getString());
+
+    auto ID = Index.functionID(getMetaAddressOfIsolatedFunction(LLVMFunction));
+    revng_assert(ID.has_value());
+    if (Index.isUpToDate(*ID, Fingerprint))
+      continue;
 
-  // If some functions are missing, do not output anything
-  if (Metadata.size() != Model->Functions().size())
+    Changed.push_back(::detail::extractFunctionMetadata(MD));
+    ChangedFingerprints.push_back(Fingerprint);
+  }
+
+  // Replace their call sites all at once
+  for (const TupleTree<efa::FunctionMetadata> &Metadata : Changed)
+    ChangedMetadata.push_back(&*Metadata);
+  Index.update(ChangedMetadata, ChangedFingerprints);
+
+  // If the call sites of some functions are unknown, do not output anything
+  if (not Index.isComplete())
     return;
 
-  OutputFile.emplace(Metadata, *Model);
+  OutputFile.emplace(Index.toCrossRelations());
 }
 
 void ProcessCallGraph::print(const pipeline::Context &,
@@ -71,10 +102,19 @@ void YieldCallGraph::print(const pipeline::Context &,
 void YieldCallGraphSlice::run(pipeline::Context &Context,
                               const pipeline::LLVMContainer &TargetList,
                               const CrossRelationsFileContainer &Relations,
-                              CallGraphSliceSVGStringMap &Output) {
+                              CallGraphSliceSVGStringMap &Output,
+                              int SliceDepth) {
   // Access the model
   const auto &Model = revng::getModelFromContext(Context);
 
+  // Build the indices on the call graph once for all the slices
+  auto Graph = Relations.get()->toYieldGraph();
+  yield::calls::SliceIndex Index(Graph);
+
+  std::optional<unsigned> MaxDepth;
+  if (SliceDepth > 0)
+    MaxDepth = SliceDepth;
+
   // Access the llvm module
   const llvm::Module &Module = TargetList.getModule();
   FunctionMetadataCache Cache;
@@ -87,8 +127,9 @@ void YieldCallGraphSlice::run(pipeline::Context &Context,
     BasicBlockID EntryID(Metadata.Entry());
     Output.insert_or_assign(Metadata.Entry(),
                             yield::svg::callGraphSlice(EntryID,
-                                                       *Relations.get(),
-                                                       *Model));
+                                                       Index,
+                                                       *Model,
+                                                       MaxDepth));
   }
 }
 
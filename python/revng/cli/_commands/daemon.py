@@ -34,6 +34,8 @@ REVNG_NOTIFY_FIFOS: list of fifo pipes to be notified of changes in the pipeline
   Event types that are available: begin, context
 REVNG_ORIGINS: comma-separated list of allowed CORS origins
 REVNG_C_API_TRACE_PATH: path to file to use to save api tracing, useful for debugging
+REVNG_C_API_TRACE_FORMAT: format of the api trace, either "yaml" (default) or "binary",
+  binary traces can be converted to YAML with `revng trace convert`
 
 Persistence:
 revng needs a directory to preserve progress across restarts, this is controlled
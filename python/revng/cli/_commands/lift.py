@@ -23,6 +23,7 @@ class LiftCommand(Command):
         parser.add_argument("--entry", type=str)
         parser.add_argument("--debug-info", type=str)
         parser.add_argument("--import-debug-info", type=str, action="append", default=[])
+        parser.add_argument("--avi-slice-radius", type=int)
 
     def run(self, options: Options):
         if options.remaining_args:
@@ -92,7 +93,12 @@ class LiftCommand(Command):
                 ]
                 + arg_or_empty(args, "external")
                 + arg_or_empty(args, "record_asm")
-                + arg_or_empty(args, "record_ptc"),
+                + arg_or_empty(args, "record_ptc")
+                + (
+                    [f"-avi-slice-radius={args.avi_slice_radius}"]
+                    if args.avi_slice_radius is not None
+                    else []
+                ),
                 options,
             )
         return 0
@@ -16,36 +16,44 @@ from collections import defaultdict
 import monotone_framework
 
 
-def gen_combine_values(lattice, reachability):
-    out = ""
-
-    # Emit the combine operator
-    out += """LatticeElement combineValues(const LatticeElement &LHS, const LatticeElement &RHS) {
-"""
+def compute_join_table(lattice, reachability):
+    """Returns a dictionary mapping each pair of distinct lattice elements to
+    their least upper bound"""
 
     def node_by_index(index):
         return monotone_framework.get_unique(
             [x for x, x_data in lattice.nodes(data=True) if x_data["index"] == str(index)]
         )
 
-    result = defaultdict(lambda: [])
+    def nonzero(i):
+        return {x[0] for x in enumerate(reachability[i]) if x[1] != 0}
+
+    join = {}
     for v1, v1_data in lattice.nodes(data=True):
         for v2, v2_data in lattice.nodes(data=True):
             if v1 != v2:
                 i1 = int(v1_data["index"])
                 i2 = int(v2_data["index"])
 
-                def nonzero(i):
-                    return {x[0] for x in enumerate(reachability[i]) if x[1] != 0}
-
                 output = max(
                     nonzero(i1) & nonzero(i2),
                     key=lambda i: reachability[i1][i] + reachability[i2][i],
                 )
-                output = node_by_index(output)
+                join[(v1, v2)] = node_by_index(output)
 
-                result[output].append((v1, v2))
-                assert output in result
+    return join
+
+
+def gen_combine_values(join_table):
+    out = ""
+
+    # Emit the combine operator
+    out += """LatticeElement combineValues(const LatticeElement &LHS, const LatticeElement &RHS) {
+"""
+
+    result = defaultdict(lambda: [])
+    for (v1, v2), output in join_table.items():
+        result[output].append((v1, v2))
 
     first = True
     for output, pairs in sorted(result.items(), key=lambda x: x[0]):
@@ -131,6 +139,94 @@ def gen_transfer_function(tf_names, transfer_functions):
     return out
 
 
+def gen_bit_sliced_lattice(lattice, reachability, join_table, tf_names, transfer_functions):
+    out = ""
+
+    values = list(lattice.nodes())
+
+    def plane(operand, value):
+        return f"{operand}[LatticeElement::{value}]"
+
+    def disjunction(terms, separator):
+        return separator.join(terms) if terms else "0"
+
+    # Emit the types of the bit-sliced representation
+    out += f"""// Bit-sliced representation of the lattice: a set of registers is represented
+// with a word for each lattice element (plane). The bit of a register is set in
+// exactly one of the planes, the one of its current lattice element. This way,
+// the lattice operations act on all the registers in a word at once.
+using Word = uint64_t;
+static constexpr unsigned PlanesCount = {len(values)};
+using Planes = std::array<Word, PlanesCount>;
+
+"""
+
+    # Emit the combine operator: the output plane of each element collects all
+    # the pairs of elements whose least upper bound is such element
+    out += """static Planes combinePlanes(const Planes &LHS, const Planes &RHS) {
+  Planes Result;
+"""
+    for output in values:
+        terms = [f"({plane('LHS', output)} & {plane('RHS', output)})"]
+        for (v1, v2), join in sorted(join_table.items()):
+            if join == output:
+                terms.append(f"({plane('LHS', v1)} & {plane('RHS', v2)})")
+        out += f"  {plane('Result', output)} = "
+        out += disjunction(terms, "\n    | ") + ";\n"
+    out += """  return Result;
+}
+
+"""
+
+    # Emit the comparison operator: collect the registers whose element in LHS
+    # is not less or equal than the one in RHS
+    out += """static Word notLessOrEqualPlanes(const Planes &LHS, const Planes &RHS) {
+  return """
+    terms = []
+    for v1, v1_data in lattice.nodes(data=True):
+        for v2, v2_data in lattice.nodes(data=True):
+            i1 = int(v1_data["index"])
+            i2 = int(v2_data["index"])
+            if v1 != v2 and reachability[i1][i2] == 0:
+                terms.append(f"({plane('LHS', v1)} & {plane('RHS', v2)})")
+    out += disjunction(terms, "\n    | ")
+    out += """;
+}
+
+"""
+
+    # Emit the transfer function: the output plane of each element collects the
+    # planes of the elements the transfer function maps to it
+    out += """static Planes transferPlanes(TransferFunction T, const Planes &E) {
+  switch(T) {
+"""
+    for tf in tf_names:
+        sources = defaultdict(lambda: [])
+        for source, destination in transfer_functions[tf]:
+            sources[destination].append(source)
+
+        assert set(source for source, _ in transfer_functions[tf]) == set(values)
+
+        out += f"""  case TransferFunction::{tf}: {{
+    Planes Result;
+"""
+        for output in values:
+            terms = [plane("E", source) for source in sorted(sources[output])]
+            out += f"    {plane('Result', output)} = {disjunction(terms, ' | ')};\n"
+        out += """    return Result;
+  }
+
+"""
+
+    out += """  default:
+    return E;
+  }
+}
+
+"""
+    return out
+
+
 def gen_lattice_element_enum(lattice):
     out = ""
 
@@ -185,6 +281,8 @@ def process_graph(path, call_arcs):
 
     tf_names = sorted([edge_data["label"] for _, _, edge_data in tf_graph.edges(data=True)])
 
+    join_table = compute_join_table(lattice, reachability)
+
     extremal_lattice_element = [
         v for v, v_data in lattice.nodes(data=True) if "peripheries" in v_data
     ][0]
@@ -196,8 +294,11 @@ def process_graph(path, call_arcs):
         "extremal_lattice_element": extremal_lattice_element,
         "transfer_function_enums": gen_transfer_function_enum(tf_graph),
         "is_less_or_equal_definition": gen_is_less_or_equal(lattice, reachability),
-        "combine_values_definition": gen_combine_values(lattice, reachability),
+        "combine_values_definition": gen_combine_values(join_table),
         "transfer_function_definition": gen_transfer_function(tf_names, transfer_functions),
+        "bit_sliced_lattice_definition": gen_bit_sliced_lattice(
+            lattice, reachability, join_table, tf_names, transfer_functions
+        ),
     }
 
 
@@ -219,6 +320,7 @@ def main():
                       - %isLessOrEqual% the C++ function with signature `bool isLessOrEqual(const LatticeElement &LHS, const LatticeElement &RHS)`
                       - %combineValues% the C++ function with signature `bool combineValues(const LatticeElement &LHS, const LatticeElement &RHS)`
                       - %transfer% the C++ function with signature `bool transfer(TransferFunction T, const LatticeElement &RHS)`
+                      - %BitSlicedLattice% the C++ definitions of the `Word` and `Planes` types and of the `combinePlanes`, `notLessOrEqualPlanes` and `transferPlanes` functions, operating on the bit-sliced representation of a set of lattice elements
                       """,  # noqa: E501
     )
     parser.add_argument("inputs", metavar="GRAPH", nargs="+", help="GraphViz input file.")
@@ -242,6 +344,7 @@ def main():
         .replace("%isLessOrEqual%", generated_code["is_less_or_equal_definition"])
         .replace("%combineValues%", generated_code["combine_values_definition"])
         .replace("%transfer%", generated_code["transfer_function_definition"])
+        .replace("%BitSlicedLattice%", generated_code["bit_sliced_lattice_definition"])
         .replace(
             "%GeneratedNotice%",
             "// This file has been automatically generated "
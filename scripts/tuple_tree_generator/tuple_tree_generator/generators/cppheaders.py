@@ -25,6 +25,7 @@ class CppHeadersGenerator:
         environment.filters["field_type"] = self.field_type
         environment.filters["fullname"] = self.fullname
         environment.filters["user_fullname"] = self.user_fullname
+        environment.filters["has_cached_hash"] = self.has_cached_hash
         self.enum_template = environment.get_template("enum.h.tpl")
         self.struct_template = environment.get_template("struct.h.tpl")
         self.struct_late_template = environment.get_template("struct_late.h.tpl")
@@ -230,6 +231,11 @@ class CppHeadersGenerator:
         assert field.resolved_type is not None
         return cls._cpp_type(field.resolved_type)
 
+    @staticmethod
+    def has_cached_hash(field: StructField):
+        # Scalar fields are cheap to compare, only cache the hash of the others
+        return isinstance(field.resolved_type, (StructDefinition, SequenceDefinition))
+
     @staticmethod
     def fullname(resolved_type: Definition):
         if isinstance(resolved_type, StructDefinition):
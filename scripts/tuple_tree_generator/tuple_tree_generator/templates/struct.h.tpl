@@ -12,6 +12,7 @@ The notice below applies to the generated files.
 
 #include <compare>
 
+#include "revng/TupleTree/CachedHash.h"
 #include "revng/TupleTree/TupleTreeReference.h"
 #include "revng/Support/Assert.h"
 
@@ -34,6 +35,9 @@ struct /*= struct | fullname =*/
 private:
   /*= field | field_type =*/ The/*= field.name =*/ = /*= field | field_type =*/{};
   static_assert(Yamlizable</*= field | field_type =*/>);
+  /**- if field | has_cached_hash **/
+  CachedHash The/*= field.name =*/Hash;
+  /**- endif **/
 
 public:
   using /*= field.name =*/Type = /*= field | field_type =*/;
@@ -44,8 +48,17 @@ public:
   }
 
   /*= field | field_type =*/ & /*= field.name =*/() {
+    /**- if field | has_cached_hash **/
+    The/*= field.name =*/Hash.reset();
+    /**- endif **/
     return The/*= field.name =*/;
   }
+  /**- if field | has_cached_hash **/
+
+  const CachedHash &cached/*= field.name =*/Hash() const {
+    return The/*= field.name =*/Hash;
+  }
+  /**- endif **/
   /**- endfor **/
 
   /*# --- Default constructor --- #*/
@@ -72,6 +72,19 @@ template <int I> auto &get(/*= struct.name =*/ &x) {
     return x./*= field.name =*/();
   /**- endfor **/
 }
+
+template <int I> const CachedHash *cachedHash(const /*= struct.name =*/ &x) {
+  if constexpr (false)
+    return nullptr;
+  /**- for field in struct.all_fields **/
+  else if constexpr (I == /*= loop.index0 =*/)
+    /**- if field | has_cached_hash **/
+    return &x.cached/*= field.name =*/Hash();
+    /**- else **/
+    return nullptr;
+    /**- endif **/
+  /**- endfor **/
+}
 }
 /*# --- End TupleLikeTraits --- -#*/
 
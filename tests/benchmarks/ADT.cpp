@@ -0,0 +1,231 @@
+/// \file ADT.cpp
+/// \brief Benchmarks of the containers in revng/ADT
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <random>
+#include <vector>
+
+#include "llvm/ADT/DepthFirstIterator.h"
+
+#include "revng/ADT/ConstantRangeSet.h"
+#include "revng/ADT/GenericGraph.h"
+#include "revng/ADT/LazySmallBitVector.h"
+#include "revng/ADT/MutableSet.h"
+#include "revng/ADT/SmallMap.h"
+#include "revng/ADT/SortedVector.h"
+#include "revng/ADT/ZipMapIterator.h"
+
+#include "Benchmark.h"
+#include "TestKeyedObject.h"
+
+using benchmark::doNotOptimize;
+using benchmark::Register;
+using benchmark::Run;
+
+/// \return \p Size distinct keys in a random (but deterministic) order
+static std::vector<uint64_t> shuffledKeys(uint64_t Size) {
+  std::vector<uint64_t> Result(Size);
+  for (uint64_t I = 0; I < Size; ++I)
+    Result[I] = I * 2;
+  std::shuffle(Result.begin(), Result.end(), std::mt19937_64(Size));
+  return Result;
+}
+
+template<typename Container>
+static Container makeContainer(uint64_t Size) {
+  Container Result;
+  auto Inserter = Result.batch_insert();
+  for (uint64_t Key : shuffledKeys(Size))
+    Inserter.insert(Element(Key, Key));
+  return Result;
+}
+
+template<typename Container>
+static void registerKeyedContainer(llvm::StringRef Prefix) {
+  std::string Name = "adt/" + Prefix.str();
+
+  Register(Name + "/insert", [](Run &R) {
+    auto Keys = shuffledKeys(R.size());
+    Container Result;
+    R.measure([&]() {
+      for (uint64_t Key : Keys)
+        Result.insert(Element(Key, Key));
+    });
+    doNotOptimize(Result.size());
+  });
+
+  Register(Name + "/batch-insert", [](Run &R) {
+    auto Keys = shuffledKeys(R.size());
+    Container Result;
+    R.measure([&]() {
+      auto Inserter = Result.batch_insert();
+      for (uint64_t Key : Keys)
+        Inserter.insert(Element(Key, Key));
+    });
+    doNotOptimize(Result.size());
+  });
+
+  Register(Name + "/lookup", [](Run &R) {
+    auto Keys = shuffledKeys(R.size());
+    auto Input = makeContainer<Container>(R.size());
+    R.measure([&]() {
+      uint64_t Found = 0;
+      // Half of the lookups miss
+      for (uint64_t Key : Keys)
+        Found += Input.count(Key) + Input.count(Key + 1);
+      doNotOptimize(Found);
+    });
+  });
+
+  Register(Name + "/iterate", [](Run &R) {
+    auto Input = makeContainer<Container>(R.size());
+    R.measure([&]() {
+      uint64_t Sum = 0;
+      for (const Element &E : Input)
+        Sum += E.value();
+      doNotOptimize(Sum);
+    });
+  });
+
+  Register(Name + "/zipmap", [](Run &R) {
+    // Two containers sharing half of the keys
+    auto Left = makeContainer<Container>(R.size());
+    Container Right;
+    {
+      auto Inserter = Right.batch_insert();
+      for (uint64_t Key : shuffledKeys(R.size()))
+        Inserter.insert(Element(Key + (Key % 4 == 0 ? 0 : 1), Key));
+    }
+
+    R.measure([&]() {
+      uint64_t Matching = 0;
+      for (const auto &[LHS, RHS] : zipmap_range(Left, Right))
+        Matching += LHS != nullptr and RHS != nullptr;
+      doNotOptimize(Matching);
+    });
+  });
+}
+
+[[maybe_unused]] static bool Registered = [] {
+  registerKeyedContainer<SortedVector<Element>>("sorted-vector");
+  registerKeyedContainer<MutableSet<Element>>("mutable-set");
+  return true;
+}();
+
+// SmallMap is meant for a handful of elements: insert and look up a few keys
+// many times, so that both the inline and the fallback storage are exercised
+static Register SmallMapInsert("adt/small-map/insert-lookup", [](Run &R) {
+  auto Keys = shuffledKeys(16);
+  R.measure([&]() {
+    uint64_t Found = 0;
+    for (uint64_t I = 0; I < R.size(); ++I) {
+      SmallMap<uint64_t, uint64_t, 8> Map;
+      for (uint64_t J = 0; J < (I % Keys.size()) + 1; ++J)
+        Map.insert({ Keys[J], J });
+      for (uint64_t Key : Keys)
+        Found += Map.count(Key);
+    }
+    doNotOptimize(Found);
+  });
+});
+
+static Register BitVectorSet("adt/lazy-small-bit-vector/set", [](Run &R) {
+  auto Indices = shuffledKeys(R.size());
+  LazySmallBitVector Result;
+  R.measure([&]() {
+    for (uint64_t Index : Indices)
+      Result.set(Index);
+  });
+  doNotOptimize(Result.requiredBits());
+});
+
+static void bitVectorLookup(Run &R) {
+  auto Indices = shuffledKeys(R.size());
+  LazySmallBitVector Input;
+  for (uint64_t Index : Indices)
+    if (Index % 3 == 0)
+      Input.set(Index);
+
+  R.measure([&]() {
+    uint64_t Set = 0;
+    for (uint64_t Index : Indices)
+      Set += Input[Index];
+    doNotOptimize(Set);
+  });
+}
+
+static Register BitVectorLookup("adt/lazy-small-bit-vector/lookup",
+                                bitVectorLookup);
+
+static Register RangeSetUnion("adt/constant-range-set/union", [](Run &R) {
+  using llvm::APInt;
+  std::vector<ConstantRangeSet> Ranges;
+  for (uint64_t Start : shuffledKeys(R.size()))
+    Ranges.emplace_back(llvm::ConstantRange(APInt(64, Start * 4),
+                                            APInt(64, Start * 4 + 3)));
+
+  R.measure([&]() {
+    ConstantRangeSet Result(64, false);
+    for (const ConstantRangeSet &Range : Ranges)
+      Result = Result.unionWith(Range);
+    doNotOptimize(Result.isEmptySet());
+  });
+});
+
+namespace {
+
+struct BenchmarkNode {
+  BenchmarkNode(uint64_t Index) : Index(Index) {}
+  uint64_t Index;
+};
+
+} // namespace
+
+using BenchmarkGraph = GenericGraph<BidirectionalNode<BenchmarkNode>>;
+
+static Register GraphBuild("adt/generic-graph/build", [](Run &R) {
+  std::mt19937_64 Generator(R.size());
+  BenchmarkGraph Graph;
+  R.measure([&]() {
+    std::vector<BenchmarkGraph::Node *> Nodes;
+    Nodes.reserve(R.size());
+    for (uint64_t I = 0; I < R.size(); ++I)
+      Nodes.push_back(Graph.addNode(I));
+
+    // A chain, plus two random edges for each node
+    for (uint64_t I = 0; I < R.size(); ++I) {
+      if (I + 1 < R.size())
+        Nodes[I]->addSuccessor(Nodes[I + 1]);
+      Nodes[I]->addSuccessor(Nodes[Generator() % R.size()]);
+      Nodes[I]->addSuccessor(Nodes[Generator() % R.size()]);
+    }
+    Graph.setEntryNode(Nodes[0]);
+  });
+  doNotOptimize(Graph.size());
+});
+
+static Register GraphVisit("adt/generic-graph/depth-first", [](Run &R) {
+  std::mt19937_64 Generator(R.size());
+  BenchmarkGraph Graph;
+  std::vector<BenchmarkGraph::Node *> Nodes;
+  for (uint64_t I = 0; I < R.size(); ++I)
+    Nodes.push_back(Graph.addNode(I));
+  for (uint64_t I = 0; I < R.size(); ++I) {
+    if (I + 1 < R.size())
+      Nodes[I]->addSuccessor(Nodes[I + 1]);
+    Nodes[I]->addSuccessor(Nodes[Generator() % R.size()]);
+  }
+  Graph.setEntryNode(Nodes[0]);
+
+  R.measure([&]() {
+    uint64_t Sum = 0;
+    for (BenchmarkGraph::Node *Node : llvm::depth_first(&Graph))
+      Sum += Node->Index;
+    for (BenchmarkGraph::Node *Node : Nodes)
+      Sum += Node->predecessorCount();
+    doNotOptimize(Sum);
+  });
+});
@@ -0,0 +1,106 @@
+#pragma once
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
+
+#include "revng/Support/Assert.h"
+
+namespace benchmark {
+
+/// \return the number of calls to the global operator new, in all of its
+///         variants, performed so far by the process
+///
+/// \note Allocations performed directly through malloc (e.g., by
+///       llvm::SmallVector) are not accounted.
+uint64_t allocations();
+
+/// Prevent the compiler from optimizing away the computation of \p Value
+template<typename T>
+inline void doNotOptimize(const T &Value) {
+  asm volatile("" : : "r,m"(Value) : "memory");
+}
+
+/// The measurements of a single repetition of a benchmark
+struct Sample {
+  std::chrono::nanoseconds Time;
+  uint64_t Allocations = 0;
+};
+
+/// The context of a single repetition of a benchmark.
+///
+/// The benchmark is free to prepare its inputs before calling measure, only the
+/// code executed by the callable passed to measure is accounted.
+class Run {
+private:
+  uint64_t Size = 0;
+  llvm::StringRef Input;
+  std::optional<Sample> Result;
+
+public:
+  Run(uint64_t Size, llvm::StringRef Input) : Size(Size), Input(Input) {}
+
+public:
+  /// The size of the synthetic input the benchmark should build
+  uint64_t size() const { return Size; }
+
+  /// The path of the input file, for benchmarks registered with TakesInputs
+  llvm::StringRef input() const { return Input; }
+
+  template<typename CallableType>
+  void measure(CallableType &&Callable) {
+    revng_assert(not Result.has_value(),
+                 "measure must be called once per repetition");
+
+    using Clock = std::chrono::steady_clock;
+    uint64_t StartAllocations = allocations();
+    auto Start = Clock::now();
+    Callable();
+    auto End = Clock::now();
+    uint64_t EndAllocations = allocations();
+
+    using std::chrono::duration_cast;
+    Result = Sample{ duration_cast<std::chrono::nanoseconds>(End - Start),
+                     EndAllocations - StartAllocations };
+  }
+
+  const std::optional<Sample> &result() const { return Result; }
+};
+
+struct Benchmark {
+  std::string Name;
+  std::function<void(Run &)> Body;
+
+  /// If true, the benchmark is run once for each input file passed on the
+  /// command line, instead of once for each size
+  bool TakesInputs = false;
+};
+
+std::vector<Benchmark> &registry();
+
+/// Register a benchmark at static initialization time
+///
+/// \code{.cpp}
+/// static benchmark::Register X("adt/sorted-vector/insert", [](Run &R) {
+///   auto Input = makeInput(R.size());
+///   R.measure([&]() { ... });
+/// });
+/// \endcode
+struct Register {
+  Register(llvm::StringRef Name,
+           std::function<void(Run &)> Body,
+           bool TakesInputs = false) {
+    registry().push_back({ Name.str(), std::move(Body), TakesInputs });
+  }
+};
+
+} // namespace benchmark
@@ -0,0 +1,157 @@
+/// \file Graphs.cpp
+/// \brief Benchmarks of GenericGraph on the graphs of the unit tests
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+
+#include "revng/ADT/GenericGraph.h"
+#include "revng/Support/CommandLine.h"
+#include "revng/UnitTestHelpers/DotGraphObject.h"
+
+#include "Benchmark.h"
+
+using benchmark::doNotOptimize;
+using benchmark::Register;
+using benchmark::Run;
+
+using namespace llvm::cl;
+
+static opt<std::string> TestGraphs("test-graphs",
+                                   desc("Directory of the .dot graphs the "
+                                        "graph benchmarks are built from"),
+                                   init(TEST_GRAPHS),
+                                   cat(MainCategory));
+
+namespace {
+
+/// A graph as a list of edges between node indices, node 0 is the entry
+struct EdgeList {
+  size_t NodesCount = 0;
+  std::vector<std::pair<size_t, size_t>> Edges;
+};
+
+struct GraphNode {
+  GraphNode(size_t Index) : Index(Index) {}
+  size_t Index;
+};
+
+struct GraphEdge {
+  uint64_t Weight = 0;
+};
+
+} // namespace
+
+/// Parse the .dot files in TestGraphs into a single EdgeList, in which the
+/// first node of each graph follows the last one of the previous graph
+static EdgeList parseTestGraphs() {
+  std::vector<std::string> Paths;
+  std::error_code EC;
+  for (llvm::sys::fs::directory_iterator It(TestGraphs, EC), End;
+       It != End and not EC;
+       It.increment(EC))
+    if (llvm::sys::path::extension(It->path()) == ".dot")
+      Paths.push_back(It->path());
+  revng_check(not EC and not Paths.empty(), "No .dot file in --test-graphs");
+  llvm::sort(Paths);
+
+  EdgeList Result;
+  for (const std::string &Path : Paths) {
+    DotGraph Graph;
+    Graph.parseDotFromFile(Path);
+
+    size_t Offset = Result.NodesCount;
+    std::map<const DotNode *, size_t> Indices;
+    size_t Index = Offset;
+    for (DotNode *Node : Graph.nodes())
+      Indices[Node] = Index++;
+
+    for (DotNode *Node : Graph.nodes())
+      for (DotNode *Successor : Node->successors())
+        Result.Edges.emplace_back(Indices.at(Node), Indices.at(Successor));
+
+    if (Offset != 0)
+      Result.Edges.emplace_back(Offset - 1, Offset);
+    Result.NodesCount += Graph.size();
+  }
+
+  return Result;
+}
+
+/// Repeat the test graphs, chained one after the other, until there are at
+/// least \p Size nodes
+static EdgeList makeInput(uint64_t Size) {
+  static const EdgeList TestGraphsList = parseTestGraphs();
+
+  EdgeList Result;
+  while (Result.NodesCount < Size) {
+    size_t Offset = Result.NodesCount;
+    for (const auto &[From, To] : TestGraphsList.Edges)
+      Result.Edges.emplace_back(Offset + From, Offset + To);
+    if (Offset != 0)
+      Result.Edges.emplace_back(Offset - 1, Offset);
+    Result.NodesCount += TestGraphsList.NodesCount;
+  }
+
+  return Result;
+}
+
+template<typename GraphType>
+static void build(GraphType &Graph, const EdgeList &Input) {
+  std::vector<typename GraphType::Node *> Nodes;
+  Nodes.reserve(Input.NodesCount);
+  for (size_t I = 0; I < Input.NodesCount; ++I)
+    Nodes.push_back(Graph.addNode(I));
+
+  for (const auto &[From, To] : Input.Edges)
+    Nodes[From]->addSuccessor(Nodes[To]);
+
+  Graph.setEntryNode(Nodes[0]);
+}
+
+template<typename GraphType>
+static void
+registerGraphBenchmarks(llvm::StringRef Name, GraphAllocation Allocation) {
+  std::string Prefix = "adt/generic-graph/test-graphs/" + Name.str();
+
+  Register(Prefix + "/build", [Allocation](Run &R) {
+    EdgeList Input = makeInput(R.size());
+    GraphType Graph(Allocation);
+    R.measure([&]() { build(Graph, Input); });
+    doNotOptimize(Graph.size());
+  });
+
+  Register(Prefix + "/rpo", [Allocation](Run &R) {
+    GraphType Graph(Allocation);
+    build(Graph, makeInput(R.size()));
+    R.measure([&]() {
+      size_t Sum = 0;
+      llvm::ReversePostOrderTraversal<GraphType *> RPOT(&Graph);
+      for (auto *Node : RPOT)
+        Sum += Node->Index;
+      doNotOptimize(Sum);
+    });
+  });
+}
+
+using BidirectionalGraph = GenericGraph<BidirectionalNode<GraphNode>>;
+using MutableEdgeGraph = GenericGraph<MutableEdgeNode<GraphNode, GraphEdge>>;
+
+[[maybe_unused]] static bool Registered = [] {
+  using BG = BidirectionalGraph;
+  using MG = MutableEdgeGraph;
+  registerGraphBenchmarks<BG>("bidirectional/heap", GraphAllocation::Heap);
+  registerGraphBenchmarks<BG>("bidirectional/arena", GraphAllocation::Arena);
+  registerGraphBenchmarks<MG>("mutable-edge/heap", GraphAllocation::Heap);
+  registerGraphBenchmarks<MG>("mutable-edge/arena", GraphAllocation::Arena);
+  return true;
+}();
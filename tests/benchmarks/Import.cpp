@@ -0,0 +1,31 @@
+/// \file Import.cpp
+/// \brief Benchmarks of the import of binaries and their debug information
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include "llvm/Support/Error.h"
+
+#include "revng/Model/Binary.h"
+#include "revng/Model/Importer/Binary/BinaryImporter.h"
+#include "revng/Model/Importer/Binary/Options.h"
+
+#include "Benchmark.h"
+
+using benchmark::doNotOptimize;
+using benchmark::Register;
+using benchmark::Run;
+
+// Run once for each binary passed on the command line. Whether DWARF or PDB
+// information is imported too depends on the usual importer options.
+static Register ImportBinary(
+  "import/binary",
+  [](Run &R) {
+    TupleTree<model::Binary> Model;
+    R.measure([&]() {
+      llvm::cantFail(importBinary(Model, R.input(), importerOptions()));
+    });
+    doNotOptimize(Model->Types().size());
+  },
+  true);
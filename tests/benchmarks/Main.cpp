@@ -0,0 +1,225 @@
+/// \file Main.cpp
+/// \brief Driver of the microbenchmarks, emits one JSON object per line
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/Regex.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "revng/Support/CommandLine.h"
+#include "revng/Support/InitRevng.h"
+
+#include "Benchmark.h"
+
+using namespace llvm;
+using namespace llvm::cl;
+
+static std::atomic<uint64_t> AllocationsCount = 0;
+
+uint64_t benchmark::allocations() {
+  return AllocationsCount.load(std::memory_order_relaxed);
+}
+
+std::vector<benchmark::Benchmark> &benchmark::registry() {
+  static std::vector<Benchmark> Registry;
+  return Registry;
+}
+
+static void *allocate(size_t Size) {
+  AllocationsCount.fetch_add(1, std::memory_order_relaxed);
+  if (void *Result = std::malloc(Size == 0 ? 1 : Size))
+    return Result;
+  throw std::bad_alloc();
+}
+
+static void *allocate(size_t Size, std::align_val_t Alignment) {
+  AllocationsCount.fetch_add(1, std::memory_order_relaxed);
+
+  // aligned_alloc requires the size to be a multiple of the alignment
+  size_t Align = static_cast<size_t>(Alignment);
+  size_t Rounded = (std::max<size_t>(Size, 1) + Align - 1) / Align * Align;
+  if (void *Result = std::aligned_alloc(Align, Rounded))
+    return Result;
+  throw std::bad_alloc();
+}
+
+// Count the allocations of the whole process. The aligned variants are used,
+// among others, by llvm::allocate_buffer and hence by BumpPtrAllocator. Note
+// that the nothrow variants forward to these ones.
+void *operator new(size_t Size) {
+  return allocate(Size);
+}
+
+void *operator new[](size_t Size) {
+  return allocate(Size);
+}
+
+void *operator new(size_t Size, std::align_val_t Alignment) {
+  return allocate(Size, Alignment);
+}
+
+void *operator new[](size_t Size, std::align_val_t Alignment) {
+  return allocate(Size, Alignment);
+}
+
+void operator delete(void *Pointer) noexcept {
+  std::free(Pointer);
+}
+
+void operator delete[](void *Pointer) noexcept {
+  std::free(Pointer);
+}
+
+void operator delete(void *Pointer, size_t) noexcept {
+  std::free(Pointer);
+}
+
+void operator delete[](void *Pointer, size_t) noexcept {
+  std::free(Pointer);
+}
+
+void operator delete(void *Pointer, std::align_val_t) noexcept {
+  std::free(Pointer);
+}
+
+void operator delete[](void *Pointer, std::align_val_t) noexcept {
+  std::free(Pointer);
+}
+
+void operator delete(void *Pointer, size_t, std::align_val_t) noexcept {
+  std::free(Pointer);
+}
+
+void operator delete[](void *Pointer, size_t, std::align_val_t) noexcept {
+  std::free(Pointer);
+}
+
+static list<uint64_t> Sizes("sizes",
+                            desc("Sizes of the synthetic inputs"),
+                            CommaSeparated,
+                            cat(MainCategory));
+
+static opt<unsigned> Repetitions("repetitions",
+                                 desc("How many times each benchmark is run"),
+                                 init(10),
+                                 cat(MainCategory));
+
+static opt<std::string> Filter("filter",
+                               desc("Only run the benchmarks whose name "
+                                    "matches this regular expression"),
+                               init(".*"),
+                               cat(MainCategory));
+
+static opt<bool> List("list",
+                      desc("List the available benchmarks and exit"),
+                      cat(MainCategory));
+
+static opt<std::string> OutputPath("o",
+                                   desc("Output file"),
+                                   init("-"),
+                                   cat(MainCategory));
+
+static list<std::string> Inputs(Positional,
+                                ZeroOrMore,
+                                desc("<input binaries>"),
+                                cat(MainCategory));
+
+static json::Object run(const benchmark::Benchmark &Benchmark,
+                        uint64_t Size,
+                        StringRef Input) {
+  using std::chrono::nanoseconds;
+  nanoseconds Total(0);
+  nanoseconds Min = nanoseconds::max();
+  nanoseconds Max(0);
+  uint64_t Allocations = 0;
+
+  for (unsigned I = 0; I < Repetitions; ++I) {
+    benchmark::Run Run(Size, Input);
+    Benchmark.Body(Run);
+    revng_check(Run.result().has_value(),
+                "The benchmark did not call measure");
+    const benchmark::Sample &Sample = *Run.result();
+    Total += Sample.Time;
+    Min = std::min(Min, Sample.Time);
+    Max = std::max(Max, Sample.Time);
+    Allocations += Sample.Allocations;
+  }
+
+  json::Object Result;
+  Result["Name"] = Benchmark.Name;
+  Result["Size"] = static_cast<int64_t>(Size);
+  if (not Input.empty())
+    Result["Input"] = Input.str();
+  Result["Repetitions"] = static_cast<int64_t>(Repetitions);
+  Result["MeanNanoseconds"] = static_cast<int64_t>(Total.count()
+                                                   / Repetitions);
+  Result["MinNanoseconds"] = static_cast<int64_t>(Min.count());
+  Result["MaxNanoseconds"] = static_cast<int64_t>(Max.count());
+  Result["MeanAllocations"] = static_cast<int64_t>(Allocations / Repetitions);
+  return Result;
+}
+
+int main(int argc, const char *argv[]) {
+  revng::InitRevng X(argc, argv);
+
+  HideUnrelatedOptions({ &MainCategory });
+  ParseCommandLineOptions(argc, argv);
+
+  if (Sizes.empty())
+    Sizes.push_back(1000);
+  for (uint64_t Size : Sizes)
+    revng_check(Size > 0);
+  revng_check(Repetitions > 0);
+
+  Regex Matcher(Filter);
+  std::string RegexError;
+  if (not Matcher.isValid(RegexError)) {
+    errs() << "Invalid filter: " << RegexError << "\n";
+    return EXIT_FAILURE;
+  }
+
+  std::error_code EC;
+  raw_fd_ostream Output(OutputPath, EC, sys::fs::OF_Text);
+  if (EC) {
+    errs() << "Cannot open " << OutputPath << ": " << EC.message() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  for (const benchmark::Benchmark &Benchmark : benchmark::registry()) {
+    if (not Matcher.match(Benchmark.Name))
+      continue;
+
+    if (List) {
+      Output << Benchmark.Name << "\n";
+      continue;
+    }
+
+    if (Benchmark.TakesInputs) {
+      for (const std::string &Input : Inputs) {
+        uint64_t Size = 0;
+        if (auto EC = sys::fs::file_size(Input, Size)) {
+          errs() << "Cannot open " << Input << ": " << EC.message() << "\n";
+          return EXIT_FAILURE;
+        }
+        Output << json::Value(run(Benchmark, Size, Input)) << "\n";
+      }
+    } else {
+      for (uint64_t Size : Sizes)
+        Output << json::Value(run(Benchmark, Size, "")) << "\n";
+    }
+
+    Output.flush();
+  }
+
+  return EXIT_SUCCESS;
+}
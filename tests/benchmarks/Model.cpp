@@ -0,0 +1,60 @@
+/// \file Model.cpp
+/// \brief Benchmarks of the passes transforming the model
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include "llvm/ADT/Twine.h"
+
+#include "revng/Model/Binary.h"
+#include "revng/Model/Pass/DeduplicateEquivalentTypes.h"
+#include "revng/TupleTree/TupleTree.h"
+
+#include "Benchmark.h"
+
+using benchmark::doNotOptimize;
+using benchmark::Register;
+using benchmark::Run;
+
+/// Build a model with about \p Size types, mimicking an import from many
+/// object files: the same few definitions are repeated over and over, half of
+/// them differing only in a typedef reachable from a cycle
+static TupleTree<model::Binary> makeDuplicatedTypes(uint64_t Size) {
+  TupleTree<model::Binary> Model;
+  Model->Architecture() = model::Architecture::x86_64;
+
+  using model::PrimitiveTypeKind::Generic;
+  model::TypePath Generic32 = Model->getPrimitiveType(Generic, 4);
+  auto Pointer = model::Qualifier::createPointer(8);
+
+  for (uint64_t I = 0; I < Size / 4; ++I) {
+    auto [Typedef, TypedefPath] = Model->makeType<model::TypedefType>();
+    Typedef.OriginalName() = "Leaf";
+    Typedef.UnderlyingType() = { Generic32, {} };
+    if (I % 2 == 0)
+      Typedef.UnderlyingType().Qualifiers().push_back(Pointer);
+
+    auto [Left, LeftPath] = Model->makeType<model::StructType>();
+    auto [Right, RightPath] = Model->makeType<model::StructType>();
+    Left.OriginalName() = "Left";
+    Right.OriginalName() = "Right";
+    Left.Fields()[0].Type() = { RightPath, { Pointer } };
+    Right.Fields()[0].Type() = { LeftPath, { Pointer } };
+    Right.Fields()[8].Type() = { TypedefPath, {} };
+
+    // A type outside of any cycle, with a few distinct definitions
+    auto [Plain, PlainPath] = Model->makeType<model::StructType>();
+    Plain.OriginalName() = ("plain_" + llvm::Twine(I % 16)).str();
+    Plain.Size() = 4;
+    Plain.Fields()[0].Type() = { Generic32, {} };
+  }
+
+  return Model;
+}
+
+static Register Deduplicate("model/deduplicate-equivalent-types", [](Run &R) {
+  auto Model = makeDuplicatedTypes(R.size());
+  R.measure([&]() { model::deduplicateEquivalentTypes(Model); });
+  doNotOptimize(Model->Types().size());
+});
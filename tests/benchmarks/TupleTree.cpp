@@ -0,0 +1,117 @@
+/// \file TupleTree.cpp
+/// \brief Benchmarks of serialization, deserialization and diffing of the
+///        model
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <string>
+
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/Error.h"
+
+#include "revng/Model/Binary.h"
+#include "revng/TupleTree/TupleTree.h"
+#include "revng/TupleTree/TupleTreeDiff.h"
+
+#include "Benchmark.h"
+
+using benchmark::doNotOptimize;
+using benchmark::Register;
+using benchmark::Run;
+
+static MetaAddress functionAddress(uint64_t Index) {
+  return MetaAddress(0x1000 + Index * 0x10, MetaAddressType::Code_x86_64);
+}
+
+/// Build a model with \p Size functions and \p Size / 4 structs of 4 fields
+static TupleTree<model::Binary> makeModel(uint64_t Size) {
+  TupleTree<model::Binary> Model;
+  Model->Architecture() = model::Architecture::x86_64;
+
+  for (uint64_t I = 0; I < Size; ++I) {
+    model::Function &Function = Model->Functions()[functionAddress(I)];
+    Function.CustomName() = ("function_" + llvm::Twine(I)).str();
+    Function.ExportedNames().insert(Function.CustomName().str().str());
+  }
+
+  using model::PrimitiveTypeKind::Generic;
+  model::TypePath Generic64 = Model->getPrimitiveType(Generic, 8);
+  for (uint64_t I = 0; I < Size / 4; ++I) {
+    auto [Struct, Path] = Model->makeType<model::StructType>();
+    Struct.OriginalName() = ("struct_" + llvm::Twine(I)).str();
+    Struct.Size() = 4 * 8;
+    for (uint64_t J = 0; J < 4; ++J) {
+      model::StructField &Field = Struct.Fields()[J * 8];
+      Field.CustomName() = ("field_" + llvm::Twine(J)).str();
+      Field.Type() = { Generic64, {} };
+    }
+  }
+
+  return Model;
+}
+
+/// Rename, remove and add one function out of a hundred
+static void mutate(model::Binary &Binary, uint64_t Size) {
+  for (uint64_t I = 0; I < Size; I += 100) {
+    Binary.Functions()[functionAddress(I)].CustomName() = "renamed";
+    if (I + 1 < Size)
+      Binary.Functions().erase(functionAddress(I + 1));
+    Binary.Functions()[functionAddress(Size + I)];
+  }
+}
+
+static Register Serialize("tuple-tree/serialize", [](Run &R) {
+  auto Model = makeModel(R.size());
+  std::string Buffer;
+  R.measure([&]() { Model.serialize(Buffer); });
+  doNotOptimize(Buffer.size());
+});
+
+static Register Deserialize("tuple-tree/deserialize", [](Run &R) {
+  std::string Buffer;
+  makeModel(R.size()).serialize(Buffer);
+  R.measure([&]() {
+    auto Model = TupleTree<model::Binary>::deserialize(Buffer);
+    revng_check(Model);
+    doNotOptimize((*Model)->Functions().size());
+  });
+});
+
+static Register CacheHashes("tuple-tree/cache-hashes", [](Run &R) {
+  auto Model = makeModel(R.size());
+  R.measure([&]() { Model.cacheHashes(); });
+});
+
+static Register PlainDiff("tuple-tree/diff", [](Run &R) {
+  auto Model = makeModel(R.size());
+  TupleTree<model::Binary> Changed = Model;
+  mutate(*Changed, R.size());
+  R.measure([&]() {
+    auto Result = diff(*Model, *Changed);
+    doNotOptimize(Result.Changes.size());
+  });
+});
+
+// Only the functions whose hash changed should be compared field by field
+static Register DiffCached("tuple-tree/diff-cached-hashes", [](Run &R) {
+  auto Model = makeModel(R.size());
+  Model.cacheHashes();
+  TupleTree<model::Binary> Changed = Model;
+  mutate(*Changed, R.size());
+  Changed.cacheHashes();
+  R.measure([&]() {
+    auto Result = diff(*Model, *Changed);
+    doNotOptimize(Result.Changes.size());
+  });
+});
+
+static Register Apply("tuple-tree/apply-diff", [](Run &R) {
+  auto Model = makeModel(R.size());
+  TupleTree<model::Binary> Changed = Model;
+  mutate(*Changed, R.size());
+  auto Changes = diff(*Model, *Changed);
+  R.measure([&]() { llvm::cantFail(Changes.apply(Model)); });
+  revng_check(Model->Functions().size() == Changed->Functions().size());
+});
@@ -0,0 +1,62 @@
+/// \file Yield.cpp
+/// \brief Benchmarks of the emission of PTML
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <algorithm>
+#include <string>
+
+#include "revng/Model/Binary.h"
+#include "revng/Yield/Function.h"
+#include "revng/Yield/PTML.h"
+
+#include "Benchmark.h"
+
+using benchmark::doNotOptimize;
+using benchmark::Register;
+using benchmark::Run;
+
+/// Build a function of \p Size instructions, in blocks of 8, with no edges
+static yield::Function makeFunction(const MetaAddress &Entry, uint64_t Size) {
+  constexpr uint64_t InstructionSize = 4;
+  constexpr uint64_t BlockSize = 8;
+
+  yield::Function Result;
+  Result.Entry() = Entry;
+  for (uint64_t Start = 0; Start < Size; Start += BlockSize) {
+    MetaAddress BlockAddress = Entry + Start * InstructionSize;
+    BasicBlockID ID(BlockAddress);
+    yield::BasicBlock &Block = Result.ControlFlowGraph()[ID];
+    Block.IsLabelAlwaysRequired() = true;
+
+    uint64_t End = std::min(Start + BlockSize, Size);
+    Block.End() = Entry + End * InstructionSize;
+    for (uint64_t I = Start; I < End; ++I) {
+      MetaAddress Address = Entry + I * InstructionSize;
+      yield::Instruction &Instruction = Block.Instructions()[Address];
+      Instruction.RawBytes() = { 0x48, 0x89, 0xd8, 0x90 };
+      Instruction.Disassembled() = "mov rax, 0x10";
+      Instruction.Tags().insert({ yield::TagType::Mnemonic, 0, 3 });
+      Instruction.Tags().insert({ yield::TagType::Register, 4, 7 });
+      Instruction.Tags().insert({ yield::TagType::Immediate, 9, 13 });
+    }
+  }
+
+  return Result;
+}
+
+// The number of allocations should not grow with the number of tags
+static Register FunctionAssembly("yield/ptml/function-assembly", [](Run &R) {
+  model::Binary Binary;
+  Binary.Architecture() = model::Architecture::x86_64;
+  MetaAddress Entry(0x400000, MetaAddressType::Code_x86_64);
+  Binary.Functions()[Entry].CustomName() = "benchmark";
+
+  yield::Function Function = makeFunction(Entry, R.size());
+  R.measure([&]() {
+    std::string Result = yield::ptml::functionAssembly(Function, Binary);
+    doNotOptimize(Result.size());
+  });
+});
@@ -0,0 +1,312 @@
+/// \file CallGraphIndex.cpp
+/// \brief Tests for the compact call graph CrossRelations are produced from
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define BOOST_TEST_MODULE CallGraphIndex
+bool init_unit_test();
+#include "boost/test/unit_test.hpp"
+
+#include "revng/EarlyFunctionAnalysis/FunctionMetadata.h"
+#include "revng/Model/Binary.h"
+#include "revng/Pipeline/Location.h"
+#include "revng/Pipes/Ranks.h"
+#include "revng/UnitTestHelpers/UnitTestHelpers.h"
+#include "revng/Yield/CrossRelations/CallGraphIndex.h"
+#include "revng/Yield/CrossRelations/CrossRelations.h"
+
+using yield::crossrelations::CallGraphIndex;
+using yield::crossrelations::CrossRelations;
+namespace RelationType = yield::crossrelations::RelationType;
+
+using EdgePointer = UpcastablePointer<efa::FunctionEdgeBase>;
+using BlockSuccessors = std::pair<uint64_t, std::vector<EdgePointer>>;
+
+static MetaAddress code(uint64_t Address) {
+  return MetaAddress::fromPC(llvm::Triple::x86_64, Address);
+}
+
+static BasicBlockID block(uint64_t Address) {
+  return BasicBlockID(code(Address));
+}
+
+static EdgePointer callTo(uint64_t Address) {
+  return EdgePointer::make<efa::CallEdge>(block(Address),
+                                          efa::FunctionEdgeType::FunctionCall);
+}
+
+static EdgePointer dynamicCallTo(llvm::StringRef Name) {
+  using namespace efa::FunctionEdgeType;
+  auto Result = EdgePointer::make<efa::CallEdge>(BasicBlockID::invalid(),
+                                                 FunctionCall);
+  llvm::cast<efa::CallEdge>(Result.get())->DynamicFunction() = Name.str();
+  return Result;
+}
+
+static EdgePointer indirectCall() {
+  return EdgePointer::make<efa::CallEdge>(BasicBlockID::invalid(),
+                                          efa::FunctionEdgeType::FunctionCall);
+}
+
+static std::string location(uint64_t Function, uint64_t Block) {
+  return pipeline::location(revng::ranks::BasicBlock,
+                            code(Function),
+                            block(Block))
+    .toString();
+}
+
+/// Describe the call sites of \p Function as "block -> callee" strings
+static std::multiset<std::string> describe(const CallGraphIndex &Index,
+                                           uint64_t Function) {
+  std::multiset<std::string> Result;
+  for (const CallGraphIndex::CallSite &Site :
+       Index.callSites(*Index.functionID(code(Function)))) {
+    std::string Callee;
+    if (Index.isFunction(Site.Callee))
+      Callee = Index.function(Site.Callee).toString();
+    else
+      Callee = Index.dynamicFunction(Site.Callee).str();
+    Result.insert(Site.Block.toString() + " -> " + Callee);
+  }
+  return Result;
+}
+
+static std::string callSite(uint64_t Block, uint64_t Callee) {
+  return block(Block).toString() + " -> " + code(Callee).toString();
+}
+
+static std::string callSite(uint64_t Block, llvm::StringRef Callee) {
+  return block(Block).toString() + " -> " + Callee.str();
+}
+
+struct Fixture {
+  TupleTree<model::Binary> Binary;
+
+  Fixture() {
+    Binary->Architecture() = model::Architecture::x86_64;
+    Binary->Functions()[code(0x3000)];
+    Binary->Functions()[code(0x1000)];
+    Binary->Functions()[code(0x2000)];
+    Binary->ImportedDynamicFunctions()["puts"];
+    Binary->ImportedDynamicFunctions()["abort"];
+  }
+
+  /// Metadata of the function at \p Entry, with a basic block for each
+  /// element of \p Blocks, paired with the edges leaving it
+  static efa::FunctionMetadata
+  metadata(uint64_t Entry, std::vector<BlockSuccessors> Blocks) {
+    efa::FunctionMetadata Result(code(Entry), {});
+    for (auto &[Address, Successors] : Blocks) {
+      efa::BasicBlock &Block = Result.ControlFlowGraph()[block(Address)];
+      for (EdgePointer &Successor : Successors)
+        Block.Successors().insert(std::move(Successor));
+    }
+    return Result;
+  }
+};
+
+BOOST_FIXTURE_TEST_CASE(NodesAreFunctionsThenDynamicFunctions, Fixture) {
+  CallGraphIndex Index(*Binary);
+  revng_check(Index.functionsCount() == 3);
+  revng_check(Index.size() == 5);
+
+  // Functions are sorted by entry address, dynamic functions by name
+  revng_check(*Index.functionID(code(0x1000)) == 0);
+  revng_check(*Index.functionID(code(0x2000)) == 1);
+  revng_check(*Index.functionID(code(0x3000)) == 2);
+  revng_check(*Index.dynamicFunctionID("abort") == 3);
+  revng_check(*Index.dynamicFunctionID("puts") == 4);
+
+  revng_check(not Index.functionID(code(0x4000)).has_value());
+  revng_check(not Index.dynamicFunctionID("exit").has_value());
+}
+
+BOOST_FIXTURE_TEST_CASE(UpdateCollectsTheCallSites, Fixture) {
+  CallGraphIndex Index(*Binary);
+  std::vector<EdgePointer> FirstBlock;
+  FirstBlock.push_back(callTo(0x2000));
+  std::vector<EdgePointer> SecondBlock;
+  SecondBlock.push_back(dynamicCallTo("puts"));
+  SecondBlock.push_back(indirectCall());
+  SecondBlock.push_back(callTo(0x5000));
+  Index.update(metadata(0x1000,
+                        { { 0x1000, std::move(FirstBlock) },
+                          { 0x1010, std::move(SecondBlock) } }));
+
+  // Indirect calls and calls to unknown functions are ignored
+  std::multiset<std::string> Expected = { callSite(0x1000, 0x2000),
+                                          callSite(0x1010, "puts") };
+  revng_check(describe(Index, 0x1000) == Expected);
+  revng_check(Index.callSites(*Index.functionID(code(0x2000))).empty());
+}
+
+BOOST_FIXTURE_TEST_CASE(UpdateReplacesTheCallSites, Fixture) {
+  CallGraphIndex Index(*Binary);
+  auto Update = [&Index](uint64_t Entry,
+                         uint64_t Block,
+                         std::vector<uint64_t> Callees) {
+    std::vector<EdgePointer> Successors;
+    for (uint64_t Callee : Callees)
+      Successors.push_back(callTo(Callee));
+    Index.update(metadata(Entry, { { Block, std::move(Successors) } }));
+  };
+
+  Update(0x1000, 0x1000, { 0x2000 });
+  Update(0x2000, 0x2000, { 0x3000 });
+  Update(0x3000, 0x3000, { 0x1000 });
+
+  // Grow the call sites of the first function, the ones of the following
+  // functions must be preserved
+  Update(0x1000, 0x1010, { 0x2000, 0x3000 });
+  std::multiset<std::string> First = { callSite(0x1010, 0x2000),
+                                       callSite(0x1010, 0x3000) };
+  revng_check(describe(Index, 0x1000) == First);
+  std::multiset<std::string> Second = { callSite(0x2000, 0x3000) };
+  revng_check(describe(Index, 0x2000) == Second);
+  std::multiset<std::string> Third = { callSite(0x3000, 0x1000) };
+  revng_check(describe(Index, 0x3000) == Third);
+
+  // Shrink them
+  Update(0x1000, 0x1000, {});
+  revng_check(describe(Index, 0x1000).empty());
+  revng_check(describe(Index, 0x2000) == Second);
+  revng_check(describe(Index, 0x3000) == Third);
+}
+
+BOOST_FIXTURE_TEST_CASE(BatchUpdateReplacesOnlyTheGivenFunctions, Fixture) {
+  auto Calls = [](uint64_t Entry, uint64_t Callee) {
+    std::vector<EdgePointer> Successors;
+    Successors.push_back(callTo(Callee));
+    return metadata(Entry, { { Entry, std::move(Successors) } });
+  };
+
+  // Build the whole graph at once
+  CallGraphIndex Index(*Binary);
+  efa::FunctionMetadata First = Calls(0x1000, 0x2000);
+  efa::FunctionMetadata Second = Calls(0x2000, 0x3000);
+  efa::FunctionMetadata Third = Calls(0x3000, 0x1000);
+  std::vector<const efa::FunctionMetadata *> All = { &Third, &First, &Second };
+  Index.update(All);
+  revng_check(Index.isComplete());
+
+  // Replace the first and the last function, the second one is preserved
+  efa::FunctionMetadata NewFirst = metadata(0x1000, {});
+  efa::FunctionMetadata NewThird = Calls(0x3000, 0x2000);
+  std::vector<const efa::FunctionMetadata *> Some = { &NewFirst, &NewThird };
+  Index.update(Some);
+
+  revng_check(describe(Index, 0x1000).empty());
+  std::multiset<std::string> Expected = { callSite(0x2000, 0x3000) };
+  revng_check(describe(Index, 0x2000) == Expected);
+  Expected = { callSite(0x3000, 0x2000) };
+  revng_check(describe(Index, 0x3000) == Expected);
+
+  // If a function appears more than once, the last one wins
+  std::vector<const efa::FunctionMetadata *> Twice = { &First, &NewFirst };
+  Index.update(Twice);
+  revng_check(describe(Index, 0x1000).empty());
+  revng_check(describe(Index, 0x3000) == Expected);
+}
+
+BOOST_FIXTURE_TEST_CASE(FingerprintsTrackTheMetadata, Fixture) {
+  CallGraphIndex Index(*Binary);
+  auto ID = *Index.functionID(code(0x1000));
+  revng_check(not Index.isUpToDate(ID, 42));
+
+  Index.update(metadata(0x1000, {}), 42);
+  revng_check(Index.isUpToDate(ID, 42));
+  revng_check(not Index.isUpToDate(ID, 43));
+
+  // Metadata without a fingerprint is never up to date
+  Index.update(metadata(0x1000, {}));
+  revng_check(not Index.isUpToDate(ID, 0));
+  revng_check(not Index.isUpToDate(ID, 42));
+}
+
+BOOST_FIXTURE_TEST_CASE(NodesChangeWithTheFunctions, Fixture) {
+  CallGraphIndex Index(*Binary);
+  revng_check(Index.hasSameNodes(*Binary));
+  revng_check(not CallGraphIndex().hasSameNodes(*Binary));
+
+  Binary->Functions()[code(0x4000)];
+  revng_check(not Index.hasSameNodes(*Binary));
+
+  Binary->Functions().erase(code(0x4000));
+  revng_check(Index.hasSameNodes(*Binary));
+
+  Binary->ImportedDynamicFunctions()["exit"];
+  revng_check(not Index.hasSameNodes(*Binary));
+}
+
+BOOST_FIXTURE_TEST_CASE(CompleteOnceAllFunctionsAreKnown, Fixture) {
+  CallGraphIndex Index(*Binary);
+  revng_check(not Index.isComplete());
+
+  Index.update(metadata(0x1000, {}));
+  Index.update(metadata(0x2000, {}));
+  revng_check(not Index.isComplete());
+
+  // Updating a function twice does not count it twice
+  Index.update(metadata(0x2000, {}));
+  revng_check(not Index.isComplete());
+
+  Index.update(metadata(0x3000, {}));
+  revng_check(Index.isComplete());
+}
+
+BOOST_FIXTURE_TEST_CASE(CrossRelationsGroupTheCallersByCallee, Fixture) {
+  CallGraphIndex Index(*Binary);
+  std::vector<EdgePointer> FirstBlock;
+  FirstBlock.push_back(callTo(0x3000));
+  std::vector<EdgePointer> SecondBlock;
+  SecondBlock.push_back(dynamicCallTo("abort"));
+  Index.update(metadata(0x1000,
+                        { { 0x1000, std::move(FirstBlock) },
+                          { 0x1010, std::move(SecondBlock) } }));
+
+  std::vector<EdgePointer> ThirdBlock;
+  ThirdBlock.push_back(callTo(0x3000));
+  Index.update(metadata(0x2000, { { 0x2020, std::move(ThirdBlock) } }));
+  Index.update(metadata(0x3000, {}));
+
+  CrossRelations Relations = Index.toCrossRelations();
+  revng_check(Relations.Relations().size() == 5);
+
+  namespace ranks = revng::ranks;
+  using yield::crossrelations::RelationTarget;
+  auto Callers = [&Relations](const std::string &Location) {
+    std::set<std::pair<RelationType::Values, std::string>> Result;
+    for (const RelationTarget &Target : Relations.Relations()
+                                          .at(Location)
+                                          .Related())
+      Result.emplace(Target.Kind(), Target.Location());
+    return Result;
+  };
+
+  auto Function = [](uint64_t Entry) {
+    return pipeline::location(ranks::Function, code(Entry)).toString();
+  };
+  auto DynamicFunction = [](std::string Name) {
+    return pipeline::location(ranks::DynamicFunction, Name).toString();
+  };
+
+  std::set<std::pair<RelationType::Values, std::string>> Expected;
+  Expected = { { RelationType::IsCalledFrom, location(0x1000, 0x1000) },
+               { RelationType::IsCalledFrom, location(0x2000, 0x2020) } };
+  revng_check(Callers(Function(0x3000)) == Expected);
+
+  Expected = { { RelationType::IsDynamicallyCalledFrom,
+                 location(0x1000, 0x1010) } };
+  revng_check(Callers(DynamicFunction("abort")) == Expected);
+
+  revng_check(Callers(Function(0x1000)).empty());
+  revng_check(Callers(Function(0x2000)).empty());
+  revng_check(Callers(DynamicFunction("puts")).empty());
+}
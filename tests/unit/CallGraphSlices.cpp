@@ -0,0 +1,106 @@
+/// \file CallGraphSlices.cpp
+/// \brief Tests for the extraction of the slices of the call graph
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <map>
+#include <set>
+#include <string>
+
+#define BOOST_TEST_MODULE CallGraphSlices
+bool init_unit_test();
+#include "boost/test/unit_test.hpp"
+
+#include "revng/UnitTestHelpers/UnitTestHelpers.h"
+#include "revng/Yield/CallGraphs/CallGraphSlices.h"
+
+using yield::calls::makeCalleeTree;
+using yield::calls::makeCallerTree;
+using yield::calls::SliceIndex;
+
+static BasicBlockID address(char Name) {
+  return BasicBlockID(MetaAddress::fromPC(llvm::Triple::x86_64, Name));
+}
+
+/// Build a call graph with a node for each letter in \p Names and an edge for
+/// each pair of letters in \p Edges
+static yield::Graph makeGraph(llvm::StringRef Names,
+                              std::vector<llvm::StringRef> Edges) {
+  yield::Graph Result;
+  std::map<char, yield::Graph::Node *> Nodes;
+  for (char Name : Names)
+    Nodes[Name] = Result.addNode(address(Name));
+  for (llvm::StringRef Edge : Edges)
+    Nodes.at(Edge[0])->addSuccessor(Nodes.at(Edge[1]));
+  return Result;
+}
+
+/// Describe the edges of \p Slice as pairs of letters, where the fake nodes
+/// referencing a tree are marked by a quote
+static std::multiset<std::string> describe(const yield::Graph &Slice) {
+  auto Name = [](const yield::Graph::Node *Node) {
+    std::string Result(1, static_cast<char>(Node->Address.start().address()));
+    if (Node->NextAddress == Node->Address)
+      Result += "'";
+    return Result;
+  };
+
+  std::multiset<std::string> Result;
+  for (const yield::Graph::Node *From : Slice.nodes())
+    for (const yield::Graph::Node *To : From->successors())
+      Result.insert(Name(From) + Name(To));
+  return Result;
+}
+
+BOOST_AUTO_TEST_CASE(NodesHangFromTheirHighestRankedCaller) {
+  auto Graph = makeGraph("ABCD", { "AB", "AC", "BC", "CD" });
+  SliceIndex Index(Graph);
+
+  // C is reachable from A through B, hence it's attached to B
+  auto Slice = makeCalleeTree(Index, address('A'));
+  revng_check(Slice.size() == 5);
+  revng_check(Slice.getEntryNode()->Address == address('A'));
+  std::multiset<std::string> Expected = { "AB", "AC'", "BC", "CD" };
+  revng_check(describe(Slice) == Expected);
+}
+
+BOOST_AUTO_TEST_CASE(CallerTreesFollowThePredecessors) {
+  auto Graph = makeGraph("ABCD", { "AB", "AC", "BC", "CD" });
+  SliceIndex Index(Graph);
+
+  auto Slice = makeCallerTree(Index, address('D'));
+  revng_check(Slice.size() == 5);
+  revng_check(Slice.getEntryNode()->Address == address('D'));
+  std::multiset<std::string> Expected = { "DC", "CB", "CA'", "BA" };
+  revng_check(describe(Slice) == Expected);
+}
+
+BOOST_AUTO_TEST_CASE(BackwardsEdgesBecomeReferences) {
+  auto Graph = makeGraph("ABC", { "AB", "BA", "BB", "BC" });
+  SliceIndex Index(Graph);
+
+  auto Slice = makeCalleeTree(Index, address('A'));
+  std::multiset<std::string> Expected = { "AB", "BA'", "BB'", "BC" };
+  revng_check(describe(Slice) == Expected);
+}
+
+BOOST_AUTO_TEST_CASE(DepthLimitOmitsFartherNodes) {
+  auto Graph = makeGraph("ABCDE", { "AB", "AC", "BC", "CD", "DE" });
+  SliceIndex Index(Graph);
+
+  // D is two calls away from A, hence it's omitted, while the slice of the
+  // remaining nodes is the same as without the limit
+  auto Slice = makeCalleeTree(Index, address('A'), 1);
+  revng_check(Slice.size() == 4);
+  std::multiset<std::string> Expected = { "AB", "AC'", "BC" };
+  revng_check(describe(Slice) == Expected);
+
+  auto Entry = makeCalleeTree(Index, address('A'), 0);
+  revng_check(Entry.size() == 1);
+  revng_check(describe(Entry).empty());
+
+  auto Unlimited = makeCalleeTree(Index, address('A'));
+  revng_check(Unlimited.size() == 6);
+}
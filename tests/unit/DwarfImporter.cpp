@@ -0,0 +1,54 @@
+/// \file DwarfImporter.cpp
+/// \brief Tests for the import of types from DWARF
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <string>
+
+#define BOOST_TEST_MODULE DwarfImporter
+bool init_unit_test();
+#include "boost/test/unit_test.hpp"
+
+#include "revng/Model/Binary.h"
+#include "revng/Model/Importer/Binary/Options.h"
+#include "revng/Model/Importer/DebugInfo/DwarfImporter.h"
+#include "revng/UnitTestHelpers/UnitTestHelpers.h"
+
+static TupleTree<model::Binary> importInput(unsigned Threads) {
+  ImporterOptions Options{ .BaseAddress = 0,
+                           .DebugInfo = DebugInfoLevel::Yes,
+                           .EnableRemoteDebugInfo = false,
+                           .AdditionalDebugInfoPaths = {},
+                           .DebugInfoThreads = Threads };
+
+  TupleTree<model::Binary> Model;
+  DwarfImporter Importer(Model);
+  Importer.import(DWARF_IMPORTER_INPUT, Options);
+  return Model;
+}
+
+static std::string serializedImport(unsigned Threads) {
+  std::string Result;
+  importInput(Threads).serialize(Result);
+  return Result;
+}
+
+BOOST_AUTO_TEST_CASE(ImportDoesNotDependOnThreads) {
+  std::string OneThread = serializedImport(1);
+  revng_check(OneThread == serializedImport(2));
+  revng_check(OneThread == serializedImport(8));
+}
+
+BOOST_AUTO_TEST_CASE(ImportIsReproducible) {
+  TupleTree<model::Binary> Model = importInput(4);
+
+  // The input has three compile units, each with its own named types
+  revng_check(Model->Types().size() > 3);
+  revng_check(Model->Functions().size() > 0);
+
+  std::string Serialized;
+  Model.serialize(Serialized);
+  revng_check(Serialized == serializedImport(4));
+}
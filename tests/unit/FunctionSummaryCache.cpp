@@ -0,0 +1,140 @@
+/// \file FunctionSummaryCache.cpp
+/// \brief Tests for the cache of the summaries computed by DetectABI
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#define BOOST_TEST_MODULE FunctionSummaryCache
+bool init_unit_test();
+#include "boost/test/unit_test.hpp"
+
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+
+#include "revng/EarlyFunctionAnalysis/FunctionSummaryCache.h"
+#include "revng/Model/Binary.h"
+#include "revng/Support/IRHelpers.h"
+#include "revng/UnitTestHelpers/UnitTestHelpers.h"
+
+using namespace llvm;
+
+using efa::CachedFunctionSummary;
+using efa::FunctionSummaryCache;
+using efa::FunctionSummaryOracle;
+
+static MetaAddress code(uint64_t Address) {
+  return MetaAddress::fromPC(Triple::x86_64, Address);
+}
+
+struct Fixture {
+  LLVMContext Context;
+  Module M{ "test", Context };
+  TupleTree<model::Binary> Binary;
+  FunctionSummaryOracle Oracle;
+
+  Fixture() {
+    Binary->Architecture() = model::Architecture::x86_64;
+    Binary->Functions()[code(0x1000)];
+    Binary->Functions()[code(0x2000)];
+    Binary->Functions()[code(0x3000)];
+  }
+
+  uint64_t inputsHash(MetaAddress Entry) const {
+    uint64_t ModuleHash = FunctionSummaryCache::computeModuleHash(M, *Binary);
+    const model::Function &Function = Binary->Functions().at(Entry);
+    return FunctionSummaryCache::computeInputsHash(Function, ModuleHash);
+  }
+
+  void record(FunctionSummaryCache &Cache, MetaAddress Entry) const {
+    CachedFunctionSummary Summary;
+    Summary.InputsHash = inputsHash(Entry);
+    Summary.ElectedFSO = 8;
+    Cache.record(Entry, std::move(Summary));
+  }
+
+  bool isCached(const FunctionSummaryCache &Cache, MetaAddress Entry) const {
+    return Cache.get(Entry, inputsHash(Entry), Oracle) != nullptr;
+  }
+};
+
+BOOST_FIXTURE_TEST_CASE(UnchangedFunctionIsReused, Fixture) {
+  FunctionSummaryCache Cache(16);
+  record(Cache, code(0x1000));
+
+  const CachedFunctionSummary *Hit = Cache.get(code(0x1000),
+                                               inputsHash(code(0x1000)),
+                                               Oracle);
+  revng_check(Hit != nullptr);
+  revng_check(Hit->ElectedFSO == 8);
+  revng_check(not isCached(Cache, code(0x2000)));
+}
+
+BOOST_FIXTURE_TEST_CASE(ChangingTheFunctionInvalidates, Fixture) {
+  FunctionSummaryCache Cache(16);
+  record(Cache, code(0x1000));
+  record(Cache, code(0x2000));
+
+  using namespace model::FunctionAttribute;
+  Binary->Functions().at(code(0x1000)).Attributes().insert(NoReturn);
+
+  revng_check(not isCached(Cache, code(0x1000)));
+  revng_check(isCached(Cache, code(0x2000)));
+}
+
+BOOST_FIXTURE_TEST_CASE(ChangingTheHelpersInvalidates, Fixture) {
+  FunctionSummaryCache Cache(16);
+  record(Cache, code(0x1000));
+
+  // Declarations which are not helpers are ignored
+  auto *VoidFunction = FunctionType::get(Type::getVoidTy(Context), false);
+  M.getOrInsertFunction("not_a_helper", VoidFunction);
+  revng_check(isCached(Cache, code(0x1000)));
+
+  auto *Helper = Function::Create(VoidFunction,
+                                  GlobalValue::ExternalLinkage,
+                                  "helper_raise",
+                                  &M);
+  FunctionTags::Helper.addTo(Helper);
+  revng_check(not isCached(Cache, code(0x1000)));
+}
+
+BOOST_FIXTURE_TEST_CASE(ChangingTheSegmentsContentsInvalidates, Fixture) {
+  QuickMetadata QMD(Context);
+  auto *SegmentsHashMD = M.getOrInsertNamedMetadata(SegmentsHashName);
+  SegmentsHashMD->addOperand(QMD.tuple(static_cast<uint64_t>(1)));
+
+  FunctionSummaryCache Cache(16);
+  record(Cache, code(0x1000));
+  revng_check(isCached(Cache, code(0x1000)));
+
+  // Same model, different binary
+  SegmentsHashMD->clearOperands();
+  SegmentsHashMD->addOperand(QMD.tuple(static_cast<uint64_t>(2)));
+  revng_check(not isCached(Cache, code(0x1000)));
+}
+
+BOOST_FIXTURE_TEST_CASE(LeastRecentlyUsedIsEvicted, Fixture) {
+  FunctionSummaryCache Cache(2);
+  record(Cache, code(0x1000));
+  record(Cache, code(0x2000));
+
+  // Use the first function, so that the second one is evicted
+  revng_check(isCached(Cache, code(0x1000)));
+  record(Cache, code(0x3000));
+
+  revng_check(Cache.size() == 2);
+  revng_check(isCached(Cache, code(0x1000)));
+  revng_check(not isCached(Cache, code(0x2000)));
+  revng_check(isCached(Cache, code(0x3000)));
+}
+
+BOOST_FIXTURE_TEST_CASE(UnknownDynamicFunctionsBehaveAsTheDefault, Fixture) {
+  BasicBlockID CallSite(code(0x1010));
+  auto [Summary, IsTailCall] = Oracle.getCallSite(code(0x1000),
+                                                  CallSite,
+                                                  MetaAddress::invalid(),
+                                                  "unknown");
+  revng_check(Summary == &Oracle.getDefault());
+  revng_check(not IsTailCall);
+}
@@ -492,3 +492,38 @@ BOOST_AUTO_TEST_CASE(MutableEdgeNodeRemovalTest) {
   revng_check(C->successorCount() == 0);
   revng_check(C->predecessorCount() == 1);
 }
+
+BOOST_AUTO_TEST_CASE(ArenaAllocationTest) {
+  using Graph = GenericGraph<MutableEdgeNode<std::string, double>>;
+  Graph Source(GraphAllocation::Arena);
+  auto *A = Source.addNode("A");
+  auto *B = Source.addNode("B");
+  auto *C = Source.addNode(std::make_unique<Graph::Node>("C"));
+  A->addSuccessor(B, 1.0);
+  A->addSuccessor(C, 2.0);
+  C->addSuccessor(A, 3.0);
+
+  // Moving the graph must preserve both the nodes and the arena of the labels
+  Graph Moved = std::move(Source);
+  auto *D = Moved.addNode("D");
+  D->addSuccessor(A, 4.0);
+  B->addSuccessor(D, 5.0);
+  revng_check(Moved.size() == 4);
+  revng_check(A->predecessorCount() == 2 && D->successorCount() == 1);
+
+  double Sum = 0;
+  for (auto *Node : Moved.nodes())
+    for (auto [Neighbor, Label] : Node->successor_edges())
+      Sum += *Label;
+  revng_check(Sum == 15.0);
+
+  Moved.removeNode(A);
+  revng_check(B->predecessorCount() == 0 && C->successorCount() == 0);
+  revng_check(D->successorCount() == 0 && B->successorCount() == 1);
+
+  // The arena can be reused after clearing the graph
+  Moved.clear();
+  auto *E = Moved.addNode("E");
+  E->addSuccessor(E, 6.0);
+  revng_check(E->hasSuccessor(E) && E->hasPredecessor(E));
+}
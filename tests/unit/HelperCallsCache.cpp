@@ -0,0 +1,68 @@
+/// \file HelperCallsCache.cpp
+/// \brief Tests for the cache of the accesses of the calls to helpers
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#define BOOST_TEST_MODULE HelperCallsCache
+bool init_unit_test();
+#include "boost/test/unit_test.hpp"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+
+#include "revng/UnitTestHelpers/UnitTestHelpers.h"
+
+#include "lib/Lift/HelperCallsCache.h"
+
+using namespace llvm;
+
+using Accesses = HelperCallsCache::Accesses;
+
+static bool isSame(const CSVOffsets &LHS, const CSVOffsets &RHS) {
+  return LHS.getKind() == RHS.getKind()
+         and std::equal(LHS.begin(), LHS.end(), RHS.begin(), RHS.end());
+}
+
+BOOST_AUTO_TEST_CASE(RoundTrip) {
+  SmallString<128> Directory;
+  revng_check(not sys::fs::createUniqueDirectory("helper-calls-cache",
+                                                 Directory));
+  SmallString<128> Path(Directory);
+  sys::path::append(Path, HelperCallsCache::getFileName("0123abcd"));
+
+  CSVOffsets::OffsetSet Offsets = { 16, -8, 128 };
+  Accesses Known{ CSVOffsets(CSVOffsets::OutAndKnownInPtr, Offsets),
+                  CSVOffsets(CSVOffsets::KnownInPtr) };
+  Accesses Unknown{ CSVOffsets(CSVOffsets::UnknownInPtr),
+                    CSVOffsets(CSVOffsets::OutAndUnknownInPtr) };
+
+  {
+    HelperCallsCache Cache(Path.str().str());
+    revng_check(not Cache.find("helper_a(&env,i32 1)").has_value());
+    Cache.record("helper_a(&env,i32 1)", Accesses(Known));
+    Cache.record("helper_b(env,null)", Accesses(Unknown));
+    Cache.save();
+  }
+
+  HelperCallsCache Reloaded(Path.str().str());
+  auto A = Reloaded.find("helper_a(&env,i32 1)");
+  auto B = Reloaded.find("helper_b(env,null)");
+  revng_check(A.has_value() and B.has_value());
+  revng_check(isSame(A->Load, Known.Load));
+  revng_check(isSame(A->Store, Known.Store));
+  revng_check(isSame(B->Load, Unknown.Load));
+  revng_check(isSame(B->Store, Unknown.Store));
+  revng_check(not Reloaded.find("helper_c()").has_value());
+
+  revng_check(not sys::fs::remove_directories(Directory));
+}
+
+BOOST_AUTO_TEST_CASE(FileNameDependsOnVersion) {
+  std::string FileName = HelperCallsCache::getFileName("0123abcd");
+  std::string Version = "v" + std::to_string(HelperCallsCache::Version) + "-";
+  revng_check(StringRef(FileName).startswith(Version));
+  revng_check(StringRef(FileName).contains("0123abcd"));
+}
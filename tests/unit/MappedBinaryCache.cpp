@@ -0,0 +1,130 @@
+/// \file MappedBinaryCache.cpp
+/// \brief Tests for the cache of the memory-mapped input binaries
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <chrono>
+
+#define BOOST_TEST_MODULE MappedBinaryCache
+bool init_unit_test();
+#include "boost/test/unit_test.hpp"
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "revng/Pipes/MappedBinaryCache.h"
+#include "revng/UnitTestHelpers/UnitTestHelpers.h"
+
+using namespace llvm;
+
+using revng::pipes::MappedBinaryCache;
+
+/// A file in a temporary directory, removed at the end of the test
+struct Fixture {
+  SmallString<128> Directory;
+  SmallString<128> Path;
+
+  Fixture() {
+    revng_check(not sys::fs::createUniqueDirectory("mapped-binary-cache",
+                                                   Directory));
+    Path = Directory;
+    sys::path::append(Path, "binary");
+  }
+
+  ~Fixture() { revng_check(not sys::fs::remove_directories(Directory)); }
+
+  void write(StringRef Contents) const {
+    std::error_code EC;
+    raw_fd_ostream Stream(Path, EC);
+    revng_check(not EC);
+    Stream << Contents;
+  }
+
+  sys::TimePoint<> lastModification() const {
+    sys::fs::file_status Status;
+    revng_check(not sys::fs::status(Path, Status));
+    return Status.getLastModificationTime();
+  }
+
+  void setLastModification(sys::TimePoint<> Time) const {
+    int FD = -1;
+    revng_check(not sys::fs::openFileForWrite(Path,
+                                              FD,
+                                              sys::fs::CD_OpenExisting));
+    revng_check(not sys::fs::setLastAccessAndModificationTime(FD, Time));
+    revng_check(not sys::Process::SafelyCloseFileDescriptor(FD));
+  }
+
+  MappedBinaryCache::Buffer get(MappedBinaryCache &Cache) const {
+    return cantFail(Cache.get(Path));
+  }
+};
+
+BOOST_FIXTURE_TEST_CASE(UnchangedFileIsReused, Fixture) {
+  write("binary contents");
+
+  MappedBinaryCache Cache;
+  auto First = get(Cache);
+  auto Second = get(Cache);
+  revng_check(First.get() == Second.get());
+  revng_check(Second->getBuffer() == "binary contents");
+
+  // Clearing the cache forces the file to be mapped again
+  Cache.clear();
+  revng_check(get(Cache).get() != First.get());
+}
+
+BOOST_FIXTURE_TEST_CASE(ModificationTimeChangeInvalidates, Fixture) {
+  write("binary contents");
+
+  MappedBinaryCache Cache;
+  auto Old = get(Cache);
+  sys::TimePoint<> OldTime = lastModification();
+
+  // Same size, the modification time is the only difference
+  write("BINARY CONTENTS");
+  setLastModification(OldTime + std::chrono::seconds(10));
+
+  auto New = get(Cache);
+  revng_check(New.get() != Old.get());
+  revng_check(New->getBuffer() == "BINARY CONTENTS");
+
+  // The buffers handed out before the invalidation remain valid
+  revng_check(Old->getBuffer() == "binary contents");
+}
+
+BOOST_FIXTURE_TEST_CASE(SizeChangeInvalidates, Fixture) {
+  write("binary contents");
+
+  MappedBinaryCache Cache;
+  auto Old = get(Cache);
+  sys::TimePoint<> OldTime = lastModification();
+
+  // Different size, same modification time
+  write("longer binary contents");
+  setLastModification(OldTime);
+
+  auto New = get(Cache);
+  revng_check(New.get() != Old.get());
+  revng_check(New->getBuffer() == "longer binary contents");
+}
+
+BOOST_FIXTURE_TEST_CASE(MissingFileIsAnError, Fixture) {
+  MappedBinaryCache Cache;
+  auto MaybeBuffer = Cache.get(Path);
+  revng_check(not MaybeBuffer);
+  consumeError(MaybeBuffer.takeError());
+}
+
+BOOST_AUTO_TEST_CASE(NonRegularFilesAreNotCached) {
+  MappedBinaryCache Cache;
+  auto First = cantFail(Cache.get("/dev/null"));
+  auto Second = cantFail(Cache.get("/dev/null"));
+  revng_check(First->getBuffer().empty());
+  revng_check(First.get() != Second.get());
+}
@@ -10,6 +10,7 @@ bool init_unit_test();
 #include "boost/test/unit_test.hpp"
 
 #include "revng/Model/Binary.h"
+#include "revng/Model/IncrementalVerifier.h"
 #include "revng/Model/Pass/AllPasses.h"
 #include "revng/Model/Processing.h"
 #include "revng/Support/MetaAddress.h"
@@ -251,6 +252,39 @@ BOOST_AUTO_TEST_CASE(TestModelDeduplication) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(TestModelDeduplicationManyCopies) {
+  TupleTree<model::Binary> Model;
+  model::TypePath UInt8 = Model->getPrimitiveType(PrimitiveTypeKind::Generic,
+                                                  4);
+  auto PointerQualifier = Qualifier::createPointer(8);
+
+  // Create many copies of the same pair of cross-referencing structs, half of
+  // which differ only in the qualifiers of a typedef reachable from the cycle
+  constexpr unsigned Copies = 100;
+  for (unsigned I = 0; I < Copies; ++I) {
+    auto *Typedef = createType<TypedefType>(*Model);
+    Typedef->OriginalName() = "Leaf";
+    Typedef->UnderlyingType() = { UInt8, {} };
+    if (I % 2 == 0)
+      Typedef->UnderlyingType().Qualifiers().push_back(PointerQualifier);
+
+    auto *Left = createType<StructType>(*Model);
+    auto *Right = createType<StructType>(*Model);
+    Left->OriginalName() = "Left";
+    Right->OriginalName() = "Right";
+
+    Left->Fields()[0].Type() = { Model->getTypePath(Right),
+                                 { PointerQualifier } };
+    Right->Fields()[0].Type() = { Model->getTypePath(Left),
+                                  { PointerQualifier } };
+    Right->Fields()[8].Type() = { Model->getTypePath(Typedef), {} };
+  }
+
+  auto OldTypesCount = Model->Types().size();
+  deduplicateEquivalentTypes(Model);
+  revng_check(OldTypesCount - Model->Types().size() == 3 * (Copies - 2));
+}
+
 BOOST_AUTO_TEST_CASE(TestTupleTreeDiff) {
   model::Binary Left;
   model::Binary Right;
@@ -292,6 +326,153 @@ BOOST_AUTO_TEST_CASE(TestTupleTreeDiffDeserialization) {
   BOOST_TEST(S == S2);
 }
 
+BOOST_AUTO_TEST_CASE(TestTupleTreeDiffCachedHashes) {
+  TupleTree<model::Binary> Model;
+  for (uint64_t I = 0; I < 1000; ++I) {
+    MetaAddress Address(0x1000 + I * 0x10, MetaAddressType::Code_aarch64);
+    model::Function &F = Model->Functions()[Address];
+    F.CustomName() = ("function_" + llvm::Twine(I)).str();
+    F.ExportedNames().insert(F.CustomName().str().str());
+  }
+
+  auto Mutate = [](model::Binary &Binary) {
+    MetaAddress Address(0x1000, MetaAddressType::Code_aarch64);
+    Binary.Functions()[Address].CustomName() = "renamed";
+    Binary.ExtraCodeAddresses().insert(Address);
+  };
+
+  // Compute the expected diff without cached hashes
+  model::Binary Expected = *Model;
+  Mutate(Expected);
+  auto ExpectedDiff = diff(*Model, Expected);
+
+  // Now cache the hashes, which are shared by the copies
+  Model.cacheHashes();
+  TupleTree<model::Binary> Unchanged = Model;
+  BOOST_TEST(not Unchanged->cachedFunctionsHash().empty());
+  BOOST_TEST(diff(*Model, *Unchanged).Changes.empty());
+
+  TupleTree<model::Binary> Changed = Model;
+  Mutate(*Changed);
+  auto Diff = diff(*Model, *Changed);
+  BOOST_TEST(Diff.Changes.size() == ExpectedDiff.Changes.size());
+  BOOST_TEST(serializeToString(Diff) == serializeToString(ExpectedDiff));
+
+  // Hashing the changed tree must not hide the changes
+  Changed.cacheHashes();
+  Diff = diff(*Model, *Changed);
+  BOOST_TEST(serializeToString(Diff) == serializeToString(ExpectedDiff));
+}
+
+BOOST_AUTO_TEST_CASE(TestTupleTreeDiffStaleCachedHashes) {
+  TupleTree<model::Binary> Model;
+  MetaAddress Address(0x1000, MetaAddressType::Code_aarch64);
+  Model->Functions()[Address].CustomName() = "original";
+
+  // Take a reference through a non-const accessor before hashing
+  model::Function &Function = Model->Functions()[Address];
+  TupleTree<model::Binary> Old = Model;
+  Model.cacheHashes();
+  Old.cacheHashes();
+
+  // Changing the function through it leaves a stale hash of Functions behind
+  Function.CustomName() = "renamed";
+  constexpr auto FunctionsField = TupleLikeTraits<Binary>::Fields::Functions;
+  constexpr auto FunctionsIndex = static_cast<size_t>(FunctionsField);
+  BOOST_TEST(isCachedFieldHashStale<FunctionsIndex>(*Model));
+
+  // The diff must not trust the stale hash
+  auto Diff = diff(*Old, *Model);
+  BOOST_TEST(Diff.Changes.size() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(TestTupleTreeDiffApply) {
+  TupleTree<model::Binary> Old;
+  for (uint64_t I = 0; I < 100; ++I) {
+    MetaAddress Address(0x1000 + I * 0x10, MetaAddressType::Code_aarch64);
+    Old->Functions()[Address].CustomName() = ("f_" + llvm::Twine(I)).str();
+  }
+
+  // Remove and add many functions, rename one and reference a new type
+  TupleTree<model::Binary> New = Old;
+  for (uint64_t I = 0; I < 100; I += 3) {
+    MetaAddress Address(0x1000 + I * 0x10, MetaAddressType::Code_aarch64);
+    New->Functions().erase(Address);
+    MetaAddress NewAddress(0x8000 + I * 0x10, MetaAddressType::Code_aarch64);
+    New->Functions()[NewAddress].CustomName() = ("g_" + llvm::Twine(I)).str();
+  }
+  MetaAddress Renamed(0x1010, MetaAddressType::Code_aarch64);
+  New->Functions()[Renamed].CustomName() = "renamed";
+  auto Prototype = New->getPrimitiveType(PrimitiveTypeKind::Generic, 8);
+  New->Functions()[Renamed].Prototype() = Prototype;
+
+  auto Diff = diff(*Old, *New);
+  BOOST_TEST(not llvm::errorToBool(Diff.apply(Old)));
+  BOOST_TEST(serializeToString(*Old) == serializeToString(*New));
+  BOOST_TEST(Old.verify());
+  BOOST_TEST(Old->Functions().at(Renamed).Prototype().getRoot() == Old.get());
+}
+
+BOOST_AUTO_TEST_CASE(TestTupleTreeDiffApplyDuplicateAddition) {
+  TupleTree<model::Binary> Empty;
+  TupleTree<model::Binary> New;
+  New->Functions()[ARM1000].CustomName() = "added";
+
+  auto Diff = diff(*Empty, *New);
+  BOOST_TEST(Diff.Changes.size() == 1);
+  Diff.Changes.push_back(Diff.Changes[0]);
+
+  BOOST_TEST(llvm::errorToBool(Diff.apply(Empty)));
+  BOOST_TEST(Empty->Functions().size() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(TestTupleTreeDiffApplyCachedReferences) {
+  TupleTree<model::Binary> Old;
+  MetaAddress Other(0x2000, MetaAddressType::Code_aarch64);
+  auto Prototype = Old->getPrimitiveType(PrimitiveTypeKind::Generic, 8);
+  Old->Functions()[ARM1000].Prototype() = Prototype;
+  Old->Functions()[Other].CustomName() = "removed";
+
+  TupleTree<model::Binary> New = Old;
+  New->Functions().erase(Other);
+
+  auto Diff = diff(*Old, *New);
+  Old.cacheReferences();
+  BOOST_TEST(not llvm::errorToBool(Diff.apply(Old)));
+  BOOST_TEST(not Old.referencesAreCached());
+  BOOST_TEST(serializeToString(*Old) == serializeToString(*New));
+  BOOST_TEST(Old.verify());
+}
+
+BOOST_AUTO_TEST_CASE(TestIncrementalVerification) {
+  model::Binary Old;
+  Old.Functions()[ARM1000].CustomName() = "first";
+  Old.Functions()[ARM2000].CustomName() = "second";
+
+  model::IncrementalVerifier Verifier;
+  BOOST_TEST(Verifier.verify(Old));
+
+  // Rename a function
+  model::Binary Renamed = Old;
+  Renamed.Functions()[ARM2000].CustomName() = "third";
+  BOOST_TEST(Verifier.verify(Renamed, diff(Old, Renamed)));
+
+  // Add a function with a name clashing with an existing one
+  model::Binary Clashing = Renamed;
+  Clashing.Functions()[ARM3000].CustomName() = "first";
+  BOOST_TEST(not Clashing.verify());
+  BOOST_TEST(not Verifier.verify(Clashing, diff(Renamed, Clashing)));
+
+  // After a failure, the verifier falls back to a full verification
+  BOOST_TEST(Verifier.verify(Renamed, diff(Clashing, Renamed)));
+
+  // A name freed by a rename can be reused in the same diff
+  model::Binary Swapped = Renamed;
+  Swapped.Functions()[ARM1000].CustomName() = "third";
+  Swapped.Functions()[ARM2000].CustomName() = "first";
+  BOOST_TEST(Verifier.verify(Swapped, diff(Renamed, Swapped)));
+}
+
 BOOST_AUTO_TEST_CASE(CABIFunctionTypePathShouldParse) {
   const char *Path = "/Types/CABIFunctionType-10000";
   auto MaybeParsed = stringAsPath<model::Binary>(Path);
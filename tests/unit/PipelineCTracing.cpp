@@ -117,4 +117,64 @@ BOOST_AUTO_TEST_CASE(PipelineCTraceTest) {
   verifyTrace(Trace2);
 }
 
+BOOST_AUTO_TEST_CASE(PipelineCBinaryTraceTest) {
+  using tracing::BinaryTraceReader;
+  llvm::ExitOnError AbortOnError;
+  std::string Buffer;
+
+  {
+    llvm::raw_string_ostream OS(Buffer);
+    tracing::setTracing(&OS, tracing::TraceFormat::Binary);
+
+    rp_manager *Manager = rp_manager_create(0, {}, "");
+    uint64_t StepCount = rp_manager_steps_count(Manager);
+    for (uint64_t I = 0; I < StepCount; I++) {
+      rp_manager_get_step(Manager, I);
+    }
+
+    rp_manager_destroy(Manager);
+
+    tracing::setTracing(nullptr);
+  }
+
+  BOOST_TEST(tracing::binary::isBinaryTrace(Buffer));
+  auto MemoryBuffer = llvm::MemoryBuffer::getMemBuffer(Buffer);
+
+  auto Trace = AbortOnError(tracing::Trace::fromBuffer(*MemoryBuffer));
+  verifyTrace(Trace);
+
+  // Replay the binary trace as a stream
+  std::string Buffer2;
+  {
+    auto Reader = AbortOnError(BinaryTraceReader::fromBuffer(*MemoryBuffer));
+    llvm::raw_string_ostream OS(Buffer2);
+    tracing::setTracing(&OS);
+
+    AbortOnError(tracing::run(*Reader));
+
+    tracing::setTracing(nullptr);
+  }
+
+  auto MemoryBuffer2 = llvm::MemoryBuffer::getMemBuffer(Buffer2);
+  auto Trace2 = AbortOnError(tracing::Trace::fromBuffer(*MemoryBuffer2));
+  verifyTrace(Trace2);
+
+  // Convert the binary trace to YAML
+  std::string YAMLBuffer;
+  {
+    auto Reader = AbortOnError(BinaryTraceReader::fromBuffer(*MemoryBuffer));
+    llvm::raw_string_ostream OS(YAMLBuffer);
+    AbortOnError(tracing::writeYAML(*Reader, OS));
+  }
+
+  auto YAMLMemoryBuffer = llvm::MemoryBuffer::getMemBuffer(YAMLBuffer);
+  auto Converted = AbortOnError(tracing::Trace::fromBuffer(*YAMLMemoryBuffer));
+  verifyTrace(Converted);
+
+  for (size_t I = 0; I < Trace.Commands.size(); I++) {
+    BOOST_TEST(Converted.Commands[I].Result == Trace.Commands[I].Result);
+    BOOST_TEST(Converted.Commands[I].EndTime == Trace.Commands[I].EndTime);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
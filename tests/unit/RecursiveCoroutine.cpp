@@ -6,6 +6,7 @@
 #include <coroutine>
 #include <functional>
 #include <iostream>
+#include <memory>
 #include <vector>
 
 // TODO: increase height up to explosion
@@ -20,6 +21,12 @@
 size_t MaxDepth = 0;
 size_t Iterations = 0;
 
+static RecursiveCoroutine<size_t> countDown(size_t Depth) {
+  if (Depth == 0)
+    rc_return 0;
+  rc_return 1 + rc_recur countDown(Depth - 1);
+}
+
 int main() {
 
   //
@@ -142,5 +149,36 @@ int main() {
   std::cout << "Result: " << Result << std::endl;
   revng_check(Result == 28);
 
+  //
+  // Coroutines destroyed in a different order than they were created in
+  //
+  {
+    using Coroutine = RecursiveCoroutine<size_t>;
+    std::unique_ptr<Coroutine> First(new Coroutine(countDown(3)));
+    std::unique_ptr<Coroutine> Second(new Coroutine(countDown(5)));
+    First.reset();
+    revng_check(size_t(*Second) == 5);
+    std::unique_ptr<Coroutine> Third(new Coroutine(countDown(7)));
+    Second.reset();
+    revng_check(size_t(*Third) == 7);
+  }
+
+  //
+  // Deep recursion, compare with test_recursive_coroutines_heap_frames to
+  // measure the effect of the frame arena
+  //
+  const us DeepRepeat = 50;
+  const size_t Depth = 20000;
+  Average = 0LL;
+  for (us I = 0; I < DeepRepeat; I++) {
+    auto Start = high_resolution_clock::now();
+    size_t Count = countDown(Depth);
+    auto End = high_resolution_clock::now();
+    revng_check(Count == Depth);
+    Average += duration_cast<microseconds>(End - Start).count() / DeepRepeat;
+  }
+
+  std::cout << "Deep recursion average: " << Average << std::endl;
+
   return 0;
 }
@@ -0,0 +1,174 @@
+/// \file TagWriter.cpp
+/// \brief Tests for the streaming emission of PTML tags
+
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#define BOOST_TEST_MODULE TagWriter
+bool init_unit_test();
+#include "boost/test/unit_test.hpp"
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "revng/PTML/Constants.h"
+#include "revng/PTML/Tag.h"
+#include "revng/PTML/TagWriter.h"
+#include "revng/UnitTestHelpers/UnitTestHelpers.h"
+
+using ptml::Tag;
+using ptml::TagWriter;
+
+namespace attributes = ptml::attributes;
+namespace tags = ptml::tags;
+
+/// Sort the attributes of the opening tags in \p Markup: ptml::Tag does not
+/// preserve the order in which they are added, TagWriter does.
+///
+/// \note Attribute values must not contain spaces
+static std::string normalize(llvm::StringRef Markup) {
+  std::string Result;
+  while (not Markup.empty()) {
+    size_t Open = Markup.find('<');
+    Result += Markup.substr(0, Open).str();
+    if (Open == llvm::StringRef::npos)
+      break;
+
+    size_t Close = Markup.find('>', Open);
+    revng_check(Close != llvm::StringRef::npos);
+    llvm::StringRef Inside = Markup.slice(Open + 1, Close);
+    Markup = Markup.drop_front(Close + 1);
+
+    llvm::SmallVector<llvm::StringRef, 4> Parts;
+    Inside.split(Parts, ' ');
+    std::sort(Parts.begin() + 1, Parts.end());
+    Result += "<" + llvm::join(Parts, " ") + ">";
+  }
+  return Result;
+}
+
+BOOST_AUTO_TEST_CASE(EmitMatchesSerialize) {
+  std::string Expected = Tag(tags::Span, "  ")
+                           .addAttribute(attributes::Token, "indentation")
+                           .serialize();
+
+  std::string Actual;
+  {
+    llvm::raw_string_ostream OS(Actual);
+    TagWriter Writer(OS);
+    Writer.tag(tags::Span)
+      .addAttribute(attributes::Token, "indentation")
+      .emit("  ");
+  }
+  revng_check(Actual == Expected);
+
+  // Tags without attributes nor content
+  std::string Empty;
+  {
+    llvm::raw_string_ostream OS(Empty);
+    TagWriter Writer(OS);
+    Writer.tag(tags::Div).emit();
+  }
+  revng_check(Empty == Tag(tags::Div).serialize());
+}
+
+BOOST_AUTO_TEST_CASE(EmitMatchesSerializeWithManyAttributes) {
+  std::string Location = "/function/0x1000:Code_x86_64";
+  std::string Expected = Tag(tags::Span, "foo")
+                           .addAttribute(attributes::Token, "function")
+                           .addAttribute(attributes::LocationDefinition,
+                                         Location)
+                           .addAttribute(attributes::LocationReferences,
+                                         Location)
+                           .serialize();
+
+  std::string Actual;
+  {
+    llvm::raw_string_ostream OS(Actual);
+    TagWriter Writer(OS);
+
+    // Temporary values are copied into the writer
+    Writer.tag(tags::Span)
+      .addAttribute(attributes::Token, "function")
+      .addAttribute(attributes::LocationDefinition, Location)
+      .addAttribute(attributes::LocationReferences, std::string(Location))
+      .emit("foo");
+  }
+  revng_check(normalize(Actual) == normalize(Expected));
+}
+
+BOOST_AUTO_TEST_CASE(ScopeMatchesScopeTag) {
+  for (bool Newline : { false, true }) {
+    std::string Expected;
+    {
+      llvm::raw_string_ostream OS(Expected);
+      auto Outer = Tag(tags::Div)
+                     .addAttribute(attributes::Scope, "function")
+                     .scope(OS, Newline);
+      OS << "body";
+      {
+        auto Inner = Tag(tags::Span).scope(OS);
+        OS << "nested";
+      }
+    }
+
+    std::string Actual;
+    {
+      llvm::raw_string_ostream OS(Actual);
+      TagWriter Writer(OS);
+      auto Outer = Writer.tag(tags::Div)
+                     .addAttribute(attributes::Scope, "function")
+                     .scope(Newline);
+      OS << "body";
+      {
+        auto Inner = Writer.tag(tags::Span).scope();
+        OS << "nested";
+      }
+    }
+
+    revng_check(Actual == Expected);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ListAttributesMatchTag) {
+  std::vector<std::string> Values = { "/a/1", "/b/2", "/c/3" };
+  std::string Expected = Tag(tags::Div)
+                           .addListAttribute(attributes::LocationReferences,
+                                             Values)
+                           .addListAttribute(attributes::LocationDefinition,
+                                             "/d/4",
+                                             "/e/5")
+                           .serialize();
+
+  std::string Actual;
+  {
+    llvm::raw_string_ostream OS(Actual);
+    TagWriter Writer(OS);
+    Writer.tag(tags::Div)
+      .addListAttribute(attributes::LocationReferences, Values)
+      .addListAttribute(attributes::LocationDefinition, "/d/4", "/e/5")
+      .emit();
+  }
+  revng_check(normalize(Actual) == normalize(Expected));
+
+  // A list with a single element is a plain attribute
+  std::string Single;
+  {
+    llvm::raw_string_ostream OS(Single);
+    TagWriter Writer(OS);
+    Writer.tag(tags::Div)
+      .addListAttribute(attributes::LocationReferences, "/d/4")
+      .emit();
+  }
+  std::string SingleExpected = Tag(tags::Div)
+                                 .addAttribute(attributes::LocationReferences,
+                                               "/d/4")
+                                 .serialize();
+  revng_check(Single == SingleExpected);
+}
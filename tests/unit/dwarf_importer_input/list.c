@@ -0,0 +1,17 @@
+/*
+ * This file is distributed under the MIT License. See LICENSE.md for details.
+ */
+
+struct node {
+  struct node *next;
+  int value;
+};
+
+typedef struct node node_t;
+
+int list_sum(node_t *head) {
+  int result = 0;
+  for (; head != 0; head = head->next)
+    result += head->value;
+  return result;
+}
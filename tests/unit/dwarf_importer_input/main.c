@@ -0,0 +1,20 @@
+/*
+ * This file is distributed under the MIT License. See LICENSE.md for details.
+ */
+
+typedef unsigned long size_type;
+
+struct pair {
+  size_type first;
+  const char *second;
+};
+
+typedef int (*callback)(struct pair *);
+
+int call(callback function, struct pair *argument) {
+  return function(argument);
+}
+
+int main(void) {
+  return 0;
+}
@@ -0,0 +1,36 @@
+/*
+ * This file is distributed under the MIT License. See LICENSE.md for details.
+ */
+
+/* Same name as the node of list.c, but a different type */
+struct node {
+  struct node *left;
+  struct node *right;
+  long key;
+};
+
+enum color { red, black };
+
+union payload {
+  long integer;
+  double real;
+};
+
+struct colored {
+  struct node node;
+  enum color color;
+  union payload payload;
+  char tag[4];
+};
+
+long tree_depth(struct node *root) {
+  if (root == 0)
+    return 0;
+  long left = tree_depth(root->left);
+  long right = tree_depth(root->right);
+  return 1 + (left > right ? left : right);
+}
+
+enum color colored_color(struct colored *value) {
+  return value->color;
+}
@@ -68,7 +68,7 @@ int main(int Argc, char *Argv[]) {
   TupleTree<model::Binary> Model;
   if (isa<llvm::object::ELFObjectFileBase>(&ObjectFile)) {
     DwarfImporter Importer(Model);
-    Importer.import(InputFilename, Options);
+    Importer.import(ObjectFile, Options);
   } else if (auto *TheBinary = dyn_cast<object::COFFObjectFile>(&ObjectFile)) {
     MetaAddress ImageBase = MetaAddress::invalid();
     auto LLVMArchitecture = ObjectFile.makeTriple().getArch();
@@ -0,0 +1,63 @@
+//
+// This file is distributed under the MIT License. See LICENSE.md for details.
+//
+
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/ToolOutputFile.h"
+
+#include "revng/PipelineC/Tracing/Trace.h"
+#include "revng/Support/CommandLine.h"
+#include "revng/Support/InitRevng.h"
+
+using revng::tracing::BinaryTraceReader;
+
+namespace Options {
+using namespace llvm::cl;
+using std::string;
+
+static OptionCategory ThisToolCategory("Tool options", "");
+
+static opt<string> Input(Positional,
+                         Required,
+                         cat(ThisToolCategory),
+                         desc("<input binary trace file>"),
+                         value_desc("input binary trace file"));
+
+static opt<string> Output("output",
+                          cat(ThisToolCategory),
+                          desc("Output YAML trace file"),
+                          value_desc("file"),
+                          init("-"));
+
+static alias OutputA("o",
+                     cat(ThisToolCategory),
+                     desc("Alias for --output"),
+                     aliasopt(Output));
+} // namespace Options
+
+static llvm::ExitOnError AbortOnError;
+
+int main(int argc, const char *argv[]) {
+  revng::InitRevng X(argc, argv);
+
+  llvm::cl::HideUnrelatedOptions({ &Options::ThisToolCategory });
+  llvm::cl::ParseCommandLineOptions(argc, argv);
+
+  auto Reader = AbortOnError(BinaryTraceReader::fromFile(Options::Input));
+
+  std::error_code EC;
+  llvm::ToolOutputFile OutputFile(Options::Output,
+                                  EC,
+                                  llvm::sys::fs::OF_Text);
+  if (EC) {
+    dbg << "Unable to open output file: " << EC.message() << "\n";
+    return EXIT_FAILURE;
+  }
+
+  AbortOnError(revng::tracing::writeYAML(*Reader, OutputFile.os()));
+  OutputFile.keep();
+
+  return EXIT_SUCCESS;
+}
@@ -13,7 +13,6 @@
 #include "revng/Support/Assert.h"
 #include "revng/Support/CommandLine.h"
 
-using revng::tracing::Trace;
 static llvm::ExitOnError AbortOnError;
 
 namespace Options {
@@ -90,8 +89,6 @@ int main(int argc, const char *argv[]) {
   llvm::cl::HideUnrelatedOptions(Options::TraceRunToolCategory);
   rp_initialize(argc, argv, 0, {});
 
-  Trace TheTrace = AbortOnError(Trace::fromFile(Options::TraceFile));
-
   std::string TemporaryRoot;
   if (Options::TemporaryRoot.Set) {
     if (Options::TemporaryRoot.String.empty()) {
@@ -109,7 +106,7 @@ int main(int argc, const char *argv[]) {
     .BreakAt = { Options::BreakAt.begin(), Options::BreakAt.end() },
     .TemporaryRoot = TemporaryRoot,
   };
-  AbortOnError(TheTrace.run(Options));
+  AbortOnError(revng::tracing::runFile(Options::TraceFile, Options));
 
   rp_shutdown();
   return EXIT_SUCCESS;